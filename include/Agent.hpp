@@ -5,35 +5,92 @@
 #include "Heading.hpp"
 #include "MovementRule.hpp"
 
+#include <cstdint>
 #include <random>
 #include <memory>
-
-class Agent
+#include <iostream>
+
+/**
+ * A mobile agent whose position and heading are stored in Real (float
+ * or double).
+ */
+template<typename Real>
+class BasicAgent
 {
+public:
+   typedef BasicPoint<Real>        Point;
+   typedef BasicHeading<Real>      Heading;
+   typedef BasicMovementRule<Real> MovementRule;
+
 private:
    Point        _position;
    Heading      _heading;
    Heading      _previous_heading;
-   double       _speed;
-   double       _arena_size;
-   int _time;
+   Real         _speed;
+   Real         _dx; // displacement per step, cached from _heading
+   Real         _dy;
+   Real         _arena_size;
+   int          _time; // number of steps taken
    int _next_update;
    bool         dark_ = false;
    std::bernoulli_distribution go_dark_;
 
+   // shared with copies of the agent until one of them moves
    std::shared_ptr<MovementRule> _movement_rule;
 
-   std::mt19937_64 _gen;
+   // Seeded on first use, and shared with copies of the agent until
+   // one of them draws from it.
+   uint64_t                         _seed;
+   std::shared_ptr<std::mt19937_64> _gen;
+
+   /*
+    * Generator() and OwnMovementRule() copy what is shared before
+    * changing it, and tell whether it is shared from use_count(). That
+    * is only sound because copies of an agent are made while nothing
+    * moves the original (copies of a model may be made on several
+    * threads at once, but never while it steps): so an agent that sees
+    * it is the only owner stays the only owner, and the acquire fence
+    * orders its changes after the reads of a copy that was dropped on
+    * another thread.
+    */
+
+   /**
+    * The agent's own generator, ready to draw from.
+    */
+   std::mt19937_64& Generator();
+
+   /**
+    * The agent's movement rule, cloned first if it is shared, ready
+    * to change.
+    */
+   MovementRule& OwnMovementRule();
 
    Point Reflect(const Point& p);
    bool  IsOutOfBounds(const Point& p) const;
 
+   /**
+    * Recompute the cached displacement after the heading changes.
+    */
+   void  UpdateVelocity();
+
+   /**
+    * Fold an unreflected coordinate back into the arena. Returns the
+    * number of wall reflections needed to get there.
+    */
+   long  Fold(Real u, Real& folded) const;
+
+   /**
+    * Number of further steps along one axis before the coordinate
+    * crosses a wall, starting k steps from now.
+    */
+   int   StepsToWall(Real x, Real d, int k) const;
+
 public:
 
    /**
     * Construct an agent at position p with heading h.
     */
-   Agent(Point p, Heading h, double speed, double arena_size, int seed);
+   BasicAgent(Point p, Heading h, Real speed, Real arena_size, int seed);
 
    /**
     * Get the current position of the agent.
@@ -61,6 +118,58 @@ public:
     */
    void Step();
 
+   /**
+    * Get the number of steps the agent has taken.
+    */
+   int Time() const;
+
+   /**
+    * The displacement of the agent's next step.
+    */
+   Point Velocity() const;
+
+   /**
+    * The number of upcoming steps on which the agent is guaranteed
+    * not to turn (other than reflecting off of the walls).
+    */
+   int StraightSteps() const;
+
+   /**
+    * Compute the position after k straight steps in closed form,
+    * without changing the agent. k must not exceed StraightSteps().
+    */
+   Point PositionAfter(int k) const;
+
+   /**
+    * The displacement of the step following k straight steps.
+    */
+   Point VelocityAfter(int k) const;
+
+   /**
+    * The number of straight steps, starting k steps from now, that
+    * can be taken before the agent next reflects off of a wall.
+    */
+   int StepsToWall(int k) const;
+
+   /**
+    * Take k straight steps at once (equivalent to calling Step() k
+    * times when the movement rule does not turn). k must not exceed
+    * StraightSteps().
+    */
+   void Advance(int k);
+
+   /**
+    * Replace the agent's generator with a new one seeded with seed.
+    */
+   void Reseed(uint64_t seed);
+
+   /**
+    * Return the agent to the state it would be constructed in with
+    * position p, heading h and the given seed, keeping its speed,
+    * arena and kind of movement rule, and reusing its storage.
+    */
+   void Reset(Point p, Heading h, int seed);
+
    /**
     * Set the movement rule for the agent.
     */
@@ -89,6 +198,26 @@ public:
    bool IsDark() const;
 
    bool IsInteractive() const;
+
+   /**
+    * Write the complete state of the agent, including its movement
+    * rule and random generator, to a checkpoint.
+    */
+   void Save(std::ostream& out) const;
+
+   /**
+    * Replace the state of the agent with one written by Save(). The
+    * movement rule shares tables with previous_rule where it can (see
+    * BasicMovementRule::Load()).
+    */
+   void Restore(std::istream& in, const std::shared_ptr<MovementRule>& previous_rule = nullptr);
+
+   /**
+    * The agent's movement rule.
+    */
+   std::shared_ptr<MovementRule> GetMovementRule() const;
 };
 
+typedef BasicAgent<double> Agent;
+
 #endif // _AGENT_HPP
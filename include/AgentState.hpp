@@ -0,0 +1,17 @@
+#ifndef _AGENT_STATE_HPP
+#define _AGENT_STATE_HPP
+
+#include <cstdint>
+
+/**
+ * The state of an agent, a small non-negative integer. Binary models
+ * use states 0 and 1.
+ */
+typedef std::uint8_t AgentState;
+
+/**
+ * The number of distinct states an agent can be in.
+ */
+const int MAX_STATES = 256;
+
+#endif // _AGENT_STATE_HPP
@@ -0,0 +1,88 @@
+#ifndef _MOTION_CA_BIT_SLICE_HPP
+#define _MOTION_CA_BIT_SLICE_HPP
+
+#include <cstdint>
+
+/**
+ * Bitwise arithmetic on bit-sliced counters: bit j of planes[p] is
+ * bit p of the count for lane j, so 64 counts are updated at once.
+ */
+namespace bitslice
+{
+   const int MAX_PLANES = 32;
+
+   /**
+    * Number of planes needed to hold counts up to max_count.
+    */
+   inline int Planes(int max_count)
+   {
+      int num_planes = 1;
+      while((1 << num_planes) <= max_count) num_planes++;
+      return num_planes;
+   }
+
+   /**
+    * Add the one-bit values in x to the counter.
+    */
+   inline void Add(uint64_t* planes, int num_planes, uint64_t x)
+   {
+      for(int p = 0; p < num_planes && x != 0; p++)
+      {
+         uint64_t carry = planes[p] & x;
+         planes[p] ^= x;
+         x = carry;
+      }
+   }
+
+   /**
+    * Subtract the one-bit values in x from the counter.
+    */
+   inline void Subtract(uint64_t* planes, int num_planes, uint64_t x)
+   {
+      for(int p = 0; p < num_planes && x != 0; p++)
+      {
+         uint64_t borrow = ~planes[p] & x;
+         planes[p] ^= x;
+         x = borrow;
+      }
+   }
+
+   /**
+    * Compare the counter against the constant c, setting the lanes
+    * whose count is greater than c in greater and those whose count
+    * equals c in equal.
+    */
+   inline void Compare(const uint64_t* planes, int num_planes, int c,
+                       uint64_t& greater, uint64_t& equal)
+   {
+      greater = 0;
+      equal   = ~(uint64_t)0;
+      for(int p = num_planes - 1; p >= 0; p--)
+      {
+         if((c >> p) & 1)
+         {
+            equal &= planes[p];
+         }
+         else
+         {
+            greater |= equal & planes[p];
+            equal   &= ~planes[p];
+         }
+      }
+   }
+
+   /**
+    * The count held by lane j.
+    */
+   inline int Count(const uint64_t* planes, int num_planes, int j)
+   {
+      int count = 0;
+      for(int p = 0; p < num_planes; p++)
+      {
+         count |= (int)((planes[p] >> j) & 1) << p;
+      }
+      return count;
+   }
+}
+
+#endif // _MOTION_CA_BIT_SLICE_HPP
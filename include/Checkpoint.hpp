@@ -0,0 +1,110 @@
+#ifndef _MOTION_CA_CHECKPOINT_HPP
+#define _MOTION_CA_CHECKPOINT_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Reading and writing the binary checkpoints of a model (see
+ * BasicModel::Checkpoint()). Values are written in the machine's
+ * byte order, so a checkpoint is only read back on the same kind of
+ * machine, and readers throw checkpoint::Error when the data runs out
+ * or does not make sense.
+ */
+namespace checkpoint
+{
+   const uint32_t MAGIC   = 0x4341434d; // "MCAC" on little-endian machines
+   const uint32_t VERSION = 3; // raised whenever the layout changes
+
+   class Error : public std::runtime_error
+   {
+   public:
+      Error(const std::string& message) : std::runtime_error("checkpoint: " + message) {}
+   };
+
+   template<typename T>
+   void Write(std::ostream& out, const T& value)
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "only plain values are written directly");
+      out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+   }
+
+   template<typename T>
+   T Read(std::istream& in)
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "only plain values are read directly");
+      T value;
+      if(!in.read(reinterpret_cast<char*>(&value), sizeof(T)))
+      {
+         throw Error("truncated");
+      }
+      return value;
+   }
+
+   template<typename T>
+   void WriteVector(std::ostream& out, const std::vector<T>& values)
+   {
+      Write<uint64_t>(out, values.size());
+      if(!values.empty())
+      {
+         out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+      }
+   }
+
+   template<typename T>
+   void ReadVector(std::istream& in, std::vector<T>& values)
+   {
+      uint64_t size = Read<uint64_t>(in);
+      if(size > (1ULL << 40) / sizeof(T))
+      {
+         throw Error("implausible vector size");
+      }
+      values.resize(size);
+      if(size > 0 && !in.read(reinterpret_cast<char*>(values.data()), size * sizeof(T)))
+      {
+         throw Error("truncated");
+      }
+   }
+
+   /**
+    * Write a random engine's state, packing the words of its standard
+    * text representation into binary.
+    */
+   template<typename Engine>
+   void WriteEngine(std::ostream& out, const Engine& engine)
+   {
+      std::stringstream text;
+      text << engine;
+      std::vector<uint64_t> words;
+      uint64_t word;
+      while(text >> word)
+      {
+         words.push_back(word);
+      }
+      WriteVector(out, words);
+   }
+
+   template<typename Engine>
+   void ReadEngine(std::istream& in, Engine& engine)
+   {
+      std::vector<uint64_t> words;
+      ReadVector(in, words);
+      std::stringstream text;
+      for(uint64_t word : words)
+      {
+         text << word << ' ';
+      }
+      if(!(text >> engine))
+      {
+         throw Error("bad random engine state");
+      }
+   }
+}
+
+#endif // _MOTION_CA_CHECKPOINT_HPP
@@ -0,0 +1,44 @@
+#ifndef _COMPILED_RULES_HPP
+#define _COMPILED_RULES_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Rule.hpp"
+
+/**
+ * A rule from rules/<name>.rule compiled into C++ at build time by
+ * rule_compiler. The transition thresholds are constants in the
+ * generated code, so the compiler can fold the density comparisons.
+ */
+struct CompiledRule
+{
+   /** File name of the rule without the .rule extension. */
+   std::string name;
+
+   /** The text of the rule file the kernel was generated from. */
+   std::string source;
+
+   std::shared_ptr<Rule> (*make)();
+};
+
+/**
+ * All compiled rules. Defined in the generated source.
+ */
+const std::vector<CompiledRule>& CompiledRules();
+
+/**
+ * Make the compiled rule with the given name.
+ * @return nullptr if there is no rule with that name.
+ */
+std::shared_ptr<Rule> MakeCompiledRule(const std::string& name);
+
+/**
+ * Make the compiled rule generated from a rule file with exactly this
+ * text.
+ * @return nullptr if no rule was compiled from this text.
+ */
+std::shared_ptr<Rule> MakeCompiledRuleFromSource(const std::string& source);
+
+#endif // _COMPILED_RULES_HPP
@@ -2,26 +2,59 @@
 #define _HEADING_HPP
 
 #include <iostream>
+#include <cstdint>
 
-class Heading
+/**
+ * A direction in the plane, with trigonometry carried out in Real
+ * (float or double).
+ *
+ * By default the heading is stored in radians, normalized to
+ * [0, 2pi). When built with FIXED_POINT_HEADING the heading is stored
+ * as a 32-bit fraction of a full turn so that normalization is free
+ * integer wraparound, and Cos()/Sin() are looked up in a table with
+ * 2^HEADING_TRIG_TABLE_BITS entries.
+ */
+template<typename Real>
+class BasicHeading
 {
 private:
-   double _heading_radians;
+#ifdef FIXED_POINT_HEADING
+   uint32_t _angle; // units of 2pi / 2^32
+#else
+   Real _heading_radians;
+#endif
 public:
-   Heading(double h);
-   Heading();
-   ~Heading();
+   BasicHeading(Real h);
+   BasicHeading();
+   ~BasicHeading();
 
    /**
     * Return the heading in radians.
     */
-   double Radians() const;
+   Real Radians() const;
 
-   friend bool    operator== (const Heading& h1, const Heading& h2);
-   friend bool    operator!= (const Heading& h1, const Heading& h2);
-   friend Heading operator-  (const Heading& h1, const Heading& h2);
-   friend Heading operator+  (const Heading& h1, const Heading& h2);
-   friend std::ostream& operator<< (std::ostream& out, const Heading& h);
+   /**
+    * Cosine and sine of the heading.
+    */
+   Real Cos() const;
+   Real Sin() const;
+
+   /**
+    * Write the exact representation of the heading to a checkpoint,
+    * or read it back.
+    */
+   void Save(std::ostream& out) const;
+   void Restore(std::istream& in);
+
+   bool operator== (const BasicHeading& h) const;
+   bool operator!= (const BasicHeading& h) const;
+   BasicHeading operator- (const BasicHeading& h) const;
+   BasicHeading operator+ (const BasicHeading& h) const;
 };
 
+template<typename Real>
+std::ostream& operator<< (std::ostream& out, const BasicHeading<Real>& h);
+
+typedef BasicHeading<double> Heading;
+
 #endif // _HEADING_HPP
@@ -0,0 +1,180 @@
+#ifndef _MOTION_CA_HISTORY_HPP
+#define _MOTION_CA_HISTORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "Checkpoint.hpp"
+
+/**
+ * An append-only sequence whose copies share the values they have in
+ * common. The values are kept in chunks of CHUNK: full chunks never
+ * change again and are shared by every copy, and each copy has its own
+ * last, partly filled chunk. So a copy costs a pointer per full chunk
+ * and at most CHUNK values, however long the sequence is, and each
+ * copy appends only its own values.
+ *
+ * Since shared chunks are only read, copies can be made on several
+ * threads at once (while nothing appends to the original) and then
+ * used on separate threads.
+ */
+template<typename T>
+class History
+{
+public:
+   static const size_t CHUNK = 256;
+
+private:
+   std::vector<std::shared_ptr<const std::vector<T>>> _chunks;
+   std::vector<T>                                     _tail;
+
+   // Empty chunks with room for CHUNK values, made by Reserve() so that
+   // filling a chunk does not allocate. Never shared with copies.
+   std::vector<std::shared_ptr<std::vector<T>>> _spare;
+
+   /**
+    * Make the full tail a shared chunk and start a new one.
+    */
+   void Seal()
+   {
+      std::shared_ptr<std::vector<T>> chunk;
+      if(_spare.empty())
+      {
+         chunk = std::make_shared<std::vector<T>>();
+         chunk->reserve(CHUNK);
+      }
+      else
+      {
+         chunk = std::move(_spare.back());
+         _spare.pop_back();
+      }
+      chunk->swap(_tail);
+      _chunks.push_back(std::move(chunk));
+   }
+
+public:
+   History() {}
+
+   History(const History& other) :
+      _chunks(other._chunks),
+      _tail(other._tail)
+   {}
+
+   History(History&& other) = default;
+
+   History& operator=(const History& other)
+   {
+      _chunks = other._chunks;
+      _tail = other._tail;
+      return *this;
+   }
+
+   History& operator=(History&& other) = default;
+
+   void Append(const T& value)
+   {
+      if(_tail.size() == CHUNK)
+      {
+         Seal();
+      }
+      _tail.push_back(value);
+   }
+
+   size_t Size() const
+   {
+      return _chunks.size() * CHUNK + _tail.size();
+   }
+
+   bool Empty() const
+   {
+      return _tail.empty();
+   }
+
+   const T& operator[](size_t i) const
+   {
+      size_t chunk = i / CHUNK;
+      return chunk < _chunks.size() ? (*_chunks[chunk])[i % CHUNK] : _tail[i - _chunks.size() * CHUNK];
+   }
+
+   const T& Back() const
+   {
+      return _tail.back();
+   }
+
+   /**
+    * Make room for count more values, so that appending them does not
+    * allocate.
+    */
+   void Reserve(size_t count)
+   {
+      _tail.reserve(CHUNK);
+      size_t seals = _tail.size() + count == 0 ? 0 : (_tail.size() + count - 1) / CHUNK;
+      while(_spare.size() < seals)
+      {
+         std::shared_ptr<std::vector<T>> chunk = std::make_shared<std::vector<T>>();
+         chunk->reserve(CHUNK);
+         _spare.push_back(std::move(chunk));
+      }
+      _chunks.reserve(_chunks.size() + seals);
+   }
+
+   /**
+    * Forget every value, keeping the storage of the last chunk.
+    */
+   void Clear()
+   {
+      _chunks.clear();
+      _tail.clear();
+   }
+
+   /**
+    * A copy of the values in order.
+    */
+   std::vector<T> Vector() const
+   {
+      std::vector<T> values;
+      values.reserve(Size());
+      for(const std::shared_ptr<const std::vector<T>>& chunk : _chunks)
+      {
+         values.insert(values.end(), chunk->begin(), chunk->end());
+      }
+      values.insert(values.end(), _tail.begin(), _tail.end());
+      return values;
+   }
+
+   /**
+    * Write the values to a checkpoint as checkpoint::WriteVector()
+    * does, or replace them with ones read back.
+    */
+   void Save(std::ostream& out) const
+   {
+      checkpoint::Write<uint64_t>(out, Size());
+      for(const std::shared_ptr<const std::vector<T>>& chunk : _chunks)
+      {
+         out.write(reinterpret_cast<const char*>(chunk->data()), chunk->size() * sizeof(T));
+      }
+      if(!_tail.empty())
+      {
+         out.write(reinterpret_cast<const char*>(_tail.data()), _tail.size() * sizeof(T));
+      }
+   }
+
+   void Restore(std::istream& in)
+   {
+      std::vector<T> values;
+      checkpoint::ReadVector(in, values);
+      Clear();
+      for(const T& value : values)
+      {
+         Append(value);
+      }
+   }
+};
+
+template<typename T>
+const size_t History<T>::CHUNK;
+
+#endif // _MOTION_CA_HISTORY_HPP
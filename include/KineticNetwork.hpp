@@ -0,0 +1,145 @@
+#ifndef _KINETIC_NETWORK_HPP
+#define _KINETIC_NETWORK_HPP
+
+#include <vector>
+#include <queue>
+#include <cstdint>
+#include <iostream>
+
+#include "Agent.hpp"
+#include "Network.hpp"
+
+/**
+ * Event-driven maintenance of the communication network.
+ *
+ * Between turns an agent moves in a straight line (reflecting off of
+ * the walls), so its position at any later time is known in closed
+ * form and the agent does not need to be stepped. The network is
+ * kept up to date by a kinetic priority queue holding two kinds of
+ * events:
+ *
+ *  - agent events, when an agent turns or reflects off of a wall and
+ *    its trajectory is no longer linear, and
+ *  - pair events, when the distance between two agents crosses the
+ *    communication range and their edge goes up or down.
+ *
+ * Agent objects are only brought up to date when they turn, or when
+ * the caller asks for it with Sync().
+ */
+template<typename Real>
+class BasicKineticNetwork
+{
+public:
+   typedef BasicAgent<Real> Agent;
+
+private:
+   struct Event
+   {
+      int      time;
+      int      i;
+      int      j; // -1 for agent events
+      uint32_t version;   // of agent i when the event was scheduled
+      uint32_t version_j; // of agent j, for pair events
+
+      // agent events are processed before pair events at the same time
+      bool operator> (const Event& e) const
+         {
+            if(time != e.time) return time > e.time;
+            return j > e.j;
+         }
+   };
+
+   /**
+    * The straight piece of an agent's trajectory between two agent
+    * events: position(t) = origin + velocity*(t - time).
+    */
+   struct Piece
+   {
+      Real x, y;
+      Real vx, vy;
+      int  time;
+   };
+
+   Real                  _communication_range;
+   NetworkSnapshot       _network;
+   std::vector<Piece>    _pieces;
+   std::vector<int>      _turn_time;     // step on which each agent may turn
+   std::vector<int>      _agent_event;   // time of each agent's next event
+
+   // Every change to an agent's trajectory reschedules all of its
+   // pairs, so a pair event is current while neither agent's version
+   // has changed, and no per-pair state is kept.
+   std::vector<uint32_t> _agent_version;
+
+   /**
+    * A priority queue whose heap can be saved and restored as it is,
+    * so that events due at the same time pop in the same order.
+    */
+   struct EventQueue : std::priority_queue<Event, std::vector<Event>, std::greater<Event>>
+   {
+      std::vector<Event>&       Heap()       { return this->c; }
+      const std::vector<Event>& Heap() const { return this->c; }
+   };
+   EventQueue _events;
+
+   /**
+    * Recompute agent i's next turn and trajectory change at time t.
+    * The agent must be up to date.
+    */
+   void Schedule(const std::vector<Agent>& agents, int i, int t, bool turned);
+
+   /**
+    * Set the edge between i and j at time t and schedule the next
+    * change.
+    */
+   void UpdatePair(int i, int j, int t);
+
+public:
+   BasicKineticNetwork();
+   ~BasicKineticNetwork() {}
+
+   /**
+    * Compute the network and all certificates from scratch at time t.
+    * All agents must have taken t steps.
+    */
+   void Init(const std::vector<Agent>& agents, Real communication_range, int t);
+
+   /**
+    * Process all events up to and including time t, stepping the
+    * agents that turn on step t.
+    */
+   void Advance(std::vector<Agent>& agents, int t);
+
+   /**
+    * Bring agent i up to time t.
+    */
+   void Sync(std::vector<Agent>& agents, int i, int t) const;
+
+   /**
+    * Bring all agents up to time t.
+    */
+   void SyncAll(std::vector<Agent>& agents, int t) const;
+
+   /**
+    * Notify the network that agent i (already synced to time t) has
+    * changed its heading or interactivity on step t.
+    */
+   void Touch(const std::vector<Agent>& agents, int i, int t);
+
+   /**
+    * The network at the last time passed to Advance().
+    */
+   const NetworkSnapshot& Snapshot() const;
+
+   /**
+    * Write the network, certificates and pending events to a
+    * checkpoint, or replace them with ones read back, so that a
+    * restored network processes the same events as this one.
+    */
+   void Save(std::ostream& out) const;
+   void Restore(std::istream& in);
+};
+
+typedef BasicKineticNetwork<double> KineticNetwork;
+
+#endif // _KINETIC_NETWORK_HPP
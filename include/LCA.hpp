@@ -3,6 +3,8 @@
 
 #include <memory>
 #include <functional>
+#include <iostream>
+#include <string>
 
 #include "Model.hpp"
 
@@ -13,22 +15,70 @@ class LCA
 {
 private:
    int                    max_time_;
+   int                    steps_ = 0; // steps run towards max_time_
    std::shared_ptr<Rule>  update_rule_;
-   std::unique_ptr<Model> model_;
+   std::unique_ptr<ModelInterface> model_;
+
+   std::string            checkpoint_path_;
+   int                    checkpoint_interval_ = 0;
+
+   std::function<void(std::unique_ptr<ModelInterface>)> recycler_;
+   bool                   model_exposed_ = false; // GetModel() was called
+
+   /**
+    * Step the model, then write a checkpoint if one is due.
+    */
+   void Step();
 public:
-   LCA(const Model& m, std::shared_ptr<Rule> update_rule, int max_time);
+   /**
+    * Construct an LCA running a copy of m, which may be a model of
+    * either precision.
+    */
+   LCA(const ModelInterface& m, std::shared_ptr<Rule> update_rule, int max_time);
+
+   /**
+    * Construct an LCA running the given model.
+    */
+   LCA(std::unique_ptr<ModelInterface> m, std::shared_ptr<Rule> update_rule, int max_time);
+
+   /**
+    * Resume an LCA from a checkpoint written by Checkpoint(). Rules
+    * are not saved, so the rule the LCA was running must be given
+    * again. Throws like RestoreModel().
+    */
+   LCA(std::istream& checkpoint, std::shared_ptr<Rule> update_rule);
+
+   /**
+    * Hands the model to the recycler, if there is one.
+    */
    ~LCA();
 
    /**
-    * Run the LCA Simulation for 'max_time_' time steps
+    * Start the LCA again on its model reset in place (see
+    * BasicModel::Reset()), with no steps run.
+    */
+   void Reset(int seed, double initial_density);
+
+   /**
+    * Give the model to recycler when the LCA is destroyed, so that
+    * another LCA can reset and reuse it. A model that has been
+    * changed through GetModel() is not recycled, since a reset would
+    * not undo every change.
+    */
+   void SetModelRecycler(std::function<void(std::unique_ptr<ModelInterface>)> recycler);
+
+   /**
+    * Run the LCA Simulation until it has run for 'max_time_' time
+    * steps, so a restored LCA runs only the steps it has left.
     */
    void Run();
 
    /**
-    * Run the LCA Simulation for 'max_time_' or until the early_stop
-    * predicate returns true.
+    * Run the LCA Simulation until it has run for 'max_time_' time
+    * steps or the early_stop predicate returns true.
     * @param early_stop early termination predicate.
-    * @return the number of steps before termination.
+    * @return the number of steps run before termination, including
+    * any run before a checkpoint it was restored from.
     */
    int Run(std::function<bool(const ModelStats&)> early_stop);
 
@@ -38,13 +88,66 @@ public:
     */
    void Run(int k);
 
+   /**
+    * Run the model for 'max_time_' time steps or until every vector
+    * in the batch has converged, driving the batch along the model's
+    * trajectory (see Model::Step(const Rule*, StateBatch&)).
+    * @return the number of steps run.
+    */
+   int Run(StateBatch& batch);
+
    const ModelStats& GetStats() const;
 
+   /**
+    * The agents of a double precision model. Throws std::logic_error
+    * if the LCA is running a single precision model.
+    */
    const std::vector<Agent>& GetAgents() const;
-   const std::vector<int>&   GetStates() const;
+   const std::vector<AgentState>& GetStates() const;
    std::shared_ptr<NetworkSnapshot> CurrentNetwork() const;
    double CurrentDensity() const;
    void MinimizeMemory();
+
+   /**
+    * Keep only the statistics that decide convergence and
+    * classification, in constant space (see
+    * ModelStats::ConvergenceOnly()).
+    */
+   void RecordConvergenceOnly();
+
+   /**
+    * Pass every interval-th step of the model to observer (see
+    * BasicModel::AddObserver()).
+    */
+   void AddObserver(std::shared_ptr<Observer> observer, int interval = 1);
+
+   /**
+    * Write the model and the steps run so far to out (see
+    * BasicModel::Checkpoint()).
+    */
+   void Checkpoint(std::ostream& out) const;
+
+   /**
+    * While running, other than on a StateBatch, write a checkpoint to
+    * path after every interval-th step. Each checkpoint is written
+    * beside path and then renamed over it, so path always holds a
+    * complete checkpoint. An interval of 0 stops checkpointing. Throws
+    * std::invalid_argument if interval is negative, and
+    * std::runtime_error from Run() if a checkpoint can't be written.
+    */
+   void SetCheckpointing(const std::string& path, int interval);
+
+   /**
+    * A branch of this LCA: a fork of its model (see
+    * BasicModel::Fork()) running the same rule for the steps this one
+    * has left. The branch does not write checkpoints.
+    */
+   std::unique_ptr<LCA> Fork(uint64_t stream) const;
+
+   /**
+    * The model being run, e.g. to perturb a branch.
+    */
+   ModelInterface& GetModel();
 };
 
 #endif // _LCA_HPP
@@ -1,8 +1,9 @@
 #ifndef _LCA_FACTORY_HPP
 #define _LCA_FACTORY_HPP
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
-#include <mutex>
 
 #include "Rule.hpp"
 #include "MovementRule.hpp"
@@ -15,20 +16,30 @@
 class LCAFactory
 {
 private:
-   std::mutex new_lca_mutex_; // mutex used when constructing new LCA instances
-
    int                                num_agents_;
    double                             communication_range_;
    int                                arena_size_;
    int                                seed_;
    double                             speed_;
    int                                max_time_; /* max number of time steps to run */
-   std::shared_ptr<MovementRule>      movement_rule_;
    std::shared_ptr<Rule>              rule_; /* CA rule */
-   std::default_random_engine         random_engine_;
-   std::uniform_int_distribution<int> seed_distribution_;
+   uint64_t                           base_seed_ = 0;
+   std::atomic<uint64_t>              next_request_; /* Create() or CreateBatch() calls so far */
+   std::shared_ptr<const uint64_t>    pool_id_; /* key of this factory's recycled models */
    double                             pdark_ = 0;
    double                             pinteractive_ = 1;
+   double                             levy_mu_ = 0; /* use a LevyWalk if > 0 */
+   double                             sigma_ = 0; /* CorrelatedRandomWalk spread */
+   int                                step_threads_ = 1; /* threads per model */
+   bool                               event_driven_ = false;
+   bool                               single_precision_ = false;
+   bool                               shared_trajectory_ = false;
+
+   enum MovementMethod {
+      Random,     // RandomWalk
+      Correlated, // CorrelatedRandomWalk with spread sigma_
+      Levy,       // LevyWalk with exponent levy_mu_
+   } movement_;
 
    enum InitializationMethod {
       Uniform,    // initialize states at random
@@ -39,10 +50,35 @@ private:
 
    void ParseRule(std::string rule_spec);
 
+   /**
+    * The seed of request number request: that entry of a SplitMix64
+    * stream from the base seed, so that no lock is needed.
+    */
+   int SeedAt(uint64_t request) const;
+
+   /**
+    * Build the movement rule for a model of the given precision.
+    */
+   template<typename Real>
+   std::shared_ptr<BasicMovementRule<Real>> MakeMovementRule() const;
+
+   /**
+    * Build an LCA around a model of the given precision, resetting
+    * one recycled on this thread if there is one.
+    */
+   template<typename Real>
+   std::unique_ptr<LCA> Build(double initial_density, int seed) const;
+
 public:
 
    LCAFactory();
-   ~LCAFactory() {}
+
+   /**
+    * The models recycled from this factory are freed the next time
+    * any factory builds an LCA on their thread, or when the thread
+    * exits.
+    */
+   ~LCAFactory();
 
    /**
     * Initialize the factory based on command line arguments.
@@ -52,12 +88,46 @@ public:
 
    /**
     * Make a new LCA instance from the current factory settings. This
-    * operation is thread safe.
+    * operation is thread safe and takes no locks. Each thread keeps a
+    * few of the models of destroyed LCAs from this factory and resets
+    * one in place (see BasicModel::Reset()) rather than allocating a
+    * new one, so replicas run one after another reuse their memory.
+    * A reset model keeps recording what its last LCA recorded (see
+    * LCA::RecordConvergenceOnly()), so set the recording on every LCA
+    * or on none.
     * @param initial_density initial fraction of 'ones'
     * @return A new LCA instance
     */
    std::unique_ptr<LCA> Create(double initial_density);
 
+   /**
+    * Make the LCA that the request-th call to Create() (from 0) after
+    * Init() would make, without counting a request, so that parallel
+    * experiments can seed their tasks by index rather than by the
+    * order in which they run.
+    */
+   std::unique_ptr<LCA> Create(double initial_density, uint64_t request) const;
+
+   /**
+    * Make a batch of state vectors, one per initial density, to be
+    * run along the trajectory of an LCA from Create() (see
+    * LCA::Run(StateBatch&)). States are always initialized at
+    * random. This operation is thread safe and takes no locks.
+    */
+   StateBatch CreateBatch(const std::vector<double>& initial_densities);
+
+   /**
+    * Make the batch that the request-th call to CreateBatch() would
+    * make, as Create(double, uint64_t) does for LCAs.
+    */
+   StateBatch CreateBatch(const std::vector<double>& initial_densities, uint64_t request) const;
+
+   /**
+    * True if --shared-trajectory was given: experiments should score
+    * all initial densities on one trajectory with CreateBatch().
+    */
+   bool SharedTrajectory() const;
+
    /**
     * Set the maximum time the simulation will run.
     * @param t maximum number of time steps.
@@ -70,6 +140,12 @@ public:
     */
    void SetSpeed(double s);
 
+   /**
+    * Run the models in single precision (BasicModel<float>) instead
+    * of double precision.
+    */
+   void SetSinglePrecision(bool single_precision);
+
    /**
     * Set whether or not to record agent state history.
     *
@@ -5,41 +5,345 @@
 #include <random>
 #include <functional>
 #include <memory>
+#include <iostream>
 
 #include "Agent.hpp"
+#include "AgentState.hpp"
 #include "Network.hpp"
 #include "Rule.hpp"
 #include "ModelStats.hpp"
+#include "Observer.hpp"
+#include "KineticNetwork.hpp"
+#include "StateBatch.hpp"
+#include "SplitMix64.hpp"
+#include "ThreadPool.hpp"
 
 /**
- * The model of moving agents.
+ * The precision-independent interface to a model, through which an
+ * LCA drives either a BasicModel<float> or a BasicModel<double>.
  */
-class Model
+class ModelInterface
 {
+public:
+   virtual ~ModelInterface() {}
+
+   virtual void Step(const Rule* rule) = 0;
+   virtual void Step(const Rule* rule, StateBatch& batch) = 0;
+   virtual double CurrentDensity() const = 0;
+   virtual std::shared_ptr<NetworkSnapshot> CurrentNetwork() const = 0;
+   virtual void RecordNetworkDensityOnly() = 0;
+   virtual void RecordConvergenceOnly() = 0;
+   virtual void AddObserver(std::shared_ptr<Observer> observer, int interval) = 0;
+   virtual void ReserveSteps(int steps) = 0;
+   virtual void Reset(int seed, double initial_density) = 0;
+   virtual const ModelStats& GetStats() const = 0;
+   virtual const std::vector<AgentState>& GetStates() const = 0;
+   virtual void Checkpoint(std::ostream& out) const = 0;
+
+   /**
+    * Perturb the model in the middle of a run (see
+    * BasicModel::SetState() and BasicModel::SetAgentHeading(), which
+    * takes the heading in radians here), or change its noise.
+    */
+   virtual void SetState(int a, int state) = 0;
+   virtual void SetAgentHeading(int a, double heading) = 0;
+   virtual void SetNoise(double p) = 0;
+
+   /**
+    * Polymorphic constructor idiom. Create a copy of this model.
+    */
+   virtual std::unique_ptr<ModelInterface> Clone() const = 0;
+
+   /**
+    * Create a branch of this model that continues with random streams
+    * of its own (see BasicModel::Fork()).
+    */
+   virtual std::unique_ptr<ModelInterface> Fork(uint64_t stream) const = 0;
+};
+
+/**
+ * The model of moving agents, with agent positions and headings
+ * stored in Real (float or double).
+ */
+template<typename Real>
+class BasicModel : public ModelInterface
+{
+public:
+   typedef BasicPoint<Real>          Point;
+   typedef BasicHeading<Real>        Heading;
+   typedef BasicAgent<Real>          Agent;
+   typedef BasicMovementRule<Real>   MovementRule;
+   typedef BasicKineticNetwork<Real> KineticNetwork;
+
 private:
    ModelStats         _stats;
 
-   std::vector<Agent> _agents;
-   std::vector<int>   _agent_states;
+   // In event-driven mode agents are brought up to date lazily, so
+   // const accessors may need to advance them.
+   mutable std::vector<Agent> _agents;
+   std::vector<AgentState> _agent_states;
+   int                _num_states;
    int                _steps;
    double             _arena_size;
 
    std::mt19937_64 _rng;
    std::function<double(std::mt19937_64&)> _turn_distribution;
    std::function<int(std::mt19937_64&)>    _step_distribution;
-   std::bernoulli_distribution             _noise;
-   std::bernoulli_distribution             go_dark_;
-   std::bernoulli_distribution             go_interactive_;
+   // Each agent observes noise with its own generator, so the noise
+   // does not depend on the order agents are updated in. _noise_gaps
+   // holds the observations each agent has left before its next noisy
+   // one, or -1 without noise.
+   std::vector<SplitMix64>                             _noise_rngs;
+   std::vector<long long>                              _noise_gaps;
+   std::geometric_distribution<long long>::param_type  _noise_gap_param;
+   double                                  p_dark_;
+   double                                  p_interactive_;
+
+   // Indices of the interactive and dark agents, in no particular
+   // order, and the position of each agent in its set.
+   std::vector<int> _interactive;
+   std::vector<int> _dark;
+   std::vector<int> _set_position;
+
+   // Buffers reused from step to step: the states being computed, the
+   // network (once the stats no longer hold it), and scratch space.
+   std::vector<AgentState>          _next_states;
+   std::shared_ptr<NetworkSnapshot> _network;
+   std::vector<std::vector<int>>    _neighbor_states; // per thread
+   std::vector<int>                 _thread_num_states;
+   std::vector<int>                 _switching;
+   std::vector<double>              _state_densities;
+   std::vector<int>                 _thread_state_counts;
+
+   /**
+    * The agents sorted into square cells at least as wide as the
+    * communication range, so that agents in range of each other are
+    * in the same or adjacent cells. agents lists the agents cell by
+    * cell (row-major) with their positions alongside, and the agents
+    * of cell c are [start[c], start[c+1]).
+    */
+   struct Grid
+   {
+      int                num_cells; // per side
+      double             cell_size;
+      std::vector<int>   agent_cell;
+      std::vector<int>   start;
+      std::vector<int>   agents;
+      std::vector<Point> positions;
+   };
+
+   bool                          _fused = true;
+   Grid                          _grid;
+   std::vector<std::vector<int>> _candidates; // per thread
+
+   // UpdateBatch's scratch space: the next states, the rule's rows and
+   // an agent's interactive neighbors
+   std::vector<uint64_t>             _batch_next;
+   std::vector<std::vector<uint8_t>> _batch_rows;
+   std::vector<int>                  _batch_neighbors;
    double                                  _noise_probability;
 
    double _communication_range;
 
-   int Noise(int i);
+   bool           _event_driven = false;
+   KineticNetwork _kinetic;
+
+   struct Subscription
+   {
+      std::shared_ptr<Observer> observer;
+      int                       interval;
+   };
+   std::vector<Subscription> _observers;
+
+   // Threads for the phases of a time step, started by the first step
+   // that needs them.
+   int                         _num_threads = 1;
+   std::shared_ptr<ThreadPool> _pool;
+
+   /**
+    * State i as agent a observes it.
+    */
+   int Noise(int i, int a);
+
+   /**
+    * True if agent a's next observation of a neighbor's state is
+    * noisy. Rather than drawing for every observation, this counts
+    * down a geometrically distributed gap to the next noisy one.
+    */
+   bool NoiseEvent(int a);
+
+   /**
+    * True if the phases of a step run on the thread pool.
+    */
+   bool Parallel() const;
+
+   /**
+    * Call task(begin, end, thread) over [0, size), in shares on the
+    * thread pool if Parallel(), otherwise all at once on this thread.
+    */
+   template<typename Task>
+   void ForEach(int size, const Task& task) const;
+
+   /**
+    * The fraction of agents in each state.
+    */
+   const std::vector<double>& StateDensities();
+
+   /**
+    * A cleared snapshot to build this step's network in: the previous
+    * step's if nothing else holds it, otherwise a new one.
+    */
+   std::shared_ptr<NetworkSnapshot> NetworkBuffer();
+
+   /**
+    * Add an edge between every pair of agents within communication
+    * range, finding them through grid if the step is fused, with
+    * candidates as scratch space.
+    */
+   void FillNetwork(NetworkSnapshot& snapshot, Grid& grid, std::vector<int>& candidates) const;
+
+   /**
+    * Record the step in the stats and pass it to the observers due.
+    */
+   void Record(const std::vector<double>& state_densities,
+               std::shared_ptr<NetworkSnapshot> network);
+
+   /**
+    * Start the thread pool if the model should have one.
+    */
+   void StartThreads();
+
+   /**
+    * Move every agent one step and compute the resulting network.
+    */
+   std::shared_ptr<NetworkSnapshot> MoveAgents();
+
+   /**
+    * Choose the size of the cells and make room for the agents.
+    */
+   void SizeGrid(Grid& grid) const;
+
+   /**
+    * The cell containing p.
+    */
+   int CellOf(const Grid& grid, const Point& p) const;
+
+   /**
+    * Sort the agents into the cells given by grid.agent_cell.
+    */
+   void SortGrid(Grid& grid) const;
+
+   /**
+    * Set the neighbors of the k-th agent in the grid to the agents
+    * within range in the surrounding cells.
+    */
+   void FillRow(const Grid& grid, int k, NetworkSnapshot& network,
+                std::vector<int>& candidates) const;
+
+   /**
+    * Move every agent one step, noting the cell it lands in, and sort
+    * the agents into their cells.
+    */
+   void MoveAndBin();
+
+   /**
+    * In one pass over the cells, build each agent's row of the network
+    * from the agents in the surrounding cells, apply the rule to it if
+    * it is interactive, and count the agents in each new state.
+    */
+   void InteractAndTally(const Rule* rule, NetworkSnapshot& network);
+
+   /**
+    * Advance the kinetic network one step.
+    */
+   std::shared_ptr<NetworkSnapshot> AdvanceEvents();
+
+   /**
+    * Randomly switch agents between the dark and interactive states.
+    * Rather than drawing for every agent, the agents that switch are
+    * picked by drawing geometrically distributed gaps through the
+    * interactive and dark sets.
+    */
+   void UpdateInteractivity();
+
+   /**
+    * Put each agent in the dark with probability p_dark_.
+    */
+   void DrawDark();
+
+   /**
+    * Draw each agent's observations left before its next noisy one
+    * from its noise generator.
+    */
+   void DrawNoiseGaps();
+
+   /**
+    * Add each member of set to picked independently with probability p.
+    */
+   void Sample(const std::vector<int>& set, double p, std::vector<int>& picked);
+
+   /**
+    * Rebuild the interactive and dark sets from the agents.
+    */
+   void IndexInteractivity();
+
+   /**
+    * Move agent a from its set to the other one.
+    */
+   void SwitchSet(int a);
+
+   /**
+    * Turn agent a by h radians.
+    */
+   void TurnAgent(int a, double h);
+
+   /**
+    * Apply the rule to interactive agent a with the given neighbors,
+    * store its new state in _next_states and turn it. Counts or a
+    * histogram of the neighbor states are passed to the rule if
+    * counts or histogram is true, otherwise neighbor_states is filled
+    * in. Throws like UpdateStates().
+    * @return the new state.
+    */
+   int UpdateAgent(int a, const Rule* rule, const std::vector<int>& neighbors,
+                   bool counts, bool histogram, bool allow_turns,
+                   std::vector<int>& neighbor_states);
+
+   /**
+    * Apply the rule to the agents' states, passing it a histogram of
+    * each neighborhood if it accepts one. Throws std::logic_error if
+    * the rule turns an agent and allow_turns is false, and
+    * std::out_of_range if it yields a state outside [0, MAX_STATES).
+    */
+   void UpdateStates(const Rule* rule, const NetworkSnapshot& current_network, bool allow_turns);
+
+   /**
+    * Apply the rule to every vector in the batch.
+    */
+   void UpdateBatch(const Rule* rule, const NetworkSnapshot& current_network, StateBatch& batch);
+
+   /**
+    * Read the rest of a checkpoint, after its header.
+    */
+   explicit BasicModel(std::istream& in);
+
+   friend std::unique_ptr<ModelInterface> RestoreModel(std::istream& in);
 
 public:
-   Model(double arena_size, int num_agents, double communication_range,
-         int seed, double initial_density, double agent_speed = 1.0);
-   ~Model();
+   BasicModel(double arena_size, int num_agents, double communication_range,
+              int seed, double initial_density, double agent_speed = 1.0);
+   ~BasicModel();
+
+   /**
+    * Start again as the model constructed with seed and
+    * initial_density (and the same arena, agents, range and speed)
+    * would start once given this model's movement rule, noise, dark
+    * probability (see SetPDark()) and other settings. The stats are
+    * cleared but keep recording what they recorded (see
+    * RecordConvergenceOnly()), observers are removed, and all the
+    * storage of the previous run is reused.
+    */
+   void Reset(int seed, double initial_density) override;
 
    /**
     * Reinitialize the model with states set according to x-coordinate
@@ -49,13 +353,44 @@ public:
     */
    void SetPositionalState(double initial_density);
 
+   /**
+    * Reinitialize the model with the given agent states. Throws
+    * std::out_of_range unless every state is in [0, MAX_STATES).
+    */
+   void SetStates(const std::vector<int>& states);
+
+   /**
+    * Change the state of agent a in the middle of a run, keeping the
+    * stats recorded so far. Throws std::out_of_range unless a is an
+    * agent and state is in [0, MAX_STATES).
+    */
+   void SetState(int a, int state) override;
+
+   /**
+    * Change the heading of agent a in the middle of a run. Throws
+    * std::out_of_range unless a is an agent.
+    */
+   void SetAgentHeading(int a, Heading h);
+   void SetAgentHeading(int a, double heading) override;
+
    /**
     * Get the current density of the model (ie. proportion of black
     * states to white states).
     */
-   double CurrentDensity() const;
+   double CurrentDensity() const override;
 
-   std::shared_ptr<NetworkSnapshot> CurrentNetwork() const;
+   /**
+    * Get the fraction of agents in the given state.
+    */
+   double CurrentDensity(int state) const;
+
+   /**
+    * One more than the largest state any agent has been in, at least
+    * 2.
+    */
+   int NumStates() const;
+
+   std::shared_ptr<NetworkSnapshot> CurrentNetwork() const override;
 
    /**
     * Get the density of the communication network.
@@ -63,14 +398,37 @@ public:
    double NetworkDensity() const;
 
    /**
-    * Save the network density only.
+    * Save the network density only. Once the stats no longer keep the
+    * snapshots, a time-stepped model does not allocate memory in
+    * Step(rule) after the first few steps (apart from growing the
+    * density histories; see ReserveSteps()).
     */
-   void RecordNetworkDensityOnly();
+   void RecordNetworkDensityOnly() override;
+
+   /**
+    * Save only what decides convergence and classification (see
+    * ModelStats::ConvergenceOnly()).
+    */
+   void RecordConvergenceOnly() override;
+
+   /**
+    * Call observer->Observe() on every time step that is a multiple of
+    * interval, starting with the current one if it is. Observers see
+    * steps, not SetStates() or SetPositionalState(), so add them after
+    * setting the initial states. A clone has no observers. Throws
+    * std::invalid_argument unless interval is positive.
+    */
+   void AddObserver(std::shared_ptr<Observer> observer, int interval = 1) override;
+
+   /**
+    * Make room in the stats for steps more time steps.
+    */
+   void ReserveSteps(int steps) override;
 
    /**
     * Get statistics about the model.
     */
-   const ModelStats& GetStats() const;
+   const ModelStats& GetStats() const override;
 
    /**
     * Get the agents from the model.
@@ -80,7 +438,7 @@ public:
    /**
     * Get the current states of the agents
     */
-   const std::vector<int>& GetStates() const;
+   const std::vector<AgentState>& GetStates() const override;
 
    /**
     * Set the movement rule.
@@ -100,7 +458,7 @@ public:
    /**
     * Set the amount of noise. p is a real number in [0,1].
     */
-   void SetNoise(double p);
+   void SetNoise(double p) override;
 
    /**
     * Set the probability of going dark.
@@ -112,15 +470,103 @@ public:
     */
    void SetPInteractive(double p);
 
+   /**
+    * Use the event-driven engine (see KineticNetwork) instead of
+    * stepping every agent on every time step. This is much faster
+    * when agents travel in straight lines for many steps (e.g. a
+    * LevyWalk with small mu), and produces the same sequence of
+    * networks and states as the time-stepped model up to floating
+    * point rounding in agent positions.
+    */
+   void SetEventDriven(bool event_driven);
+
+   /**
+    * Run each phase of a time step (moving the agents, building the
+    * network and updating the states) on num_threads threads, with a
+    * barrier between phases; 1 runs everything on the calling thread.
+    * The results do not depend on the number of threads, since every
+    * agent moves and observes noise with its own generator. The
+    * event-driven engine always runs on one thread. The threads start
+    * on the first step; a clone starts threads of its own.
+    */
+   void SetThreads(int num_threads);
+
+   /**
+    * The number of threads a time step runs on.
+    */
+   int NumThreads() const;
+
+   /**
+    * Step the time-stepped model with the fused pipeline (the
+    * default): agents are sorted into cells as they move, and one
+    * blocked pass over the cells builds the network, updates the
+    * states and counts them. Otherwise each phase streams over all the
+    * agents and the network tests every pair of agents. Both give the
+    * same results. Step(rule, batch) runs the phases separately, but
+    * finds the network through the cells unless this is false.
+    */
+   void SetFusedStep(bool fused);
+
    /**
     * Evaluate the model for one time-step.
     */
-   void Step(const Rule* rule);
+   void Step(const Rule* rule) override;
+
+   /**
+    * Evaluate the model for one time-step, also applying the rule to
+    * every state vector in the batch on the same network. Since the
+    * trajectory must not depend on the states, this throws
+    * std::logic_error if the rule turns an agent or noise is set.
+    */
+   void Step(const Rule* rule, StateBatch& batch) override;
 
    /**
     * Set the communication range of the agents.
     */
    void SetCommunicationRange(double range);
+
+   std::unique_ptr<ModelInterface> Clone() const override;
+
+   /**
+    * Create a branch of this model for comparing variations of a run
+    * from this step on (e.g. after SetState(), SetAgentHeading() or
+    * SetNoise()). The branch starts in the same state with the same
+    * stats, but every random generator in it (the model's, and each
+    * agent's for noise and movement) is reseeded from stream and each
+    * agent's next noisy observation is redrawn, so branches with the
+    * same stream follow the same trajectory and branches with
+    * different streams are independent. Forking costs a copy of the
+    * agents without their movement generators: the branch shares the
+    * steps already recorded in the stats and records only its own, and
+    * each movement generator is seeded on its first draw. Like a
+    * clone, a branch has no observers and starts threads of its own.
+    * Branches can be forked on several threads at once, as long as
+    * nothing steps or changes this model meanwhile.
+    */
+   std::unique_ptr<ModelInterface> Fork(uint64_t stream) const override;
+
+   /**
+    * Write the state of the model to out, so that RestoreModel() can
+    * resume it: the agents (positions, headings, dark flags, movement
+    * rules and generators), the states, every random generator and
+    * the stats. A restored model continues exactly as this one does.
+    * Observers and threads are not saved; the number of threads is.
+    * In event-driven mode the agents are saved as they are, with the
+    * kinetic network's pending events. Taking a checkpoint does not
+    * change the model. Throws std::logic_error if a movement rule
+    * can't be saved.
+    */
+   void Checkpoint(std::ostream& out) const override;
 };
 
+typedef BasicModel<double> Model;
+
+/**
+ * Restore a model from a checkpoint written by Checkpoint(), as a
+ * BasicModel of the precision it was written in. Throws
+ * checkpoint::Error if in does not hold a checkpoint from a build of
+ * the same version and heading representation.
+ */
+std::unique_ptr<ModelInterface> RestoreModel(std::istream& in);
+
 #endif // _MOTION_CA_MODEL_HPP
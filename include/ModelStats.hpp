@@ -1,25 +1,48 @@
 #ifndef _MODEL_STATS_HPP
 #define _MODEL_STATS_HPP
 
+#include <iostream>
 #include <vector>
 
 #include "Network.hpp"
+#include "Observer.hpp"
 
 /**
  * Statistics about a model including current timestep, current
  * density, density at each previous timestep, and whether or not the
  * classification is correct.
+ *
+ * The histories are recorded by the DensityTracker, AggregateNetwork
+ * and SnapshotArchive observers. An experiment that needs fewer or
+ * other statistics can record convergence only and add the observers
+ * it needs to the model (see BasicModel::AddObserver()).
+ *
+ * Copies share the steps they have in common and each records only
+ * its own (see History and AggregateNetwork), so a copy is cheap
+ * however long the histories are.
  */
 class ModelStats
 {
 private:
-   Network             _network;
-   std::vector<double> _ca_density;
-   std::vector<double> _network_density;
+   SnapshotArchive  _archive;
+   DensityTracker   _densities;
+   AggregateNetwork _aggregate;
+
+   int _num_agents;
+
+   /**
+    * Empty the histories, keeping their storage.
+    */
+   void ClearHistories();
 
    bool _network_summary_only = false;
+   bool _convergence_only = false;
 
-   NetworkSnapshot _aggregate_network;
+   // Kept in every mode: the density at the first step, the last three
+   // densities (most recent first), and the number of steps recorded.
+   double       _initial_density = 0.0;
+   double       _recent_density[3] = {0.0, 0.0, 0.0};
+   unsigned int _elapsed = 0;
 
 public:
    ModelStats(int num_agents);
@@ -31,16 +54,53 @@ public:
     */
    void PushState(double density, std::shared_ptr<NetworkSnapshot> snapshot);
 
+   /**
+    * Record the fraction of agents in each state and the density of
+    * the interaction network at the next timestep. The ca density is
+    * the fraction in state 1.
+    */
+   void PushState(const std::vector<double>& state_densities,
+                  std::shared_ptr<NetworkSnapshot> snapshot);
+
    /**
     * Don't save the network snapshots, only save the density of each
     * snapshot.
     */
    void NetworkSummaryOnly();
 
+   /**
+    * Keep only what IsCorrect(), IsSynchronized(), CurrentCADensity()
+    * and ElapsedTime() need, which takes constant space and time per
+    * step: no network, aggregate network or density histories, which
+    * stay empty from now on.
+    */
+   void ConvergenceOnly();
+
+   /**
+    * Forget every step recorded so far, keeping the recording mode
+    * and the storage.
+    */
+   void Clear();
+
+   /**
+    * Make room for steps more time steps in the density histories.
+    */
+   void Reserve(int steps);
+
    /**
     * Get the sequence of densities up to this time.
     */
-   const std::vector<double>& GetDensityHistory() const;
+   std::vector<double> GetDensityHistory() const;
+
+   /**
+    * Get the sequence of fractions of agents in the given state.
+    */
+   std::vector<double> GetDensityHistory(int state) const;
+
+   /**
+    * The number of states recorded, at least 2.
+    */
+   int NumStates() const;
 
    /**
     * Get the network up to this time.
@@ -77,6 +137,13 @@ public:
    double MedianAggregateDegree() const;
 
    double CurrentCADensity() const;
+
+   /**
+    * Write everything recorded, and the recording mode, to a
+    * checkpoint, or replace them with ones read back.
+    */
+   void Save(std::ostream& out) const;
+   void Restore(std::istream& in);
 };
 
 #endif // _MODEL_STATS_HPP
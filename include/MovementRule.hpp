@@ -3,15 +3,21 @@
 
 #include <random>
 #include <memory>
+#include <iostream>
 
 #include "Point.hpp"
 #include "Heading.hpp"
+#include "PowerLawSampler.hpp"
 
-class MovementRule
+template<typename Real>
+class BasicMovementRule
 {
 public:
-   MovementRule() {}
-   ~MovementRule() {}
+   typedef BasicPoint<Real>   Point;
+   typedef BasicHeading<Real> Heading;
+
+   BasicMovementRule() {}
+   ~BasicMovementRule() {}
 
    /**
     * Generate a new heading.
@@ -26,57 +32,130 @@ public:
          return current_heading;
       }
 
+   /**
+    * The number of upcoming calls to Turn() that are guaranteed to
+    * return the current heading. Rules that may turn on any step
+    * return 0.
+    */
+   virtual unsigned int StraightSteps() const
+      {
+         return 0;
+      }
+
+   /**
+    * Advance the rule as if Turn() had been called k times and
+    * returned the current heading each time. k must not exceed
+    * StraightSteps().
+    */
+   virtual void Skip(unsigned int k) {}
+
+   /**
+    * Return the rule to the state it was constructed in.
+    */
+   virtual void Reset() {}
+
    /**
     * Polymorphic constructor idiom. Create a copy of this rule.
     */
-   virtual std::shared_ptr<MovementRule> Clone() const
+   virtual std::shared_ptr<BasicMovementRule> Clone() const
       {
-         return std::make_shared<MovementRule>(*this);
+         return std::make_shared<BasicMovementRule>(*this);
       }
+
+   /**
+    * Write the parameters and state of the rule to a checkpoint. A
+    * subclass that doesn't override this can't be checkpointed, and
+    * throws std::logic_error.
+    */
+   virtual void Save(std::ostream& out) const;
+
+   /**
+    * Read a rule written by Save(). If previous is a rule of the same
+    * kind and parameters its tables are shared rather than rebuilt, as
+    * they are between clones.
+    */
+   static std::shared_ptr<BasicMovementRule> Load(std::istream& in,
+                                                  const std::shared_ptr<BasicMovementRule>& previous = nullptr);
+
+protected:
+   // tags identifying each kind of rule in a checkpoint
+   enum Kind : uint8_t { STRAIGHT, LEVY_WALK, CORRELATED_RANDOM_WALK, RANDOM_WALK };
 };
 
-class LevyWalk : public MovementRule
+template<typename Real>
+class BasicLevyWalk : public BasicMovementRule<Real>
 {
 private:
+   double       mu;
+   int          max_step;
    unsigned int next_turn;
    unsigned int current_time;
-   std::uniform_real_distribution<double> heading_distribution;
-   double mu;
-   int    max_step;
+   std::uniform_real_distribution<Real> heading_distribution;
+
+   // tabulated step length distribution, shared by all clones
+   std::shared_ptr<const PowerLawSampler> step_length;
 public:
-   LevyWalk(double mu, int max_step);
-   ~LevyWalk();
+   typedef BasicPoint<Real>   Point;
+   typedef BasicHeading<Real> Heading;
+
+   BasicLevyWalk(double mu, int max_step);
+   ~BasicLevyWalk();
 
    Heading Turn(const Point&     current_position,
                 const Heading&   current_heading,
                 std::mt19937_64& gen) override;
-   std::shared_ptr<MovementRule> Clone() const override;
+   unsigned int StraightSteps() const override;
+   void Skip(unsigned int k) override;
+   void Reset() override;
+   std::shared_ptr<BasicMovementRule<Real>> Clone() const override;
+   void Save(std::ostream& out) const override;
+
+   /**
+    * Read the rest of a rule written by Save(), after its tag.
+    */
+   static std::shared_ptr<BasicMovementRule<Real>> Load(std::istream& in,
+                                                        const std::shared_ptr<BasicMovementRule<Real>>& previous);
 };
 
-class CorrelatedRandomWalk : public MovementRule
+template<typename Real>
+class BasicCorrelatedRandomWalk : public BasicMovementRule<Real>
 {
 private:
-   double _sigma;
+   Real _sigma;
 public:
-   CorrelatedRandomWalk(double sigma);
-   ~CorrelatedRandomWalk();
+   typedef BasicPoint<Real>   Point;
+   typedef BasicHeading<Real> Heading;
+
+   BasicCorrelatedRandomWalk(double sigma);
+   ~BasicCorrelatedRandomWalk();
 
    Heading Turn(const Point&     current_position,
                 const Heading&   current_heading,
                 std::mt19937_64& gen) override;
-   std::shared_ptr<MovementRule> Clone() const override;
+   std::shared_ptr<BasicMovementRule<Real>> Clone() const override;
+   void Save(std::ostream& out) const override;
 };
 
-class RandomWalk : public MovementRule
+template<typename Real>
+class BasicRandomWalk : public BasicMovementRule<Real>
 {
 private:
-   std::uniform_real_distribution<double> heading_distribution;
+   std::uniform_real_distribution<Real> heading_distribution;
 public:
-   RandomWalk();
-   ~RandomWalk();
+   typedef BasicPoint<Real>   Point;
+   typedef BasicHeading<Real> Heading;
+
+   BasicRandomWalk();
+   ~BasicRandomWalk();
 
    Heading Turn(const Point&, const Heading&, std::mt19937_64& gen) override;
-   std::shared_ptr<MovementRule> Clone() const override;
+   std::shared_ptr<BasicMovementRule<Real>> Clone() const override;
+   void Save(std::ostream& out) const override;
 };
 
+typedef BasicMovementRule<double>         MovementRule;
+typedef BasicLevyWalk<double>             LevyWalk;
+typedef BasicCorrelatedRandomWalk<double> CorrelatedRandomWalk;
+typedef BasicRandomWalk<double>           RandomWalk;
+
 #endif // _MOVEMENT_RULE_HPP
\ No newline at end of file
@@ -2,16 +2,23 @@
 #define _MOTION_CA_NETWORK_HPP
 
 #include <vector>
-#include <set>
 #include <stdexcept>
 #include <memory>
 #include <iostream>
 
+#include "History.hpp"
+
+/**
+ * An undirected graph, stored as a sorted list of neighbors for each
+ * vertex. Clearing the snapshot keeps the storage of the lists, so a
+ * snapshot that is rebuilt every step stops allocating once the lists
+ * have grown to the largest degrees seen.
+ */
 class NetworkSnapshot
 {
 private:
 
-   std::vector<std::set<int>> _adjacency_list;
+   std::vector<std::vector<int>> _adjacency_list;
    int _num_vertices;
 
 public:
@@ -27,6 +34,28 @@ public:
     */
    void AddEdge(int i, int j);
 
+   /**
+    * Add j to the neighbors of i only. Filling in a snapshot one
+    * vertex at a time lets separate threads build separate vertices;
+    * the caller must also add i to the neighbors of j.
+    *
+    * If the edge is invalid then an out_of_range exception is thrown.
+    */
+   void AddHalfEdge(int i, int j);
+
+   /**
+    * Remove the edge between vertices i and j from the snapshot, if
+    * present.
+    *
+    * If the edge is invalid then an out_of_range exception is thrown.
+    */
+   void RemoveEdge(int i, int j);
+
+   /**
+    * Remove every edge.
+    */
+   void Clear();
+
    /**
     * Get the density of this snapshot. (proportion of possible edges
     * that actually exist).
@@ -71,12 +100,17 @@ public:
    int Degree(int v) const;
 
    /**
-    * Get the set of neighbors to vertex v.
+    * True if there is an edge between i and j.
+    */
+   bool HasEdge(int i, int j) const;
+
+   /**
+    * Get the neighbors of vertex v in increasing order.
     *
     * If v is not a node in the network then throws an out_of_range
     * exception.
     */
-   std::set<int> GetNeighbors(int v) const;
+   const std::vector<int>& GetNeighbors(int v) const;
 
    /**
     * get the number of vertices
@@ -85,15 +119,26 @@ public:
 
    void Union(const NetworkSnapshot& s);
 
+   /**
+    * Write the snapshot to a checkpoint, or replace it with one read
+    * back.
+    */
+   void Save(std::ostream& out) const;
+   void Restore(std::istream& in);
+
    friend bool operator== (const NetworkSnapshot& s, const NetworkSnapshot& g);
    friend std::ostream& operator<< (std::ostream& out, const NetworkSnapshot& s);
 };
 
+/**
+ * A sequence of snapshots. Copies share the snapshots they have in
+ * common (see History).
+ */
 class Network
 {
 private:
 
-   std::vector<std::shared_ptr<NetworkSnapshot>> _snapshots;
+   History<std::shared_ptr<NetworkSnapshot>> _snapshots;
 
 public:
 
@@ -121,6 +166,19 @@ public:
     * Get the number of snapshots in the network.
     */
    unsigned int Size() const;
+
+   /**
+    * Remove every snapshot.
+    */
+   void Clear();
+
+   /**
+    * Write every snapshot to a checkpoint, or replace them with ones
+    * read back. Snapshots shared before saving are separate copies
+    * after restoring.
+    */
+   void Save(std::ostream& out) const;
+   void Restore(std::istream& in);
 };
 
 #endif // _MOTION_CA_NETWORK_HPP
\ No newline at end of file
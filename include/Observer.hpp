@@ -0,0 +1,229 @@
+#ifndef _MOTION_CA_OBSERVER_HPP
+#define _MOTION_CA_OBSERVER_HPP
+
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "History.hpp"
+#include "Network.hpp"
+
+/**
+ * Something that records statistics about a model as it runs. A model
+ * calls Observe() with the state of every step it is asked to (see
+ * BasicModel::AddObserver()), so an experiment pays only for the
+ * statistics it reads.
+ */
+class Observer
+{
+public:
+   virtual ~Observer() {}
+
+   /**
+    * Observe time step step, at which state_densities[s] of the agents
+    * are in state s and the agents communicate over network. network
+    * may be reused by the model for a later step unless the observer
+    * keeps a reference to it.
+    */
+   virtual void Observe(int step, const std::vector<double>& state_densities,
+                        std::shared_ptr<NetworkSnapshot> network) = 0;
+};
+
+/**
+ * The fraction of agents in each state at every observation. Copies
+ * share the observations they have in common (see History).
+ */
+class DensityTracker : public Observer
+{
+private:
+   History<double> _ca_density;
+
+   // History of each state other than 1 (which is _ca_density), kept
+   // only once a state above 1 has been seen.
+   std::vector<History<double>> _state_density;
+
+public:
+   void Observe(int step, const std::vector<double>& state_densities,
+                std::shared_ptr<NetworkSnapshot> network) override;
+
+   /**
+    * Make room for more observations.
+    */
+   void Reserve(int observations);
+
+   /**
+    * Forget every observation, keeping the storage.
+    */
+   void Clear();
+
+   /**
+    * The fraction of agents in state 1 at each observation.
+    */
+   std::vector<double> GetDensityHistory() const;
+
+   /**
+    * The fraction of agents in the given state at each observation.
+    */
+   std::vector<double> GetDensityHistory(int state) const;
+
+   /**
+    * The number of states seen, at least 2.
+    */
+   int NumStates() const;
+
+   /**
+    * Write the observations to a checkpoint, or replace them with ones
+    * read back.
+    */
+   void Save(std::ostream& out) const;
+   void Restore(std::istream& in);
+};
+
+/**
+ * The union of every network observed, and its density after each
+ * observation.
+ *
+ * A copy shares the union so far with the original: the first copy
+ * made since the last observation merges it into a snapshot that
+ * neither changes again, and each then keeps only the edges it
+ * observes that are not in that snapshot. Copies can be made on
+ * several threads at once, while nothing observes the original.
+ */
+class AggregateNetwork : public Observer
+{
+private:
+   // The union is the edges of _shared and those of _own, which has
+   // none of _shared's. The counts are of edge ends, i.e. the sum of
+   // the degrees.
+   std::shared_ptr<const NetworkSnapshot> _shared;
+   NetworkSnapshot                        _own;
+   long                                   _shared_ends = 0;
+   long                                   _own_ends = 0;
+   History<double>                        _density;
+
+   // _shared and _own merged for copies, until the next observation
+   mutable std::mutex                             _merging;
+   mutable std::shared_ptr<const NetworkSnapshot> _merged;
+
+   /**
+    * The whole union as a snapshot that will not change, for a copy
+    * to share.
+    */
+   std::shared_ptr<const NetworkSnapshot> Share() const;
+
+public:
+   AggregateNetwork(int num_agents);
+   AggregateNetwork(const AggregateNetwork& other);
+   AggregateNetwork& operator=(const AggregateNetwork& other);
+
+   void Observe(int step, const std::vector<double>& state_densities,
+                std::shared_ptr<NetworkSnapshot> network) override;
+
+   /**
+    * Make room for more observations.
+    */
+   void Reserve(int observations);
+
+   /**
+    * Forget every observation, keeping the storage.
+    */
+   void Clear();
+
+   /**
+    * The number of agents.
+    */
+   int Size() const;
+
+   /**
+    * The union of the networks observed.
+    */
+   NetworkSnapshot Aggregate() const;
+
+   /**
+    * The density of the aggregate network after each observation.
+    */
+   std::vector<double> DensityHistory() const;
+
+   /**
+    * Write the observations to a checkpoint, or replace them with ones
+    * read back.
+    */
+   void Save(std::ostream& out) const;
+   void Restore(std::istream& in);
+};
+
+/**
+ * Every network observed. The model can't reuse a network this keeps,
+ * so each step it is observed allocates a new one. Copies share the
+ * networks they have in common (see Network).
+ */
+class SnapshotArchive : public Observer
+{
+private:
+   Network _network;
+
+public:
+   void Observe(int step, const std::vector<double>& state_densities,
+                std::shared_ptr<NetworkSnapshot> network) override;
+
+   const Network& GetNetwork() const;
+
+   /**
+    * Forget every observation.
+    */
+   void Clear();
+
+   /**
+    * Write the observations to a checkpoint, or replace them with ones
+    * read back.
+    */
+   void Save(std::ostream& out) const;
+   void Restore(std::istream& in);
+};
+
+/**
+ * The mean, standard deviation and median of the agents' degrees at
+ * each observation.
+ */
+class DegreeStats : public Observer
+{
+private:
+   std::vector<double> _mean;
+   std::vector<double> _std_dev;
+   std::vector<double> _median;
+
+public:
+   void Observe(int step, const std::vector<double>& state_densities,
+                std::shared_ptr<NetworkSnapshot> network) override;
+
+   const std::vector<double>& Mean() const;
+   const std::vector<double>& StdDev() const;
+   const std::vector<double>& Median() const;
+};
+
+/**
+ * The number of connected components of the network and the size of
+ * the largest at each observation.
+ */
+class ComponentStats : public Observer
+{
+private:
+   std::vector<int> _count;
+   std::vector<int> _largest;
+
+   // union-find scratch space
+   std::vector<int> _parent;
+   std::vector<int> _size;
+
+   int Find(int v);
+
+public:
+   void Observe(int step, const std::vector<double>& state_densities,
+                std::shared_ptr<NetworkSnapshot> network) override;
+
+   const std::vector<int>& Count() const;
+   const std::vector<int>& Largest() const;
+};
+
+#endif // _MOTION_CA_OBSERVER_HPP
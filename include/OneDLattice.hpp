@@ -4,18 +4,39 @@
 #include <vector>
 #include <random>
 #include <iostream>
+#include <cstdint>
 
-#include "Network.hpp"
 #include "Rule.hpp"
 
+/**
+ * A binary CA on a ring where each cell's neighbors are the cells
+ * within distance radius.
+ *
+ * States are packed 64 cells to a word. Each step the rule is
+ * evaluated once for every (state, number of ones) pair, through the
+ * count-based Rule::Apply(), and every cell then looks up its new
+ * state using a sliding-window count of the ones in its neighborhood.
+ * Rules must produce states 0 or 1; any non-zero state is stored as 1.
+ */
 class OneDLattice
 {
 private:
-   NetworkSnapshot  _lattice;
-   std::vector<int> _old_states;
-   std::vector<int> _states;
-   std::mt19937_64  _rng;
-   int              _steps;
+   int                   _num_cells;
+   int                   _radius;
+   std::vector<uint64_t> _old_cells;
+   std::vector<uint64_t> _cells;
+   std::vector<uint8_t>  _rule_table; // _rule_table[2*ones + self]
+   std::mt19937_64       _rng;
+   int                   _steps;
+
+   int  Get(const std::vector<uint64_t>& cells, int i) const;
+   void Set(std::vector<uint64_t>& cells, int i, int state);
+   int  CountOnes(const std::vector<uint64_t>& cells) const;
+
+   /**
+    * Number of distinct neighbors of every cell.
+    */
+   int Degree() const;
 
 public:
    OneDLattice(int num_cells, int radius);
@@ -55,4 +76,4 @@ public:
    friend std::ostream& operator<< (std::ostream& out, const OneDLattice& l);
 };
 
-#endif // _MOTION_CA_ONE_D_LATTICE_HPP
\ No newline at end of file
+#endif // _MOTION_CA_ONE_D_LATTICE_HPP
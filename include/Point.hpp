@@ -4,54 +4,67 @@
 #include <iostream>
 
 /**
- * A point in the plane.
+ * A point in the plane with coordinates of type Real (float or
+ * double).
  */
-class Point
+template<typename Real>
+class BasicPoint
 {
 private:
-   double _x;
-   double _y;
+   Real _x;
+   Real _y;
 public:
-   Point(double x, double y);
-   ~Point();
+   BasicPoint(Real x, Real y);
+   ~BasicPoint();
+
+   /**
+    * Convert a point of a different precision.
+    */
+   template<typename R>
+   explicit BasicPoint(const BasicPoint<R>& p) : _x(p.GetX()), _y(p.GetY()) {}
 
    /**
     * The x-coordinate
     */
-   double GetX() const;
+   Real GetX() const;
 
    /**
     * The y-coordinate
     */
-   double GetY() const;
+   Real GetY() const;
 
    /**
     * Get the euclidian distance between two points.
     */
-   double Distance(const Point& p) const;
+   Real Distance(const BasicPoint& p) const;
 
    /**
     * Test whether two points lie within distance d of eachother.
     */
-   bool Within(double d, const Point& p) const;
+   bool Within(Real d, const BasicPoint& p) const;
 
    /**
     * Test whether this point is north/south/east/west of some other
     * point.
     */
-   bool NorthOf(const Point& p) const;
-   bool SouthOf(const Point& p) const;
-   bool EastOf (const Point& p) const;
-   bool WestOf (const Point& p) const;
-
-   bool DueNorthOf(const Point& p) const;
-   bool DueSouthOf(const Point& p) const;
-   bool DueEastOf (const Point& p) const;
-   bool DueWestOf (const Point& p) const;
-
-   friend bool operator== (const Point& p, const Point& q);
-   friend bool operator!= (const Point& p, const Point& q);
-   friend std::ostream& operator<< (std::ostream& out, const Point& p);
+   bool NorthOf(const BasicPoint& p) const;
+   bool SouthOf(const BasicPoint& p) const;
+   bool EastOf (const BasicPoint& p) const;
+   bool WestOf (const BasicPoint& p) const;
+
+   bool DueNorthOf(const BasicPoint& p) const;
+   bool DueSouthOf(const BasicPoint& p) const;
+   bool DueEastOf (const BasicPoint& p) const;
+   bool DueWestOf (const BasicPoint& p) const;
 };
 
+template<typename Real>
+bool operator== (const BasicPoint<Real>& p, const BasicPoint<Real>& q);
+template<typename Real>
+bool operator!= (const BasicPoint<Real>& p, const BasicPoint<Real>& q);
+template<typename Real>
+std::ostream& operator<< (std::ostream& out, const BasicPoint<Real>& p);
+
+typedef BasicPoint<double> Point;
+
 #endif // _POINT_HPP
@@ -0,0 +1,44 @@
+#ifndef _POWER_LAW_SAMPLER_HPP
+#define _POWER_LAW_SAMPLER_HPP
+
+#include <vector>
+#include <random>
+#include <cstdint>
+
+/**
+ * Sampler for integer step lengths drawn from a power law with
+ * exponent mu truncated to [1, max_step].
+ *
+ * A step length is floor(z) where z has density proportional to
+ * z^-mu on [1, max_step]. The distribution is tabulated once with
+ * Walker's alias method so that each draw takes a single call to the
+ * generator and no transcendental functions.
+ */
+class PowerLawSampler
+{
+private:
+   std::vector<double>   _probability; // P(step length = i+1)
+   std::vector<uint32_t> _threshold;   // acceptance threshold, scaled to 2^32
+   std::vector<int>      _alias;
+
+public:
+   PowerLawSampler(double mu, int max_step);
+   ~PowerLawSampler() {}
+
+   /**
+    * Draw a step length.
+    */
+   int operator()(std::mt19937_64& gen) const;
+
+   /**
+    * The probability that a draw returns k.
+    */
+   double Probability(int k) const;
+
+   /**
+    * The largest step length that can be drawn.
+    */
+   int MaxStep() const;
+};
+
+#endif // _POWER_LAW_SAMPLER_HPP
@@ -21,6 +21,11 @@ public:
 
    bool Contains(double k) const;
 
+   double Min() const;
+   double Max() const;
+   bool   IncludesMin() const;
+   bool   IncludesMax() const;
+
    friend std::ostream& operator<< (std::ostream& out, const Range& r);
 };
 
@@ -0,0 +1,97 @@
+#ifndef _MOTION_CA_REPLICA_LATTICE_HPP
+#define _MOTION_CA_REPLICA_LATTICE_HPP
+
+#include <vector>
+#include <random>
+#include <cstdint>
+
+/**
+ * 64 replicas of the majority CA on a ring lattice (see OneDLattice),
+ * stored bit-sliced: cell i of replica j is bit j of word i.
+ *
+ * Every step the number of ones in each cell's neighborhood is kept
+ * as a bit-sliced binary counter, updated with bitwise adder and
+ * subtractor circuits as the window slides along the ring, and
+ * compared against the majority threshold with a bitwise comparator,
+ * so all 64 replicas advance for the cost of one.
+ *
+ * A replica stops being updated on the first step (after the first)
+ * on which its state does not change, as random_regular does for a
+ * single lattice. Shuffle() applies the same permutation to every
+ * replica, so replicas differ only in their initial conditions.
+ */
+class ReplicaLattice
+{
+public:
+   // number of replicas run at once
+   static const int WIDTH = 64;
+
+private:
+   int                   _num_cells;
+   int                   _radius;
+   bool                  _flip;
+   std::vector<uint64_t> _old_cells;
+   std::vector<uint64_t> _cells;
+   uint64_t              _active; // replicas that are still changing
+   std::mt19937_64       _rng;
+   int                   _steps;
+
+   /**
+    * Number of distinct neighbors of every cell.
+    */
+   int Degree() const;
+
+public:
+   /**
+    * @param flip break ties by flipping the cell's state (as in
+    * MajorityRule) instead of keeping it.
+    */
+   ReplicaLattice(int num_cells, int radius, bool flip = true);
+   ~ReplicaLattice() {}
+
+   /**
+    * set the seed to be used by the RNG that initializes the cell
+    * states
+    */
+   void Seed(int s);
+
+   /**
+    * Reinitialize the first num_replicas replicas independently with
+    * the given density. The rest are cleared and never stepped, so
+    * they do not keep IsChanging() true.
+    */
+   void SetDensity(double density, int num_replicas = WIDTH);
+
+   /**
+    * Get the current density of each replica.
+    */
+   std::vector<double> GetDensities() const;
+
+   /**
+    * Get the state of every cell in replica j.
+    */
+   std::vector<int> GetStates(int j) const;
+
+   /**
+    * Step every replica that is still changing.
+    */
+   void Step();
+
+   /**
+    * Mask of the replicas whose state is still changing.
+    */
+   uint64_t ChangingMask() const;
+
+   /**
+    * Return true if any replica is still changing.
+    */
+   bool IsChanging() const;
+
+   /**
+    * Randomly shuffle the cells (the same permutation in every
+    * replica).
+    */
+   void Shuffle();
+};
+
+#endif // _MOTION_CA_REPLICA_LATTICE_HPP
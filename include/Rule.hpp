@@ -10,6 +10,38 @@ public:
     * yeilding the new state.
     */
    virtual std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const = 0;
+
+   /**
+    * Apply the rule to an agent with total neighbors, ones of which
+    * are in state 1 and the rest in state 0.
+    *
+    * Rules that only depend on these counts should override this
+    * and CountsSufficient(). By default the neighbor states are
+    * rebuilt and passed to Apply(self, neighbors).
+    */
+   virtual std::pair<int, double> Apply(int self, int ones, int total) const;
+
+   /**
+    * True if Apply(self, ones, total) is implemented directly, so
+    * callers need not collect the neighbor states.
+    */
+   virtual bool CountsSufficient() const { return false; }
+
+   /**
+    * Apply the rule to an agent whose neighbors are summarized by a
+    * histogram: counts[s] neighbors are in state s, for s less than
+    * num_states.
+    *
+    * Rules that only depend on the histogram should override this
+    * and HistogramSufficient(). By default the neighbor states are
+    * rebuilt and passed to Apply(self, neighbors).
+    */
+   virtual std::pair<int, double> Apply(int self, const int* counts, int num_states) const;
+
+   /**
+    * True if Apply(self, counts, num_states) is implemented directly.
+    */
+   virtual bool HistogramSufficient() const { return false; }
 };
 
 
@@ -18,6 +50,10 @@ public:
    Identity();
    ~Identity();
    std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override;
+   std::pair<int, double> Apply(int self, int ones, int total) const override;
+   std::pair<int, double> Apply(int self, const int* counts, int num_states) const override;
+   bool CountsSufficient() const override { return true; }
+   bool HistogramSufficient() const override { return true; }
 };
 
 class Constant : public Rule {
@@ -25,6 +61,10 @@ public:
    Constant(int c);
    ~Constant();
    std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override;
+   std::pair<int, double> Apply(int self, int ones, int total) const override;
+   std::pair<int, double> Apply(int self, const int* counts, int num_states) const override;
+   bool CountsSufficient() const override { return true; }
+   bool HistogramSufficient() const override { return true; }
 private:
    int state;
 };
@@ -34,7 +74,10 @@ public:
    MajorityRule();
    MajorityRule(bool f);
    ~MajorityRule();
+   using Rule::Apply;
    std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override;
+   std::pair<int, double> Apply(int self, int ones, int total) const override;
+   bool CountsSufficient() const override { return true; }
 private:
    bool flip = true;
 };
@@ -0,0 +1,52 @@
+#ifndef _MOTION_CA_SPLIT_MIX_64_HPP
+#define _MOTION_CA_SPLIT_MIX_64_HPP
+
+#include <cstdint>
+
+/**
+ * Steele, Lea and Flood's SplitMix64 generator: 8 bytes of state, so
+ * every agent can have its own stream where a std::mt19937_64 each
+ * would be too large. Meets the requirements of a
+ * UniformRandomBitGenerator, so it works with the <random>
+ * distributions.
+ */
+class SplitMix64
+{
+private:
+   uint64_t _state;
+
+public:
+   typedef uint64_t result_type;
+
+   explicit SplitMix64(uint64_t seed = 0) : _state(seed) {}
+
+   static constexpr result_type min() { return 0; }
+   static constexpr result_type max() { return UINT64_MAX; }
+
+   result_type operator()()
+   {
+      return Mix(_state += GAMMA);
+   }
+
+   /**
+    * The i-th output (from 0) of the generator seeded with seed,
+    * without generating the ones before it, so a stream of seeds can
+    * be handed out by index.
+    */
+   static result_type At(uint64_t seed, uint64_t i)
+   {
+      return Mix(seed + (i + 1) * GAMMA);
+   }
+
+private:
+   static constexpr uint64_t GAMMA = 0x9e3779b97f4a7c15ULL;
+
+   static uint64_t Mix(uint64_t z)
+   {
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+   }
+};
+
+#endif // _MOTION_CA_SPLIT_MIX_64_HPP
@@ -0,0 +1,97 @@
+#ifndef _MOTION_CA_STATE_BATCH_HPP
+#define _MOTION_CA_STATE_BATCH_HPP
+
+#include <vector>
+#include <random>
+#include <cstdint>
+
+/**
+ * Many binary state vectors evaluated along a single model
+ * trajectory (see Model::Step(const Rule*, StateBatch&)).
+ *
+ * The states are bit-sliced: bit j % 64 of word j / 64 of an agent
+ * holds the agent's state in vector j. Each vector converges when
+ * all of its agents agree; from then on it is no longer updated.
+ */
+class StateBatch
+{
+private:
+   int                   _num_agents;
+   int                   _num_vectors;
+   int                   _words; // words per agent
+   std::vector<uint64_t> _states;
+   std::vector<uint64_t> _active; // vectors that have not converged
+   std::vector<double>   _initial_density;
+   std::vector<int>      _ones;
+   std::vector<int>      _convergence_time;
+   int                   _steps;
+
+   /**
+    * Recount the ones in every vector and mark the vectors that
+    * have converged.
+    */
+   void Tally();
+
+public:
+   /**
+    * Create one state vector per density, drawing each agent's state
+    * independently.
+    */
+   StateBatch(int num_agents, const std::vector<double>& densities, std::mt19937_64& gen);
+   ~StateBatch() {}
+
+   int NumAgents() const;
+   int NumVectors() const;
+
+   /**
+    * Words per agent.
+    */
+   int Words() const;
+
+   /**
+    * The state words of agent a (Words() of them).
+    */
+   const uint64_t* States(int a) const;
+
+   /**
+    * Mask of the vectors in word w that are still being updated.
+    */
+   uint64_t ActiveMask(int w) const;
+
+   /**
+    * Replace the states of every agent with next (Words() words per
+    * agent) and record one time step.
+    */
+   void Update(const std::vector<uint64_t>& next);
+
+   /**
+    * The state of agent a in vector j.
+    */
+   int State(int j, int a) const;
+
+   double InitialDensity(int j) const;
+   double Density(int j) const;
+
+   /**
+    * True once every agent in vector j has the same state.
+    */
+   bool IsConverged(int j) const;
+
+   /**
+    * The step on which vector j converged, or -1.
+    */
+   int ConvergenceTime(int j) const;
+
+   /**
+    * Return true if vector j was classified correctly (see
+    * ModelStats::IsCorrect()).
+    */
+   bool IsCorrect(int j) const;
+
+   /**
+    * True once every vector has converged.
+    */
+   bool AllConverged() const;
+};
+
+#endif // _MOTION_CA_STATE_BATCH_HPP
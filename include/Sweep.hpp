@@ -0,0 +1,94 @@
+#ifndef _MOTION_CA_SWEEP_HPP
+#define _MOTION_CA_SWEEP_HPP
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Runs the replicas of an experiment at every point of a parameter
+ * sweep on a set of threads, and reduces the replicas' results to one
+ * result per point.
+ *
+ * Each (point, replica) pair is a task. The tasks are dealt out in
+ * turn to one queue per worker (task point * replicas + replica to
+ * worker task % workers), each worker runs its own queue from the
+ * back, and a worker whose queue is empty steals from the front of
+ * the others'. So a point whose runs take longer, such as an initial
+ * density near 0.5, is spread over every worker rather than holding
+ * up the one that claimed it.
+ *
+ * Results are reduced in order of replica whichever worker ran them,
+ * so a sweep gives the same results on any number of threads.
+ */
+class Sweep
+{
+private:
+   int _num_points;
+   int _num_replicas;
+   int _num_threads;
+   int _steals;
+
+   /**
+    * Run task on every (point, replica) pair. Rethrows the first
+    * exception a task throws once the workers have stopped; no task is
+    * started after one has thrown.
+    */
+   void Schedule(const std::function<void(int point, int replica)>& task);
+
+public:
+   /**
+    * A sweep of num_replicas replicas at each of num_points points, on
+    * num_threads threads, the calling thread among them. 0 threads
+    * means one per hardware thread.
+    */
+   Sweep(int num_points, int num_replicas, int num_threads = 0);
+
+   int NumPoints() const;
+   int NumReplicas() const;
+   int NumThreads() const;
+
+   /**
+    * The number of tasks the last Run() ran on a worker other than
+    * the one they were dealt to.
+    */
+   int Steals() const;
+
+   /**
+    * Run task(point, replica) for every point and replica, then fold
+    * each point's results, starting from identity, with reduce.
+    * @return the reduced result of each point.
+    */
+   template<typename Result>
+   std::vector<Result> Run(const std::function<Result(int point, int replica)>& task,
+                           const std::function<Result(const Result&, const Result&)>& reduce,
+                           const Result& identity = Result())
+   {
+      static_assert(!std::is_same<Result, bool>::value,
+                    "tasks write their results concurrently, which std::vector<bool> can't take");
+      std::vector<Result> results(static_cast<size_t>(_num_points) * _num_replicas, identity);
+      Schedule([&](int point, int replica)
+               {
+                  results[static_cast<size_t>(point) * _num_replicas + replica] = task(point, replica);
+               });
+
+      std::vector<Result> reduced(_num_points, identity);
+      for(int point = 0; point < _num_points; point++)
+      {
+         for(int replica = 0; replica < _num_replicas; replica++)
+         {
+            reduced[point] = reduce(reduced[point], results[static_cast<size_t>(point) * _num_replicas + replica]);
+         }
+      }
+      return reduced;
+   }
+
+   /**
+    * The fraction of the replicas at each point for which
+    * success(point, replica) is true.
+    */
+   std::vector<double> Proportion(const std::function<bool(int point, int replica)>& success);
+};
+
+#endif // _MOTION_CA_SWEEP_HPP
@@ -0,0 +1,70 @@
+#ifndef _MOTION_CA_THREAD_POOL_HPP
+#define _MOTION_CA_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of threads that run data-parallel loops. The threads
+ * are started once and wait between loops, so a loop per phase of a
+ * time step costs a wake-up rather than a thread launch. The calling
+ * thread does a share of every loop, and ParallelFor() returns only
+ * once every share is done, so consecutive loops are separated by a
+ * barrier.
+ */
+class ThreadPool
+{
+public:
+   /**
+    * A share of a loop: indices [begin, end), run by worker (0 is the
+    * calling thread).
+    */
+   typedef std::function<void(int begin, int end, int worker)> Task;
+
+private:
+   std::vector<std::thread> _threads;
+
+   // one loop at a time, so the pool can be shared
+   std::mutex _loop_mutex;
+
+   std::mutex              _mutex;
+   std::condition_variable _start;
+   std::condition_variable _finished;
+   const Task*             _task;
+   int                     _size;
+   int                     _running;
+   unsigned long           _generation;
+   bool                    _stop;
+   std::exception_ptr      _error;
+
+   void Work(int worker);
+   void RunShare(int worker);
+
+public:
+   /**
+    * Start num_threads - 1 threads; the caller makes up the rest.
+    */
+   ThreadPool(int num_threads);
+   ~ThreadPool();
+
+   ThreadPool(const ThreadPool&) = delete;
+   ThreadPool& operator= (const ThreadPool&) = delete;
+
+   /**
+    * The number of workers, including the calling thread.
+    */
+   int NumThreads() const;
+
+   /**
+    * Split [0, size) into one contiguous share per worker, in order of
+    * worker, and run task on every share. Rethrows the first exception
+    * a share throws once all of them have finished.
+    */
+   void ParallelFor(int size, const Task& task);
+};
+
+#endif // _MOTION_CA_THREAD_POOL_HPP
@@ -1,25 +1,153 @@
 #ifndef _TOTALISTIC_RULE_HPP
 #define _TOTALISTIC_RULE_HPP
 
+#include <atomic>
 #include <vector>
 #include <sstream>
 #include <utility>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <limits>
 
 #include "Rule.hpp"
 #include "Transition.hpp"
 
+/**
+ * A rule given by a table of transitions on the density of the
+ * neighborhood, either the mean state or the fraction of neighbors in
+ * a given state. The first transition that matches is applied; if
+ * none match the state is unchanged.
+ *
+ * Since the result only depends on the agent's own state, the number
+ * of neighbors, and the number of neighbors in state 1, the
+ * transition table is compiled into a lookup table indexed by (self,
+ * neighbor count, ones count) for binary states and up to a maximum
+ * degree. Rows for larger degrees are compiled the first time they
+ * are needed. Other states are evaluated by searching an index of the
+ * transition table with a histogram of the neighbors' states.
+ */
 class TotalisticRule : public Rule
 {
+public:
+   /**
+    * Default maximum degree of the precompiled table.
+    */
+   static const int DEFAULT_MAX_DEGREE = 32;
+
 private:
+   typedef std::pair<int, double> Result;
+
+   /**
+    * Rows of the table for degrees above max_degree_, shared by all
+    * copies of the rule. Map nodes are never moved, so a row can be
+    * read without holding the lock once it has been built: rows of
+    * degree below PUBLISHED are published with a release store once
+    * built, so that only a miss takes the lock.
+    */
+   struct LazyRows
+   {
+      static const int PUBLISHED = 4096;
+
+      std::mutex                         mutex;
+      std::map<int, std::vector<Result>> rows;
+      std::atomic<const Result*>         published[PUBLISHED];
+
+      LazyRows()
+      {
+         for(std::atomic<const Result*>& row : published)
+         {
+            row.store(nullptr, std::memory_order_relaxed);
+         }
+      }
+   };
+
+   /**
+    * The first transition matching each density, for the group of
+    * transitions that compute the density the same way: counting self
+    * or not, over the given density_state (see Transition). The range
+    * endpoints split the line into points and the open intervals
+    * between them; first_ holds the index of the first transition
+    * containing each piece, found by binary search over boundaries_.
+    */
+   struct IntervalIndex
+   {
+      bool                include_self_;
+      int                 density_state_;
+      std::vector<double> boundaries_;
+      std::vector<int>    first_;
+
+      void Build(const std::vector<Transition>& table, const std::vector<int>& group);
+
+      /**
+       * @return the index of the first matching transition, or
+       * std::numeric_limits<int>::max() if none match.
+       */
+      int Find(double density) const;
+   };
+
+   /**
+    * Transitions that apply to one pre-state, one group for each way
+    * the density is computed.
+    */
+   typedef std::vector<IntervalIndex> StateIndex;
 
    std::vector<Transition> transition_table_;
 
+   // Indexed by the pre-states named in the table; any_index_ holds
+   // the transitions for every other state.
+   std::map<int, StateIndex> state_index_;
+   StateIndex                any_index_;
+
+   // table_[2*(degree*(degree+1)/2 + ones) + self]
+   std::vector<Result>       table_;
+   int                       max_degree_;
+   std::shared_ptr<LazyRows> lazy_rows_;
+
+   /**
+    * Search the transition table.
+    * @param counts the number of neighbors in each state
+    * @param num_states the length of counts
+    */
+   Result Interpret(int self, const int* counts, int num_states) const;
+
+   /**
+    * Entries for both binary states of all neighborhoods with the
+    * given degree, laid out as in table_.
+    */
+   std::vector<Result> CompileRow(int degree) const;
+
+   void BuildIndex();
+
+   const Result* LazyRow(int degree) const;
+
 public:
-   TotalisticRule() {}
+   TotalisticRule();
    ~TotalisticRule() {}
 
+   /**
+    * Rebuild the lookup table for neighborhoods of up to max_degree
+    * neighbors.
+    */
+   void Compile(int max_degree = DEFAULT_MAX_DEGREE);
+
    std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override;
 
+   /**
+    * Look up the result for an agent in state self with total
+    * neighbors whose states sum to ones.
+    */
+   std::pair<int, double> Apply(int self, int ones, int total) const override;
+
+   /**
+    * Look up the result for an agent in state self with counts[s]
+    * neighbors in state s. Binary neighborhoods use the table.
+    */
+   std::pair<int, double> Apply(int self, const int* counts, int num_states) const override;
+
+   bool CountsSufficient() const override { return true; }
+   bool HistogramSufficient() const override { return true; }
+
    friend std::istream& operator>>(std::istream& str, TotalisticRule& rule);
 };
 
@@ -9,6 +9,11 @@ struct Transition
    bool   any_state;
    bool   include_self;
    int    pre_state;
+
+   // The range is on the fraction of the neighborhood in this state,
+   // or on the mean state if density_state is negative.
+   int    density_state;
+
    int    result_state;
    double heading_change;
    bool   result_self;
@@ -17,6 +22,7 @@ struct Transition
    Transition() :
       any_state(false),
       include_self(false),
+      density_state(-1),
       result_self(false),
       range(0.0, 1.0),
       heading_change(0.0)
@@ -1,83 +1,343 @@
 #include "Agent.hpp"
+#include "Checkpoint.hpp"
 
 #include <cmath> // M_PI
 #include <climits>
+#include <algorithm> // std::min
+#include <atomic>
 
-Agent::Agent(Point p, Heading h, double speed, double arena_size, int seed) :
+template<typename Real>
+BasicAgent<Real>::BasicAgent(Point p, Heading h, Real speed, Real arena_size, int seed) :
    _speed(speed),
    _arena_size(arena_size),
    _position(p),
    _previous_heading(h + Heading(M_PI)),
    _heading(h),
-   _gen(seed)
+   _time(0),
+   _seed(seed)
 {
-   _movement_rule = std::make_shared<MovementRule>();
+   _movement_rule = std::make_shared<BasicMovementRule<Real>>();
+   UpdateVelocity();
 }
 
-Point Agent::Position() const
+template<typename Real>
+std::mt19937_64& BasicAgent<Real>::Generator()
+{
+   if(!_gen)
+   {
+      _gen = std::make_shared<std::mt19937_64>(_seed);
+   }
+   else if(_gen.use_count() > 1)
+   {
+      _gen = std::make_shared<std::mt19937_64>(*_gen);
+   }
+   else
+   {
+      // a copy on another thread may just have finished copying it
+      std::atomic_thread_fence(std::memory_order_acquire);
+   }
+   return *_gen;
+}
+
+template<typename Real>
+BasicMovementRule<Real>& BasicAgent<Real>::OwnMovementRule()
+{
+   if(_movement_rule.use_count() > 1)
+   {
+      _movement_rule = _movement_rule->Clone();
+   }
+   else
+   {
+      // as in Generator()
+      std::atomic_thread_fence(std::memory_order_acquire);
+   }
+   return *_movement_rule;
+}
+
+template<typename Real>
+void BasicAgent<Real>::Reseed(uint64_t seed)
+{
+   _seed = seed;
+   _gen = nullptr;
+}
+
+template<typename Real>
+void BasicAgent<Real>::Reset(Point p, Heading h, int seed)
+{
+   _position = p;
+   _heading = h;
+   _previous_heading = h + Heading(M_PI);
+   _time = 0;
+   dark_ = false;
+   _seed = seed;
+   if(_gen && _gen.use_count() == 1)
+   {
+      _gen->seed(_seed);
+   }
+   else
+   {
+      _gen = nullptr;
+   }
+   OwnMovementRule().Reset();
+   UpdateVelocity();
+}
+
+template<typename Real>
+void BasicAgent<Real>::UpdateVelocity()
+{
+   _dx = _speed * _heading.Cos();
+   _dy = _speed * _heading.Sin();
+}
+
+template<typename Real>
+BasicPoint<Real> BasicAgent<Real>::Position() const
 {
    return _position;
 }
 
-Heading Agent::GetHeading() const
+template<typename Real>
+BasicHeading<Real> BasicAgent<Real>::GetHeading() const
 {
    return _heading;
 }
 
-Heading Agent::GetPreviousHeading() const
+template<typename Real>
+BasicHeading<Real> BasicAgent<Real>::GetPreviousHeading() const
 {
    return _previous_heading;
 }
 
-void Agent::SetHeading(Heading h)
+template<typename Real>
+void BasicAgent<Real>::SetHeading(Heading h)
 {
-   _heading = h;
+   if(h != _heading)
+   {
+      _heading = h;
+      UpdateVelocity();
+   }
 }
 
-void Agent::Step()
+template<typename Real>
+void BasicAgent<Real>::Step()
 {
-   double dx = _speed * cos(_heading.Radians());
-   double dy = _speed * sin(_heading.Radians());
-   _position = Point(_position.GetX() + dx, _position.GetY() + dy);
+   _position = Point(_position.GetX() + _dx, _position.GetY() + _dy);
    while(IsOutOfBounds(_position))
    {
       _position = Reflect(_position);
    }
    _previous_heading = _heading;
+   _time++;
 
    if(!dark_)
    {
       // only turn if in interactive mode.
-      _heading = _movement_rule->Turn(_position, _heading, _gen);
+      SetHeading(OwnMovementRule().Turn(_position, _heading, Generator()));
+   }
+}
+
+template<typename Real>
+int BasicAgent<Real>::Time() const
+{
+   return _time;
+}
+
+template<typename Real>
+BasicPoint<Real> BasicAgent<Real>::Velocity() const
+{
+   return Point(_dx, _dy);
+}
+
+template<typename Real>
+int BasicAgent<Real>::StraightSteps() const
+{
+   if(dark_)
+   {
+      return INT_MAX; // dark agents never turn
    }
+   return std::min(_movement_rule->StraightSteps(), (unsigned int)INT_MAX);
 }
 
-void Agent::GoDark()
+template<typename Real>
+long BasicAgent<Real>::Fold(Real u, Real& folded) const
+{
+   // the arena tiles the line with period 2*_arena_size; every other
+   // copy is a mirror image.
+   Real shifted = u + _arena_size/2;
+   Real cell    = std::floor(shifted / _arena_size);
+   Real offset  = shifted - cell*_arena_size;
+   long   n       = (long)cell;
+   if(n % 2 == 0)
+   {
+      folded = offset - _arena_size/2;
+   }
+   else
+   {
+      folded = _arena_size/2 - offset;
+   }
+   return n;
+}
+
+template<typename Real>
+BasicPoint<Real> BasicAgent<Real>::PositionAfter(int k) const
+{
+   Real x, y;
+   Fold(_position.GetX() + _dx*k, x);
+   Fold(_position.GetY() + _dy*k, y);
+   return Point(x, y);
+}
+
+template<typename Real>
+BasicPoint<Real> BasicAgent<Real>::VelocityAfter(int k) const
+{
+   Real x, y;
+   long nx = Fold(_position.GetX() + _dx*k, x);
+   long ny = Fold(_position.GetY() + _dy*k, y);
+   return Point(nx % 2 == 0 ? _dx : -_dx, ny % 2 == 0 ? _dy : -_dy);
+}
+
+template<typename Real>
+int BasicAgent<Real>::StepsToWall(Real x, Real d, int k) const
+{
+   if(d == 0) return INT_MAX;
+
+   Real folded;
+   long cell = Fold(x + d*k, folded);
+   // distance (in the direction of travel) to the next wall
+   Real boundary = (cell + (d > 0 ? 1 : 0)) * _arena_size - _arena_size/2;
+   Real steps    = (boundary - x) / d;
+   if(steps >= (Real)INT_MAX) return INT_MAX;
+
+   // j is the first step that ends in a different copy of the arena;
+   // correct for rounding in the division.
+   long j = std::max((long)std::ceil(steps), (long)k + 1);
+   while(j > k + 1 && Fold(x + d*(j-1), folded) != cell) j--;
+   while(Fold(x + d*j, folded) == cell) j++;
+   return j - k - 1;
+}
+
+template<typename Real>
+int BasicAgent<Real>::StepsToWall(int k) const
+{
+   return std::min(StepsToWall(_position.GetX(), _dx, k),
+                   StepsToWall(_position.GetY(), _dy, k));
+}
+
+template<typename Real>
+void BasicAgent<Real>::Advance(int k)
+{
+   if(k <= 0) return;
+
+   Real x, y;
+   long nx = Fold(_position.GetX() + _dx*k, x);
+   long ny = Fold(_position.GetY() + _dy*k, y);
+   _position = Point(x, y);
+   if(nx % 2 != 0)
+   {
+      _heading = Heading(M_PI) - _heading;
+      _dx = -_dx;
+   }
+   if(ny % 2 != 0)
+   {
+      _heading = Heading(2*M_PI) - _heading;
+      _dy = -_dy;
+   }
+   _previous_heading = _heading;
+   _time += k;
+
+   if(!dark_)
+   {
+      OwnMovementRule().Skip(k);
+   }
+}
+
+template<typename Real>
+void BasicAgent<Real>::GoDark()
 {
    dark_ = true;
 }
 
-void Agent::GoInteractive()
+template<typename Real>
+void BasicAgent<Real>::GoInteractive()
 {
    dark_ = false;
 }
 
-bool Agent::IsDark() const
+template<typename Real>
+bool BasicAgent<Real>::IsDark() const
 {
    return dark_;
 }
 
-bool Agent::IsInteractive() const
+template<typename Real>
+bool BasicAgent<Real>::IsInteractive() const
 {
    return !IsDark();
 }
 
-void Agent::SetMovementRule(std::shared_ptr<MovementRule> rule)
+template<typename Real>
+void BasicAgent<Real>::SetMovementRule(std::shared_ptr<BasicMovementRule<Real>> rule)
 {
    _movement_rule = rule;
 }
 
-bool Agent::IsOutOfBounds(const Point& p) const
+template<typename Real>
+std::shared_ptr<BasicMovementRule<Real>> BasicAgent<Real>::GetMovementRule() const
+{
+   return _movement_rule;
+}
+
+template<typename Real>
+void BasicAgent<Real>::Save(std::ostream& out) const
+{
+   checkpoint::Write(out, _position.GetX());
+   checkpoint::Write(out, _position.GetY());
+   _heading.Save(out);
+   _previous_heading.Save(out);
+   checkpoint::Write(out, _speed);
+   checkpoint::Write(out, _dx); // negated on reflection, not recomputed
+   checkpoint::Write(out, _dy);
+   checkpoint::Write(out, _arena_size);
+   checkpoint::Write(out, _time);
+   checkpoint::Write(out, _next_update);
+   checkpoint::Write(out, dark_);
+   checkpoint::Write(out, go_dark_.p());
+   _movement_rule->Save(out);
+   checkpoint::Write(out, _seed);
+   checkpoint::Write<bool>(out, _gen != nullptr);
+   if(_gen)
+   {
+      checkpoint::WriteEngine(out, *_gen);
+   }
+}
+
+template<typename Real>
+void BasicAgent<Real>::Restore(std::istream& in, const std::shared_ptr<MovementRule>& previous_rule)
+{
+   Real x = checkpoint::Read<Real>(in);
+   Real y = checkpoint::Read<Real>(in);
+   _position = Point(x, y);
+   _heading.Restore(in);
+   _previous_heading.Restore(in);
+   _speed = checkpoint::Read<Real>(in);
+   _dx = checkpoint::Read<Real>(in);
+   _dy = checkpoint::Read<Real>(in);
+   _arena_size = checkpoint::Read<Real>(in);
+   _time = checkpoint::Read<int>(in);
+   _next_update = checkpoint::Read<int>(in);
+   dark_ = checkpoint::Read<bool>(in);
+   go_dark_ = std::bernoulli_distribution(checkpoint::Read<double>(in));
+   _movement_rule = MovementRule::Load(in, previous_rule);
+   _seed = checkpoint::Read<uint64_t>(in);
+   _gen = nullptr;
+   if(checkpoint::Read<bool>(in))
+   {
+      _gen = std::make_shared<std::mt19937_64>();
+      checkpoint::ReadEngine(in, *_gen);
+   }
+}
+
+template<typename Real>
+bool BasicAgent<Real>::IsOutOfBounds(const Point& p) const
 {
    return p.GetX() < (-_arena_size / 2)
                      || p.GetX() > (_arena_size / 2)
@@ -85,27 +345,37 @@ bool Agent::IsOutOfBounds(const Point& p) const
                     || p.GetY() > (_arena_size / 2);
 }
 
-Point Agent::Reflect(const Point& p)
+template<typename Real>
+BasicPoint<Real> BasicAgent<Real>::Reflect(const Point& p)
 {
-   double new_x = p.GetX();
-   double new_y = p.GetY();
+   Real new_x = p.GetX();
+   Real new_y = p.GetY();
+   // The cached displacement is reflected by flipping its sign; the
+   // angular heading is kept in sync for callers of GetHeading().
    if(p.GetX() > _arena_size/2) {
       new_x = _arena_size/2 - (p.GetX() - _arena_size / 2);
       _heading = Heading(M_PI) - _heading;
+      _dx = -_dx;
    }
    else if(p.GetX() < -_arena_size/2) {
       new_x = -_arena_size/2 - (p.GetX() + _arena_size / 2);
       _heading = Heading(M_PI) - _heading;
+      _dx = -_dx;
    }
 
    if(p.GetY() > _arena_size/2) {
       new_y = _arena_size/2 - (p.GetY() - _arena_size/2);
       _heading = Heading(2*M_PI) - _heading;
+      _dy = -_dy;
    }
    else if(p.GetY() < -_arena_size/2) {
       new_y = -_arena_size/2 - (p.GetY() + _arena_size/2);
       _heading = Heading(2*M_PI) - _heading;
+      _dy = -_dy;
    }
 
    return Point(new_x, new_y);
 }
+
+template class BasicAgent<float>;
+template class BasicAgent<double>;
@@ -0,0 +1,25 @@
+#include "CompiledRules.hpp"
+
+std::shared_ptr<Rule> MakeCompiledRule(const std::string& name)
+{
+   for(const CompiledRule& rule : CompiledRules())
+   {
+      if(rule.name == name)
+      {
+         return rule.make();
+      }
+   }
+   return nullptr;
+}
+
+std::shared_ptr<Rule> MakeCompiledRuleFromSource(const std::string& source)
+{
+   for(const CompiledRule& rule : CompiledRules())
+   {
+      if(rule.source == source)
+      {
+         return rule.make();
+      }
+   }
+   return nullptr;
+}
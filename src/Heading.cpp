@@ -1,45 +1,202 @@
 #include "Heading.hpp"
+#include "Checkpoint.hpp"
 
 #include <cmath> // M_PI
 
-Heading::Heading(double h)
+#ifdef FIXED_POINT_HEADING
+
+#include <vector>
+
+#ifndef HEADING_TRIG_TABLE_BITS
+#define HEADING_TRIG_TABLE_BITS 12
+#endif
+
+namespace
+{
+   const double UNITS_PER_RADIAN = 4294967296.0 / (2*M_PI);
+   const double RADIANS_PER_UNIT = (2*M_PI) / 4294967296.0;
+
+   const int      TABLE_SHIFT = 32 - HEADING_TRIG_TABLE_BITS;
+   const uint32_t TABLE_MASK  = (1u << HEADING_TRIG_TABLE_BITS) - 1;
+   const uint32_t QUARTER     = 1u << 30;
+
+   /**
+    * Cosine of the angle at the center of each table entry.
+    */
+   const std::vector<double>& cos_table()
+   {
+      static const std::vector<double> table = []() {
+         std::vector<double> t(1u << HEADING_TRIG_TABLE_BITS);
+         for(uint32_t i = 0; i < t.size(); i++)
+         {
+            t[i] = cos((double)((uint64_t)i << TABLE_SHIFT) * RADIANS_PER_UNIT);
+         }
+         return t;
+      }();
+      return table;
+   }
+
+   double lookup_cos(uint32_t angle)
+   {
+      // round to the nearest entry (the addition wraps around at 2pi)
+      uint32_t rounded = angle + ((1u << TABLE_SHIFT) >> 1);
+      return cos_table()[(rounded >> TABLE_SHIFT) & TABLE_MASK];
+   }
+}
+
+template<typename Real>
+BasicHeading<Real>::BasicHeading(Real h)
+{
+   // conversion to uint32_t is modulo 2^32, which normalizes the angle.
+   _angle = (uint32_t)llrint(h * UNITS_PER_RADIAN);
+}
+
+template<typename Real>
+BasicHeading<Real>::BasicHeading()
+{
+   _angle = 0;
+}
+
+template<typename Real>
+BasicHeading<Real>::~BasicHeading() {}
+
+template<typename Real>
+Real BasicHeading<Real>::Radians() const
+{
+   Real radians = _angle * RADIANS_PER_UNIT;
+   // in single precision angles just short of a full turn round up to it
+   return radians < (Real)(2*M_PI) ? radians : 0;
+}
+
+template<typename Real>
+Real BasicHeading<Real>::Cos() const
+{
+   return lookup_cos(_angle);
+}
+
+template<typename Real>
+Real BasicHeading<Real>::Sin() const
+{
+   return lookup_cos(_angle - QUARTER);
+}
+
+template<typename Real>
+bool BasicHeading<Real>::operator== (const BasicHeading& h) const
 {
-   _heading_radians = h - floor(h/(2*M_PI)) * 2*M_PI;
+   return _angle == h._angle;
 }
 
-Heading::Heading()
+template<typename Real>
+BasicHeading<Real> BasicHeading<Real>::operator+ (const BasicHeading& h) const
+{
+   BasicHeading sum;
+   sum._angle = _angle + h._angle;
+   return sum;
+}
+
+template<typename Real>
+BasicHeading<Real> BasicHeading<Real>::operator- (const BasicHeading& h) const
+{
+   BasicHeading difference;
+   difference._angle = _angle - h._angle;
+   return difference;
+}
+
+#else // FIXED_POINT_HEADING
+
+template<typename Real>
+BasicHeading<Real>::BasicHeading(Real h)
+{
+   const Real turn = (Real)(2*M_PI);
+   _heading_radians = h - std::floor(h/turn) * turn;
+   // in single precision a tiny negative angle can round up to a full turn
+   if(_heading_radians >= turn)
+   {
+      _heading_radians = 0;
+   }
+}
+
+template<typename Real>
+BasicHeading<Real>::BasicHeading()
 {
    _heading_radians = 0;
 }
 
-Heading::~Heading() {}
+template<typename Real>
+BasicHeading<Real>::~BasicHeading() {}
 
-double Heading::Radians() const
+template<typename Real>
+Real BasicHeading<Real>::Radians() const
 {
    return _heading_radians;
 }
 
-bool operator== (const Heading& h1, const Heading& h2)
+template<typename Real>
+Real BasicHeading<Real>::Cos() const
 {
-   return h1._heading_radians == h2._heading_radians;
+   return std::cos(_heading_radians);
 }
 
-bool operator!= (const Heading& h1, const Heading& h2)
+template<typename Real>
+Real BasicHeading<Real>::Sin() const
 {
-   return !(h1 == h2);
+   return std::sin(_heading_radians);
 }
 
-Heading operator+ (const Heading& h1, const Heading& h2)
+template<typename Real>
+bool BasicHeading<Real>::operator== (const BasicHeading& h) const
 {
-   return Heading(h1._heading_radians + h2._heading_radians);
+   return _heading_radians == h._heading_radians;
 }
 
-Heading operator- (const Heading& h1, const Heading& h2)
+template<typename Real>
+BasicHeading<Real> BasicHeading<Real>::operator+ (const BasicHeading& h) const
 {
-   return Heading(h1._heading_radians - h2._heading_radians);
+   return BasicHeading(_heading_radians + h._heading_radians);
 }
 
-std::ostream& operator<<(std::ostream& out, const Heading& h)
+template<typename Real>
+BasicHeading<Real> BasicHeading<Real>::operator- (const BasicHeading& h) const
 {
-   return out << "Heading(" << h._heading_radians << ")";
+   return BasicHeading(_heading_radians - h._heading_radians);
 }
+
+#endif // FIXED_POINT_HEADING
+
+template<typename Real>
+void BasicHeading<Real>::Save(std::ostream& out) const
+{
+#ifdef FIXED_POINT_HEADING
+   checkpoint::Write(out, _angle);
+#else
+   checkpoint::Write(out, _heading_radians);
+#endif
+}
+
+template<typename Real>
+void BasicHeading<Real>::Restore(std::istream& in)
+{
+#ifdef FIXED_POINT_HEADING
+   _angle = checkpoint::Read<uint32_t>(in);
+#else
+   _heading_radians = checkpoint::Read<Real>(in);
+#endif
+}
+
+template<typename Real>
+bool BasicHeading<Real>::operator!= (const BasicHeading& h) const
+{
+   return !(*this == h);
+}
+
+template<typename Real>
+std::ostream& operator<<(std::ostream& out, const BasicHeading<Real>& h)
+{
+   return out << "Heading(" << h.Radians() << ")";
+}
+
+template class BasicHeading<float>;
+template class BasicHeading<double>;
+
+template std::ostream& operator<< (std::ostream&, const BasicHeading<float>&);
+template std::ostream& operator<< (std::ostream&, const BasicHeading<double>&);
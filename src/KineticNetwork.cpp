@@ -0,0 +1,228 @@
+#include "KineticNetwork.hpp"
+#include "Checkpoint.hpp"
+
+#include <climits>
+#include <cmath>
+#include <algorithm>
+
+template<typename Real>
+BasicKineticNetwork<Real>::BasicKineticNetwork() :
+   _communication_range(0),
+   _network(0)
+{}
+
+template<typename Real>
+void BasicKineticNetwork<Real>::Init(const std::vector<Agent>& agents, Real communication_range, int t)
+{
+   int n = agents.size();
+   _communication_range = communication_range;
+   _network = NetworkSnapshot(n);
+   _pieces.assign(n, Piece());
+   _turn_time.assign(n, INT_MAX);
+   _agent_event.assign(n, INT_MAX);
+   _agent_version.assign(n, 0);
+   _events = EventQueue();
+
+   for(int i = 0; i < n; i++)
+   {
+      Schedule(agents, i, t, true);
+   }
+   for(int i = 0; i < n; i++)
+   {
+      for(int j = i+1; j < n; j++)
+      {
+         UpdatePair(i, j, t);
+      }
+   }
+}
+
+template<typename Real>
+void BasicKineticNetwork<Real>::Schedule(const std::vector<Agent>& agents, int i, int t, bool turned)
+{
+   const Agent& agent = agents[i];
+   int k = t - agent.Time();
+   if(turned)
+   {
+      int straight = agent.StraightSteps();
+      _turn_time[i] = straight >= INT_MAX - t ? INT_MAX : t + straight + 1;
+   }
+
+   BasicPoint<Real> position = agent.PositionAfter(k);
+   BasicPoint<Real> velocity = agent.VelocityAfter(k);
+   _pieces[i] = Piece{position.GetX(), position.GetY(), velocity.GetX(), velocity.GetY(), t};
+
+   int wall = agent.StepsToWall(k);
+   int next = wall >= INT_MAX - t ? INT_MAX : t + wall + 1;
+   _agent_event[i] = std::min(next, _turn_time[i]);
+   _agent_version[i]++;
+   if(_agent_event[i] != INT_MAX)
+   {
+      _events.push(Event{_agent_event[i], i, -1, _agent_version[i], 0});
+   }
+}
+
+template<typename Real>
+void BasicKineticNetwork<Real>::UpdatePair(int i, int j, int t)
+{
+   const Piece& pi = _pieces[i];
+   const Piece& pj = _pieces[j];
+   Real dx = (pj.x + pj.vx*(t - pj.time)) - (pi.x + pi.vx*(t - pi.time));
+   Real dy = (pj.y + pj.vy*(t - pj.time)) - (pi.y + pi.vy*(t - pi.time));
+
+   // same test as Point::Within()
+   bool linked = std::sqrt(dx*dx + dy*dy) <= _communication_range;
+   if(linked != _network.HasEdge(i, j))
+   {
+      if(linked) _network.AddEdge(i, j);
+      else       _network.RemoveEdge(i, j);
+   }
+
+   // both trajectories are linear until the earlier agent event, which
+   // recomputes this pair.
+   int end = std::min(_agent_event[i], _agent_event[j]);
+   if(end <= t + 1) return;
+
+   // |d + s*v|^2 - r^2, s steps from now
+   Real vx = pj.vx - pi.vx;
+   Real vy = pj.vy - pi.vy;
+   Real a = vx*vx + vy*vy;
+   if(a == 0) return; // the distance never changes
+
+   Real b = 2*(dx*vx + dy*vy);
+   Real c = dx*dx + dy*dy - _communication_range*_communication_range;
+   Real discriminant = b*b - 4*a*c;
+   double next;
+   if(linked)
+   {
+      // the edge goes down on the first step past the larger root
+      double s2 = discriminant < 0 ? 0.0 : (-b + std::sqrt(discriminant)) / (2*a);
+      next = t + std::max(std::floor(s2) + 1, 1.0);
+   }
+   else
+   {
+      if(discriminant < 0) return;
+      double root = std::sqrt(discriminant);
+      double s1 = (-b - root) / (2*a);
+      double s2 = (-b + root) / (2*a);
+      double s  = std::max(std::ceil(s1), 1.0);
+      if(s > s2) return;
+      next = t + s;
+   }
+
+   // certificates are re-checked exactly when their event fires, so
+   // rounding in the roots only costs an extra event.
+   if(next < end)
+   {
+      int a = std::min(i, j), b = std::max(i, j);
+      _events.push(Event{(int)next, a, b, _agent_version[a], _agent_version[b]});
+   }
+}
+
+template<typename Real>
+void BasicKineticNetwork<Real>::Advance(std::vector<Agent>& agents, int t)
+{
+   while(!_events.empty() && _events.top().time <= t)
+   {
+      Event e = _events.top();
+      _events.pop();
+
+      if(e.j < 0)
+      {
+         if(e.version != _agent_version[e.i]) continue;
+
+         bool turned = e.time == _turn_time[e.i];
+         if(turned)
+         {
+            // the move on the turn step still uses the old heading
+            Sync(agents, e.i, e.time - 1);
+            agents[e.i].Step();
+         }
+         Schedule(agents, e.i, e.time, turned);
+         for(int j = 0; j < (int)agents.size(); j++)
+         {
+            if(j != e.i) UpdatePair(e.i, j, e.time);
+         }
+      }
+      else
+      {
+         if(e.version != _agent_version[e.i] || e.version_j != _agent_version[e.j]) continue;
+         UpdatePair(e.i, e.j, e.time);
+      }
+   }
+}
+
+template<typename Real>
+void BasicKineticNetwork<Real>::Sync(std::vector<Agent>& agents, int i, int t) const
+{
+   agents[i].Advance(t - agents[i].Time());
+}
+
+template<typename Real>
+void BasicKineticNetwork<Real>::SyncAll(std::vector<Agent>& agents, int t) const
+{
+   for(int i = 0; i < (int)agents.size(); i++)
+   {
+      Sync(agents, i, t);
+   }
+}
+
+template<typename Real>
+void BasicKineticNetwork<Real>::Touch(const std::vector<Agent>& agents, int i, int t)
+{
+   Schedule(agents, i, t, true);
+   for(int j = 0; j < (int)agents.size(); j++)
+   {
+      if(j != i) UpdatePair(i, j, t);
+   }
+}
+
+template<typename Real>
+const NetworkSnapshot& BasicKineticNetwork<Real>::Snapshot() const
+{
+   return _network;
+}
+
+template<typename Real>
+void BasicKineticNetwork<Real>::Save(std::ostream& out) const
+{
+   checkpoint::Write(out, _communication_range);
+   _network.Save(out);
+   checkpoint::WriteVector(out, _pieces);
+   checkpoint::WriteVector(out, _turn_time);
+   checkpoint::WriteVector(out, _agent_event);
+   checkpoint::WriteVector(out, _agent_version);
+   checkpoint::WriteVector(out, _events.Heap());
+}
+
+template<typename Real>
+void BasicKineticNetwork<Real>::Restore(std::istream& in)
+{
+   _communication_range = checkpoint::Read<Real>(in);
+   _network.Restore(in);
+   checkpoint::ReadVector(in, _pieces);
+   checkpoint::ReadVector(in, _turn_time);
+   checkpoint::ReadVector(in, _agent_event);
+   checkpoint::ReadVector(in, _agent_version);
+   checkpoint::ReadVector(in, _events.Heap());
+
+   int n = _pieces.size();
+   if(_network.Size() != n || (int)_turn_time.size() != n || (int)_agent_event.size() != n
+      || (int)_agent_version.size() != n)
+   {
+      throw checkpoint::Error("bad kinetic network");
+   }
+   for(const Event& e : _events.Heap())
+   {
+      if(e.i < 0 || e.i >= n || e.j < -1 || e.j >= n)
+      {
+         throw checkpoint::Error("bad kinetic network event");
+      }
+   }
+   if(!std::is_heap(_events.Heap().begin(), _events.Heap().end(), std::greater<Event>()))
+   {
+      throw checkpoint::Error("bad kinetic network event queue");
+   }
+}
+
+template class BasicKineticNetwork<float>;
+template class BasicKineticNetwork<double>;
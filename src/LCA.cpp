@@ -1,28 +1,91 @@
 #include "LCA.hpp"
 
-LCA::LCA(const Model& model, std::shared_ptr<Rule> rule, int max_time) :
-   model_(std::make_unique<Model>(model)),
+#include <algorithm> // std::max
+#include <cstdio>    // std::rename
+#include <fstream>
+#include <stdexcept>
+
+#include "Checkpoint.hpp"
+
+LCA::LCA(const ModelInterface& model, std::shared_ptr<Rule> rule, int max_time) :
+   model_(model.Clone()),
+   max_time_(max_time),
+   update_rule_(rule)
+{}
+
+LCA::LCA(std::unique_ptr<ModelInterface> model, std::shared_ptr<Rule> rule, int max_time) :
+   model_(std::move(model)),
    max_time_(max_time),
    update_rule_(rule)
 {}
 
-LCA::~LCA() {}
+LCA::LCA(std::istream& checkpoint, std::shared_ptr<Rule> rule) :
+   model_(RestoreModel(checkpoint)),
+   update_rule_(rule)
+{
+   max_time_ = checkpoint::Read<int>(checkpoint);
+   steps_ = checkpoint::Read<int>(checkpoint);
+}
+
+LCA::~LCA()
+{
+   if(recycler_ && !model_exposed_)
+   {
+      recycler_(std::move(model_));
+   }
+}
+
+void LCA::Reset(int seed, double initial_density)
+{
+   model_->Reset(seed, initial_density);
+   steps_ = 0;
+}
+
+void LCA::SetModelRecycler(std::function<void(std::unique_ptr<ModelInterface>)> recycler)
+{
+   recycler_ = recycler;
+}
+
+void LCA::Step()
+{
+   model_->Step(update_rule_.get());
+   steps_++;
+   if(checkpoint_interval_ > 0 && steps_ % checkpoint_interval_ == 0)
+   {
+      std::string temporary = checkpoint_path_ + ".tmp";
+      {
+         std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+         Checkpoint(out);
+         out.close();
+         if(!out)
+         {
+            throw std::runtime_error("can't write checkpoint " + temporary);
+         }
+      }
+      if(std::rename(temporary.c_str(), checkpoint_path_.c_str()) != 0)
+      {
+         throw std::runtime_error("can't replace checkpoint " + checkpoint_path_);
+      }
+   }
+}
 
 void LCA::Run()
 {
-   for(int i = 0; i < max_time_; i++)
+   model_->ReserveSteps(std::max(max_time_ - steps_, 0));
+   while(steps_ < max_time_)
    {
-      model_->Step(update_rule_.get());
+      Step();
    }
 }
 
 int LCA::Run(std::function<bool(const ModelStats&)> early_stop)
 {
-   for(int i = 0; i < max_time_; i++)
+   model_->ReserveSteps(std::max(max_time_ - steps_, 0));
+   while(steps_ < max_time_)
    {
       if(early_stop(GetStats()))
-         return i;
-      model_->Step(update_rule_.get());
+         return steps_;
+      Step();
    }
 
    return max_time_;
@@ -32,16 +95,33 @@ void LCA::Run(int k)
 {
    for(int i = 0; i < k; i++)
    {
-      model_->Step(update_rule_.get());
+      Step();
    }
 }
 
+int LCA::Run(StateBatch& batch)
+{
+   for(int i = 0; i < max_time_; i++)
+   {
+      if(batch.AllConverged())
+         return i;
+      model_->Step(update_rule_.get(), batch);
+   }
+
+   return max_time_;
+}
+
 const std::vector<Agent>& LCA::GetAgents() const
 {
-   return model_->GetAgents();
+   const Model* model = dynamic_cast<const Model*>(model_.get());
+   if(model == nullptr)
+   {
+      throw std::logic_error("GetAgents() requires a double precision model");
+   }
+   return model->GetAgents();
 }
 
-const std::vector<int>& LCA::GetStates() const
+const std::vector<AgentState>& LCA::GetStates() const
 {
    return model_->GetStates();
 }
@@ -65,3 +145,47 @@ void LCA::MinimizeMemory()
 {
    model_->RecordNetworkDensityOnly();
 }
+
+void LCA::RecordConvergenceOnly()
+{
+   model_->RecordConvergenceOnly();
+}
+
+void LCA::AddObserver(std::shared_ptr<Observer> observer, int interval)
+{
+   model_->AddObserver(observer, interval);
+}
+
+void LCA::Checkpoint(std::ostream& out) const
+{
+   model_->Checkpoint(out);
+   checkpoint::Write(out, max_time_);
+   checkpoint::Write(out, steps_);
+   if(!out)
+   {
+      throw std::runtime_error("checkpoint: write failed");
+   }
+}
+
+void LCA::SetCheckpointing(const std::string& path, int interval)
+{
+   if(interval < 0)
+   {
+      throw std::invalid_argument("checkpoint interval must not be negative");
+   }
+   checkpoint_path_ = path;
+   checkpoint_interval_ = interval;
+}
+
+std::unique_ptr<LCA> LCA::Fork(uint64_t stream) const
+{
+   std::unique_ptr<LCA> branch = std::make_unique<LCA>(model_->Fork(stream), update_rule_, max_time_);
+   branch->steps_ = steps_;
+   return branch;
+}
+
+ModelInterface& LCA::GetModel()
+{
+   model_exposed_ = true;
+   return *model_;
+}
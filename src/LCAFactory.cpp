@@ -5,9 +5,48 @@
 #include <sstream>
 #include <streambuf>
 #include <fstream>
+#include <unordered_map>
+#include <vector>
 
+#include "CompiledRules.hpp"
+#include "SplitMix64.hpp"
 #include "TotalisticRule.hpp"
 
+namespace
+{
+   // A factory's recycled models on one thread, and the pool id that
+   // the factory holds for as long as the models fit its settings.
+   struct ModelPool
+   {
+      std::weak_ptr<const uint64_t>                owner;
+      std::vector<std::unique_ptr<ModelInterface>> models;
+   };
+
+   // Each factory's recycled models on this thread, by pool id. Pools
+   // are only touched by Build() and its recyclers, never by a
+   // factory's destructor, which may run (for a static factory) after
+   // this thread's objects are gone.
+   thread_local std::unordered_map<uint64_t, ModelPool> recycled_models;
+
+   /**
+    * Free the pools on this thread of factories that have gone or
+    * changed their settings.
+    */
+   void purge_recycled_models()
+   {
+      for(auto pool = recycled_models.begin(); pool != recycled_models.end();)
+      {
+         if(pool->second.owner.expired()) pool = recycled_models.erase(pool);
+         else                             ++pool;
+      }
+   }
+
+   // models kept per factory on each thread
+   const size_t MAX_RECYCLED = 4;
+
+   std::atomic<uint64_t> next_pool_id(0);
+}
+
 LCAFactory::LCAFactory() :
    num_agents_(255),
    communication_range_(5),
@@ -15,18 +54,24 @@ LCAFactory::LCAFactory() :
    speed_(1),
    seed_(-1),
    max_time_(5000),
+   next_request_(0),
+   pool_id_(std::make_shared<const uint64_t>(next_pool_id++)),
+   movement_(Random),
    init_(Uniform)
 {
    rule_ = std::make_unique<Identity>();
-   movement_rule_ = std::make_shared<RandomWalk>();
-   seed_distribution_ = std::uniform_int_distribution<int>(0, std::numeric_limits<int>::max());
 }
 
+LCAFactory::~LCAFactory() {}
+
 int LCAFactory::Init(int argc, char** argv)
 {
    int by_position = 0;
+   int event_driven = 0;
+   int single_precision = 0;
+   int shared_trajectory = 0;
 
-   static struct option long_options[] =
+   struct option long_options[] =
       {
          {"communication-range", required_argument, 0,            'r'},
          {"num-agents",          required_argument, 0,            'n'},
@@ -39,11 +84,17 @@ int LCAFactory::Init(int argc, char** argv)
          {"rule",                required_argument, 0,            'R'},
          {"pdark",               required_argument, 0,            'd'},
          {"pinteractive",        required_argument, 0,            'i'},
+         {"levy",                required_argument, 0,            'l'},
+         {"event-driven",        no_argument,       &event_driven, 'e'},
+         {"single-precision",    no_argument,       &single_precision, 'f'},
+         {"shared-trajectory",   no_argument,       &shared_trajectory, 'm'},
+         {"step-threads",        required_argument, 0,            't'},
          {0,0,0,0}
       };
    int option_index = 0;
    char opt_char;
    std::ifstream file;
+   std::string source;
    TotalisticRule r;
    while((opt_char = getopt_long(argc, argv, "r:n:a:s:S:c:R:T:",
                                  long_options, &option_index)) != -1)
@@ -59,6 +110,14 @@ int LCAFactory::Init(int argc, char** argv)
          pinteractive_ = atof(optarg);
          break;
 
+      case 'l':
+         levy_mu_ = atof(optarg);
+         break;
+
+      case 't':
+         step_threads_ = atoi(optarg);
+         break;
+
       case 'r':
          communication_range_ = atof(optarg);
          break;
@@ -84,14 +143,29 @@ int LCAFactory::Init(int argc, char** argv)
          break;
 
       case 'c':
-         movement_rule_ = std::make_shared<CorrelatedRandomWalk>(atof(optarg));
+         movement_ = Correlated;
+         sigma_ = atof(optarg);
          break;
 
       case 'R':
-         file = std::ifstream(std::string(optarg));
-         file >> r;
+         // A compiled kernel by name, then a file compiled into a
+         // kernel, then the interpreter.
+         rule_ = MakeCompiledRule(optarg);
+         if(rule_)
+         {
+            break;
+         }
 
-         rule_ = std::make_shared<TotalisticRule>(r);
+         file = std::ifstream(std::string(optarg));
+         source.assign(std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>());
+         rule_ = MakeCompiledRuleFromSource(source);
+         if(!rule_)
+         {
+            std::istringstream rule_stream(source);
+            rule_stream >> r;
+            rule_ = std::make_shared<TotalisticRule>(r);
+         }
 
          break;
 
@@ -111,42 +185,151 @@ int LCAFactory::Init(int argc, char** argv)
       init_ = ByPosition;
    }
 
+   event_driven_ = event_driven != 0;
+   single_precision_ = single_precision != 0;
+   shared_trajectory_ = shared_trajectory != 0;
+
+   if(levy_mu_ > 0)
+   {
+      movement_ = Levy;
+   }
+
    if(seed_ != -1)
    {
-      random_engine_.seed(seed_);
+      base_seed_ = seed_;
    }
    else
    {
       std::random_device rd;
-      random_engine_.seed(rd());
+      base_seed_ = ((uint64_t)rd() << 32) | rd();
    }
+   next_request_ = 0;
+
+   // models built with the old settings can't be reused
+   pool_id_ = std::make_shared<const uint64_t>(next_pool_id++);
 
    return optind;
 }
 
+template<typename Real>
+std::shared_ptr<BasicMovementRule<Real>> LCAFactory::MakeMovementRule() const
+{
+   switch(movement_)
+   {
+   case Correlated:
+      return std::make_shared<BasicCorrelatedRandomWalk<Real>>(sigma_);
+
+   case Levy:
+      // steps are truncated at the size of the arena
+      return std::make_shared<BasicLevyWalk<Real>>(levy_mu_, arena_size_);
+
+   default:
+      return std::make_shared<BasicRandomWalk<Real>>();
+   }
+}
+
+int LCAFactory::SeedAt(uint64_t request) const
+{
+   // a non-negative int, as the models take
+   return SplitMix64::At(base_seed_, request) >> 33;
+}
+
 std::unique_ptr<LCA> LCAFactory::Create(double initial_density)
 {
-   // lock so multiple threads can produce new LCAs at once
-   std::lock_guard<std::mutex> lock(new_lca_mutex_);
-
-   int seed = seed_distribution_(random_engine_);
-
-   Model model(arena_size_,
-               num_agents_,
-               communication_range_,
-               seed,
-               initial_density,
-               speed_);
-   model.SetMovementRule(movement_rule_);
-   model.SetPDark(pdark_);
-   model.SetPInteractive(pinteractive_);
-
-   if(init_ == ByPosition)
+   return Create(initial_density, next_request_++);
+}
+
+std::unique_ptr<LCA> LCAFactory::Create(double initial_density, uint64_t request) const
+{
+   int seed = SeedAt(request);
+
+   if(single_precision_)
+   {
+      return Build<float>(initial_density, seed);
+   }
+   return Build<double>(initial_density, seed);
+}
+
+template<typename Real>
+std::unique_ptr<LCA> LCAFactory::Build(double initial_density, int seed) const
+{
+   std::unique_ptr<LCA> lca;
+   purge_recycled_models();
+   ModelPool& pool = recycled_models[*pool_id_];
+   pool.owner = pool_id_;
+   if(!pool.models.empty() && dynamic_cast<BasicModel<Real>*>(pool.models.back().get()) != nullptr)
+   {
+      // settings are as they were built below
+      std::unique_ptr<BasicModel<Real>> model(static_cast<BasicModel<Real>*>(pool.models.back().release()));
+      pool.models.pop_back();
+      model->Reset(seed, initial_density);
+      if(init_ == ByPosition)
+      {
+         model->SetPositionalState(initial_density);
+      }
+      lca = std::make_unique<LCA>(std::move(model), rule_, max_time_);
+   }
+   else
    {
-      model.SetPositionalState(initial_density);
+      std::unique_ptr<BasicModel<Real>> model =
+         std::make_unique<BasicModel<Real>>(arena_size_,
+                                            num_agents_,
+                                            communication_range_,
+                                            seed,
+                                            initial_density,
+                                            speed_);
+      model->SetMovementRule(MakeMovementRule<Real>());
+      model->SetPDark(pdark_);
+      model->SetPInteractive(pinteractive_);
+
+      if(init_ == ByPosition)
+      {
+         model->SetPositionalState(initial_density);
+      }
+
+      model->SetEventDriven(event_driven_);
+      model->SetThreads(step_threads_);
+
+      lca = std::make_unique<LCA>(std::move(model), rule_, max_time_);
    }
 
-   return std::make_unique<LCA>(model, rule_, max_time_);
+   // dropped if the factory has gone or changed its settings
+   std::weak_ptr<const uint64_t> pool_id = pool_id_;
+   lca->SetModelRecycler([pool_id](std::unique_ptr<ModelInterface> model)
+                         {
+                            std::shared_ptr<const uint64_t> id = pool_id.lock();
+                            if(id)
+                            {
+                               ModelPool& pool = recycled_models[*id];
+                               pool.owner = id;
+                               if(pool.models.size() < MAX_RECYCLED)
+                               {
+                                  pool.models.push_back(std::move(model));
+                               }
+                            }
+                         });
+   return lca;
+}
+
+StateBatch LCAFactory::CreateBatch(const std::vector<double>& initial_densities)
+{
+   return CreateBatch(initial_densities, next_request_++);
+}
+
+StateBatch LCAFactory::CreateBatch(const std::vector<double>& initial_densities, uint64_t request) const
+{
+   std::mt19937_64 gen(SeedAt(request));
+   return StateBatch(num_agents_, initial_densities, gen);
+}
+
+bool LCAFactory::SharedTrajectory() const
+{
+   return shared_trajectory_;
+}
+
+void LCAFactory::SetSinglePrecision(bool single_precision)
+{
+   single_precision_ = single_precision;
 }
 
 double LCAFactory::ArenaSize() const
@@ -2,26 +2,55 @@
 
 #include <numeric>   // std::accumulate
 #include <algorithm> // std::for_each
+#include <stdexcept>
+#include <cmath>
 
-Model::Model(double arena_size,
-             int num_agents,
-             double communication_range,
-             int seed,
-             double initial_density,
-             double agent_speed) :
+#include "BitSlice.hpp"
+#include "Checkpoint.hpp"
+
+namespace
+{
+#ifdef FIXED_POINT_HEADING
+   const uint8_t FIXED_POINT = 1;
+#else
+   const uint8_t FIXED_POINT = 0;
+#endif
+
+   template<typename T>
+   void ReadAgentVector(std::istream& in, std::vector<T>& values, int num_agents)
+   {
+      checkpoint::ReadVector(in, values);
+      if(values.size() != num_agents)
+      {
+         throw checkpoint::Error("wrong number of agents");
+      }
+   }
+}
+
+template<typename Real>
+BasicModel<Real>::BasicModel(double arena_size,
+                             int num_agents,
+                             double communication_range,
+                             int seed,
+                             double initial_density,
+                             double agent_speed) :
    _communication_range(communication_range),
    _rng(seed),
+   _num_states(2),
+   _steps(0),
    _stats(num_agents),
-   _noise(0.0),
+   _noise_probability(0.0),
    _arena_size(arena_size),
-   go_interactive_(1.0),
-   go_dark_(0.0)
+   p_interactive_(1.0),
+   p_dark_(0.0)
 {
    std::uniform_real_distribution<double> coordinate_distribution(-arena_size/2, arena_size/2);
    std::uniform_real_distribution<double> heading_distribution(0, 2*M_PI);
    std::bernoulli_distribution state_distribution(initial_density);
    std::uniform_int_distribution<int> seed_distribution;
 
+   _agents.reserve(num_agents);
+   _agent_states.reserve(num_agents);
    for(int i = 0; i < num_agents; i++)
    {
       Point initial_position(coordinate_distribution(_rng), coordinate_distribution(_rng));
@@ -37,17 +66,206 @@ Model::Model(double arena_size,
          _agent_states.push_back(0);
       }
    }
+   SplitMix64 noise_seeds(_rng());
+   for(int i = 0; i < num_agents; i++)
+   {
+      _noise_rngs.emplace_back(noise_seeds());
+   }
+   _noise_gaps.assign(num_agents, -1);
    _turn_distribution = heading_distribution;
    _step_distribution = std::uniform_int_distribution<int>(1,1);
-   _stats.PushState(CurrentDensity(), CurrentNetwork());
+   IndexInteractivity();
+   _stats.PushState(StateDensities(), CurrentNetwork());
 }
 
-Model::~Model() {}
+template<typename Real>
+BasicModel<Real>::BasicModel(std::istream& in) :
+   _stats(0)
+{
+   int num_agents = checkpoint::Read<int>(in);
+   _num_states = checkpoint::Read<int>(in);
+   _steps = checkpoint::Read<int>(in);
+   _arena_size = checkpoint::Read<double>(in);
+   _communication_range = checkpoint::Read<double>(in);
+   _noise_probability = checkpoint::Read<double>(in);
+   p_dark_ = checkpoint::Read<double>(in);
+   p_interactive_ = checkpoint::Read<double>(in);
+   _fused = checkpoint::Read<bool>(in);
+   _num_threads = checkpoint::Read<int>(in);
+   _event_driven = checkpoint::Read<bool>(in);
+   if(num_agents < 0 || _num_states < 2 || _num_states > MAX_STATES || _num_threads < 1)
+   {
+      throw checkpoint::Error("bad model");
+   }
 
-void Model::SetPositionalState(double initial_density)
+   checkpoint::ReadEngine(in, _rng);
+   ReadAgentVector(in, _agent_states, num_agents);
+   ReadAgentVector(in, _noise_rngs, num_agents);
+   ReadAgentVector(in, _noise_gaps, num_agents);
+   if(_noise_probability != 0.0)
+   {
+      _noise_gap_param = std::geometric_distribution<long long>::param_type(fabs(_noise_probability));
+   }
+   checkpoint::ReadVector(in, _interactive);
+   checkpoint::ReadVector(in, _dark);
+   ReadAgentVector(in, _set_position, num_agents);
+   if(_interactive.size() + _dark.size() != num_agents)
+   {
+      throw checkpoint::Error("wrong number of agents");
+   }
+   checkpoint::ReadVector(in, _state_densities);
+
+   _agents.reserve(num_agents);
+   std::shared_ptr<MovementRule> previous_rule;
+   for(int i = 0; i < num_agents; i++)
+   {
+      Agent a(Point(0, 0), Heading(), 0, 0, 0);
+      a.Restore(in, previous_rule);
+      previous_rule = a.GetMovementRule();
+      _agents.push_back(a);
+   }
+   _stats = ModelStats(num_agents);
+   _stats.Restore(in);
+   if(_event_driven)
+   {
+      _kinetic.Restore(in);
+      if(_kinetic.Snapshot().Size() != num_agents)
+      {
+         throw checkpoint::Error("wrong number of agents");
+      }
+   }
+
+   _turn_distribution = std::uniform_real_distribution<double>(0, 2*M_PI);
+   _step_distribution = std::uniform_int_distribution<int>(1,1);
+}
+
+template<typename Real>
+BasicModel<Real>::~BasicModel() {}
+
+template<typename Real>
+void BasicModel<Real>::Reset(int seed, double initial_density)
+{
+   _rng.seed(seed);
+   _num_states = 2;
+   _steps = 0;
+   _observers.clear();
+   _stats.Clear();
+
+   // the same draws as the constructor
+   std::uniform_real_distribution<double> coordinate_distribution(-_arena_size/2, _arena_size/2);
+   std::uniform_real_distribution<double> heading_distribution(0, 2*M_PI);
+   std::bernoulli_distribution state_distribution(initial_density);
+   std::uniform_int_distribution<int> seed_distribution;
+   for(int i = 0; i < _agents.size(); i++)
+   {
+      Point initial_position(coordinate_distribution(_rng), coordinate_distribution(_rng));
+      Heading initial_heading(heading_distribution(_rng));
+      _agents[i].Reset(initial_position, initial_heading, seed_distribution(_rng));
+      _agent_states[i] = state_distribution(_rng) ? 1 : 0;
+   }
+   SplitMix64 noise_seeds(_rng());
+   for(SplitMix64& noise_rng : _noise_rngs)
+   {
+      noise_rng = SplitMix64(noise_seeds());
+   }
+
+   // then those of the settings
+   SetNoise(_noise_probability);
+   DrawDark();
+   IndexInteractivity();
+
+   std::shared_ptr<NetworkSnapshot> network;
+   if(_event_driven)
+   {
+      _kinetic.Init(_agents, _communication_range, _steps);
+      network = CurrentNetwork();
+   }
+   else
+   {
+      network = NetworkBuffer();
+      _candidates.resize(std::max<size_t>(_candidates.size(), 1));
+      FillNetwork(*network, _grid, _candidates[0]);
+   }
+   _stats.PushState(StateDensities(), network);
+}
+
+template<typename Real>
+void BasicModel<Real>::Checkpoint(std::ostream& out) const
+{
+   checkpoint::Write(out, checkpoint::MAGIC);
+   checkpoint::Write(out, checkpoint::VERSION);
+   checkpoint::Write<uint8_t>(out, sizeof(Real));
+   checkpoint::Write(out, FIXED_POINT);
+
+   checkpoint::Write<int>(out, _agents.size());
+   checkpoint::Write(out, _num_states);
+   checkpoint::Write(out, _steps);
+   checkpoint::Write(out, _arena_size);
+   checkpoint::Write(out, _communication_range);
+   checkpoint::Write(out, _noise_probability);
+   checkpoint::Write(out, p_dark_);
+   checkpoint::Write(out, p_interactive_);
+   checkpoint::Write(out, _fused);
+   checkpoint::Write(out, _num_threads);
+   checkpoint::Write(out, _event_driven);
+
+   checkpoint::WriteEngine(out, _rng);
+   checkpoint::WriteVector(out, _agent_states);
+   checkpoint::WriteVector(out, _noise_rngs);
+   checkpoint::WriteVector(out, _noise_gaps);
+   checkpoint::WriteVector(out, _interactive);
+   checkpoint::WriteVector(out, _dark);
+   checkpoint::WriteVector(out, _set_position);
+   checkpoint::WriteVector(out, _state_densities);
+   // as they are: in event-driven mode, bringing agents up to date
+   // would change the rounding of their later moves
+   for(const Agent& agent : _agents)
+   {
+      agent.Save(out);
+   }
+   _stats.Save(out);
+   if(_event_driven)
+   {
+      _kinetic.Save(out);
+   }
+   if(!out)
+   {
+      throw std::runtime_error("checkpoint: write failed");
+   }
+}
+
+std::unique_ptr<ModelInterface> RestoreModel(std::istream& in)
+{
+   if(checkpoint::Read<uint32_t>(in) != checkpoint::MAGIC)
+   {
+      throw checkpoint::Error("not a checkpoint");
+   }
+   if(checkpoint::Read<uint32_t>(in) != checkpoint::VERSION)
+   {
+      throw checkpoint::Error("unsupported version");
+   }
+   uint8_t real_size = checkpoint::Read<uint8_t>(in);
+   if(checkpoint::Read<uint8_t>(in) != FIXED_POINT)
+   {
+      throw checkpoint::Error("written with a different heading representation");
+   }
+   if(real_size == sizeof(float))
+   {
+      return std::unique_ptr<ModelInterface>(new BasicModel<float>(in));
+   }
+   else if(real_size == sizeof(double))
+   {
+      return std::unique_ptr<ModelInterface>(new BasicModel<double>(in));
+   }
+   throw checkpoint::Error("unsupported precision");
+}
+
+template<typename Real>
+void BasicModel<Real>::SetPositionalState(double initial_density)
 {
    double x_threshold = (_arena_size / 2.0) - (_arena_size * (1.0 - initial_density));
-   _stats = ModelStats(_agents.size());
+   _stats.Clear();
+   GetAgents(); // bring agents up to date
    for(int i = 0; i < _agents.size(); i++)
    {
       if(_agents[i].Position().GetX() <= x_threshold)
@@ -59,87 +277,364 @@ void Model::SetPositionalState(double initial_density)
          _agent_states[i] = 0;
       }
    }
-   _stats.PushState(CurrentDensity(), CurrentNetwork());
+   _stats.PushState(StateDensities(), CurrentNetwork());
+}
+
+template<typename Real>
+void BasicModel<Real>::SetStates(const std::vector<int>& states)
+{
+   _stats.Clear();
+   _num_states = 2;
+   for(int state : states)
+   {
+      if(state < 0 || state >= MAX_STATES)
+      {
+         throw std::out_of_range("agent state out of range");
+      }
+      _num_states = std::max(_num_states, state + 1);
+   }
+   _agent_states.assign(states.begin(), states.end());
+   _stats.PushState(StateDensities(), CurrentNetwork());
+}
+
+template<typename Real>
+void BasicModel<Real>::SetState(int a, int state)
+{
+   if(a < 0 || a >= _agents.size())
+   {
+      throw std::out_of_range("no such agent");
+   }
+   if(state < 0 || state >= MAX_STATES)
+   {
+      throw std::out_of_range("agent state out of range");
+   }
+   _agent_states[a] = state;
+   _num_states = std::max(_num_states, state + 1);
+   StateDensities();
+}
+
+template<typename Real>
+void BasicModel<Real>::SetAgentHeading(int a, Heading h)
+{
+   if(a < 0 || a >= _agents.size())
+   {
+      throw std::out_of_range("no such agent");
+   }
+   if(_event_driven) _kinetic.Sync(_agents, a, _steps);
+   _agents[a].SetHeading(h);
+   if(_event_driven) _kinetic.Touch(_agents, a, _steps);
+}
+
+template<typename Real>
+void BasicModel<Real>::SetAgentHeading(int a, double heading)
+{
+   SetAgentHeading(a, Heading(heading));
 }
 
-void Model::RecordNetworkDensityOnly()
+template<typename Real>
+void BasicModel<Real>::RecordNetworkDensityOnly()
 {
    _stats.NetworkSummaryOnly();
 }
 
-double Model::CurrentDensity() const
+template<typename Real>
+void BasicModel<Real>::RecordConvergenceOnly()
 {
-   return std::accumulate(_agent_states.begin(), _agent_states.end(), 0.0) / _agent_states.size();
+   _stats.ConvergenceOnly();
 }
 
-std::shared_ptr<NetworkSnapshot> Model::CurrentNetwork() const
+template<typename Real>
+void BasicModel<Real>::AddObserver(std::shared_ptr<Observer> observer, int interval)
 {
+   if(interval < 1)
+   {
+      throw std::invalid_argument("observer interval must be positive");
+   }
+   _observers.push_back(Subscription{observer, interval});
+   if(_steps % interval == 0)
+   {
+      observer->Observe(_steps, StateDensities(), CurrentNetwork());
+   }
+}
+
+template<typename Real>
+void BasicModel<Real>::Record(const std::vector<double>& state_densities,
+                              std::shared_ptr<NetworkSnapshot> network)
+{
+   _stats.PushState(state_densities, network);
+   for(const Subscription& subscription : _observers)
+   {
+      if(_steps % subscription.interval == 0)
+      {
+         subscription.observer->Observe(_steps, state_densities, network);
+      }
+   }
+}
+
+template<typename Real>
+void BasicModel<Real>::ReserveSteps(int steps)
+{
+   _stats.Reserve(steps);
+}
+
+template<typename Real>
+double BasicModel<Real>::CurrentDensity() const
+{
+   return CurrentDensity(1);
+}
+
+template<typename Real>
+double BasicModel<Real>::CurrentDensity(int state) const
+{
+   // kept up to date by StateDensities() and the fused step
+   return state < _state_densities.size() ? _state_densities[state] : 0.0;
+}
+
+template<typename Real>
+int BasicModel<Real>::NumStates() const
+{
+   return _num_states;
+}
+
+template<typename Real>
+const std::vector<double>& BasicModel<Real>::StateDensities()
+{
+   _state_densities.assign(_num_states, 0.0);
+   for(AgentState state : _agent_states)
+   {
+      _state_densities[state]++;
+   }
+   for(double& density : _state_densities)
+   {
+      density /= _agent_states.size();
+   }
+   return _state_densities;
+}
+
+template<typename Real>
+std::shared_ptr<NetworkSnapshot> BasicModel<Real>::CurrentNetwork() const
+{
+   if(_event_driven)
+   {
+      return std::make_shared<NetworkSnapshot>(_kinetic.Snapshot());
+   }
+
    std::shared_ptr<NetworkSnapshot> snapshot = std::make_shared<NetworkSnapshot>(_agents.size());
+   Grid grid;
+   std::vector<int> candidates;
+   FillNetwork(*snapshot, grid, candidates);
+   return snapshot;
+}
+
+template<typename Real>
+bool BasicModel<Real>::Parallel() const
+{
+   return _pool && !_event_driven;
+}
+
+template<typename Real>
+template<typename Task>
+void BasicModel<Real>::ForEach(int size, const Task& task) const
+{
+   if(Parallel())
+   {
+      _pool->ParallelFor(size, task);
+   }
+   else
+   {
+      task(0, size, 0);
+   }
+}
+
+template<typename Real>
+void BasicModel<Real>::FillNetwork(NetworkSnapshot& snapshot, Grid& grid,
+                                   std::vector<int>& candidates) const
+{
+   if(_fused)
+   {
+      SizeGrid(grid);
+      for(int a = 0; a < _agents.size(); a++)
+      {
+         grid.agent_cell[a] = CellOf(grid, _agents[a].Position());
+      }
+      SortGrid(grid);
+      for(int k = 0; k < _agents.size(); k++)
+      {
+         FillRow(grid, k, snapshot, candidates);
+      }
+      return;
+   }
+
+   if(Parallel())
+   {
+      // each thread fills in the neighbors of its own agents, so every
+      // pair is tested twice
+      ForEach(_agents.size(), [&](int begin, int end, int)
+              {
+                 for(int i = begin; i < end; i++)
+                 {
+                    for(int j = 0; j < _agents.size(); j++)
+                    {
+                       if(j != i && _agents[i].Position().Within(_communication_range, _agents[j].Position()))
+                       {
+                          snapshot.AddHalfEdge(i, j);
+                       }
+                    }
+                 }
+              });
+      return;
+   }
+
    for(int i = 0; i < _agents.size(); i++)
    {
       for(int j = i+1; j < _agents.size(); j++)
       {
          if(_agents[i].Position().Within(_communication_range, _agents[j].Position()))
          {
-            snapshot->AddEdge(i, j);
+            snapshot.AddEdge(i, j);
          }
       }
    }
-   return snapshot;
 }
 
-const ModelStats& Model::GetStats() const
+template<typename Real>
+std::shared_ptr<NetworkSnapshot> BasicModel<Real>::NetworkBuffer()
+{
+   if(!_network || _network.use_count() > 1)
+   {
+      _network = std::make_shared<NetworkSnapshot>(_agents.size());
+   }
+   else
+   {
+      _network->Clear();
+   }
+   return _network;
+}
+
+template<typename Real>
+const ModelStats& BasicModel<Real>::GetStats() const
 {
    return _stats;
 }
 
-const std::vector<Agent>& Model::GetAgents() const
+template<typename Real>
+const std::vector<BasicAgent<Real>>& BasicModel<Real>::GetAgents() const
 {
+   if(_event_driven)
+   {
+      _kinetic.SyncAll(_agents, _steps);
+   }
    return _agents;
 }
 
-const std::vector<int>& Model::GetStates() const
+template<typename Real>
+const std::vector<AgentState>& BasicModel<Real>::GetStates() const
 {
    return _agent_states;
 }
 
-void Model::SetMovementRule(std::shared_ptr<MovementRule> rule)
+template<typename Real>
+void BasicModel<Real>::SetMovementRule(std::shared_ptr<BasicMovementRule<Real>> rule)
 {
+   GetAgents(); // bring agents up to date
    for(auto& agent : _agents)
    {
       agent.SetMovementRule(rule->Clone());
    }
+   if(_event_driven)
+   {
+      _kinetic.Init(_agents, _communication_range, _steps);
+   }
 }
 
-void Model::SetNoise(double p)
+template<typename Real>
+void BasicModel<Real>::SetNoise(double p)
 {
    _noise_probability = p;
-   _noise = std::bernoulli_distribution(fabs(p));
+   if(p != 0.0)
+   {
+      _noise_gap_param = std::geometric_distribution<long long>::param_type(fabs(p));
+   }
+   DrawNoiseGaps();
+}
+
+template<typename Real>
+void BasicModel<Real>::DrawNoiseGaps()
+{
+   if(_noise_probability == 0.0)
+   {
+      _noise_gaps.assign(_agents.size(), -1);
+      return;
+   }
+   std::geometric_distribution<long long> gaps(_noise_gap_param);
+   for(int a = 0; a < (int) _agents.size(); a++)
+   {
+      _noise_gaps[a] = gaps(_noise_rngs[a]);
+   }
 }
 
-void Model::SetPDark(double p)
+template<typename Real>
+void BasicModel<Real>::SetPDark(double p)
 {
-   go_dark_ = std::bernoulli_distribution(fabs(p));
+   p_dark_ = fabs(p);
+   GetAgents(); // bring agents up to date
+   DrawDark();
+   IndexInteractivity();
+   if(_event_driven)
+   {
+      _kinetic.Init(_agents, _communication_range, _steps);
+   }
+}
 
+template<typename Real>
+void BasicModel<Real>::DrawDark()
+{
+   std::bernoulli_distribution go_dark(p_dark_);
    for(auto& agent : _agents)
    {
-      if(go_dark_(_rng))
+      if(go_dark(_rng))
       {
          agent.GoDark();
       }
    }
 }
 
-void Model::SetPInteractive(double p)
+template<typename Real>
+void BasicModel<Real>::SetPInteractive(double p)
 {
-   go_interactive_ = std::bernoulli_distribution(fabs(p));
+   p_interactive_ = fabs(p);
 }
 
-int Model::Noise(int i)
+template<typename Real>
+bool BasicModel<Real>::NoiseEvent(int a)
 {
-   if(_noise(_rng))
+   long long& gap = _noise_gaps[a];
+   if(gap > 0)
    {
-      return 1 - i;
+      gap--;
+      return false;
+   }
+   else if(gap < 0)
+   {
+      return false;
+   }
+   std::geometric_distribution<long long> gaps(_noise_gap_param);
+   gap = gaps(_noise_rngs[a]);
+   return true;
+}
+
+template<typename Real>
+int BasicModel<Real>::Noise(int i, int a)
+{
+   if(NoiseEvent(a))
+   {
+      if(_num_states == 2)
+      {
+         return 1 - i;
+      }
+      // any other state
+      std::uniform_int_distribution<int> shift(1, _num_states - 1);
+      return (i + shift(_noise_rngs[a])) % _num_states;
    }
    else
    {
@@ -147,54 +642,528 @@ int Model::Noise(int i)
    }
 }
 
-void Model::Step(const Rule* rule)
+template<typename Real>
+void BasicModel<Real>::SetEventDriven(bool event_driven)
 {
-   for(Agent& agent : _agents)
+   if(event_driven == _event_driven) return;
+
+   if(event_driven)
    {
-      agent.Step();
-      if(agent.IsInteractive() && go_dark_(_rng))
+      _kinetic.Init(_agents, _communication_range, _steps);
+   }
+   else
+   {
+      _kinetic.SyncAll(_agents, _steps);
+   }
+   _event_driven = event_driven;
+}
+
+template<typename Real>
+void BasicModel<Real>::SetThreads(int num_threads)
+{
+   _num_threads = std::max(num_threads, 1);
+   _pool = nullptr;
+}
+
+template<typename Real>
+int BasicModel<Real>::NumThreads() const
+{
+   return _num_threads;
+}
+
+template<typename Real>
+void BasicModel<Real>::SetFusedStep(bool fused)
+{
+   _fused = fused;
+}
+
+template<typename Real>
+void BasicModel<Real>::StartThreads()
+{
+   if(_num_threads > 1 && !_pool)
+   {
+      _pool = std::make_shared<ThreadPool>(_num_threads);
+   }
+}
+
+template<typename Real>
+void BasicModel<Real>::IndexInteractivity()
+{
+   _interactive.clear();
+   _dark.clear();
+   _set_position.resize(_agents.size());
+   for(int a = 0; a < _agents.size(); a++)
+   {
+      std::vector<int>& set = _agents[a].IsInteractive() ? _interactive : _dark;
+      _set_position[a] = set.size();
+      set.push_back(a);
+   }
+}
+
+template<typename Real>
+void BasicModel<Real>::SwitchSet(int a)
+{
+   // the agent has already switched, so it is in the other set
+   std::vector<int>& from = _agents[a].IsInteractive() ? _dark : _interactive;
+   std::vector<int>& to   = _agents[a].IsInteractive() ? _interactive : _dark;
+
+   int last = from.back();
+   from[_set_position[a]] = last;
+   _set_position[last] = _set_position[a];
+   from.pop_back();
+
+   _set_position[a] = to.size();
+   to.push_back(a);
+}
+
+template<typename Real>
+void BasicModel<Real>::Sample(const std::vector<int>& set, double p, std::vector<int>& picked)
+{
+   if(p <= 0.0)
+   {
+      return;
+   }
+   std::geometric_distribution<long long> gaps(std::min(p, 1.0));
+   for(long long i = gaps(_rng); i < (long long)set.size(); i += 1 + gaps(_rng))
+   {
+      picked.push_back(set[i]);
+   }
+}
+
+template<typename Real>
+void BasicModel<Real>::UpdateInteractivity()
+{
+   // pick from both sets before moving anyone
+   _switching.clear();
+   Sample(_interactive, p_dark_, _switching);
+   Sample(_dark, p_interactive_, _switching);
+
+   for(int a : _switching)
+   {
+      if(_event_driven) _kinetic.Sync(_agents, a, _steps);
+
+      if(_agents[a].IsInteractive()) _agents[a].GoDark();
+      else                           _agents[a].GoInteractive();
+
+      if(_event_driven) _kinetic.Touch(_agents, a, _steps);
+      SwitchSet(a);
+   }
+}
+
+template<typename Real>
+void BasicModel<Real>::TurnAgent(int a, double h)
+{
+   if(_event_driven) _kinetic.Sync(_agents, a, _steps);
+   _agents[a].SetHeading(_agents[a].GetHeading() + Heading(h));
+   if(_event_driven) _kinetic.Touch(_agents, a, _steps);
+}
+
+template<typename Real>
+std::shared_ptr<NetworkSnapshot> BasicModel<Real>::MoveAgents()
+{
+   ForEach(_agents.size(), [&](int begin, int end, int)
+           {
+              for(int a = begin; a < end; a++)
+              {
+                 _agents[a].Step();
+              }
+           });
+   UpdateInteractivity();
+   std::shared_ptr<NetworkSnapshot> network = NetworkBuffer();
+   _candidates.resize(std::max<size_t>(_candidates.size(), 1));
+   FillNetwork(*network, _grid, _candidates[0]);
+   return network;
+}
+
+template<typename Real>
+void BasicModel<Real>::SizeGrid(Grid& grid) const
+{
+   // Cells a little wider than the range, so that rounding can't put
+   // two agents within range more than one cell apart, and no more
+   // cells than agents.
+   int num_agents = _agents.size();
+   double num_cells = std::floor(_arena_size / _communication_range) - 1;
+   grid.num_cells = std::max(1.0, std::min(num_cells, std::sqrt((double)num_agents)));
+   grid.cell_size = _arena_size / grid.num_cells;
+   grid.agent_cell.resize(num_agents);
+   grid.agents.resize(num_agents);
+   grid.positions.resize(num_agents, Point(0, 0));
+}
+
+template<typename Real>
+int BasicModel<Real>::CellOf(const Grid& grid, const Point& p) const
+{
+   int x = (p.GetX() + _arena_size/2) / grid.cell_size;
+   int y = (p.GetY() + _arena_size/2) / grid.cell_size;
+   x = std::min(std::max(x, 0), grid.num_cells - 1);
+   y = std::min(std::max(y, 0), grid.num_cells - 1);
+   return y * grid.num_cells + x;
+}
+
+template<typename Real>
+void BasicModel<Real>::SortGrid(Grid& grid) const
+{
+   // counting sort, keeping the agents of a cell in increasing order
+   int num_cells = grid.num_cells * grid.num_cells;
+   grid.start.assign(num_cells + 1, 0);
+   for(int cell : grid.agent_cell)
+   {
+      grid.start[cell + 1]++;
+   }
+   std::partial_sum(grid.start.begin(), grid.start.end(), grid.start.begin());
+   for(int a = 0; a < _agents.size(); a++)
+   {
+      int k = grid.start[grid.agent_cell[a]]++;
+      grid.agents[k]    = a;
+      grid.positions[k] = _agents[a].Position();
+   }
+   // each start was advanced to the next cell's start
+   for(int cell = num_cells; cell > 0; cell--)
+   {
+      grid.start[cell] = grid.start[cell - 1];
+   }
+   grid.start[0] = 0;
+}
+
+template<typename Real>
+void BasicModel<Real>::FillRow(const Grid& grid, int k, NetworkSnapshot& network,
+                               std::vector<int>& candidates) const
+{
+   int cell = grid.agent_cell[grid.agents[k]];
+   int x = cell % grid.num_cells;
+   int y = cell / grid.num_cells;
+   int x_min = std::max(x - 1, 0), x_max = std::min(x + 1, grid.num_cells - 1);
+   int y_min = std::max(y - 1, 0), y_max = std::min(y + 1, grid.num_cells - 1);
+   const Point& position = grid.positions[k];
+
+   candidates.clear();
+   for(int row = y_min; row <= y_max; row++)
+   {
+      // the cells of a row are contiguous
+      int first = grid.start[row * grid.num_cells + x_min];
+      int last  = grid.start[row * grid.num_cells + x_max + 1];
+      for(int m = first; m < last; m++)
       {
-         agent.GoDark();
+         if(m != k && position.Within(_communication_range, grid.positions[m]))
+         {
+            candidates.push_back(grid.agents[m]);
+         }
       }
-      else if(agent.IsDark() && go_interactive_(_rng))
+   }
+   std::sort(candidates.begin(), candidates.end());
+   for(int n : candidates)
+   {
+      network.AddHalfEdge(grid.agents[k], n);
+   }
+}
+
+template<typename Real>
+void BasicModel<Real>::MoveAndBin()
+{
+   SizeGrid(_grid);
+   ForEach(_agents.size(), [&](int begin, int end, int)
+           {
+              for(int a = begin; a < end; a++)
+              {
+                 _agents[a].Step();
+                 _grid.agent_cell[a] = CellOf(_grid, _agents[a].Position());
+              }
+           });
+   SortGrid(_grid);
+}
+
+template<typename Real>
+void BasicModel<Real>::InteractAndTally(const Rule* rule, NetworkSnapshot& network)
+{
+   bool counts    = rule->CountsSufficient() && _num_states == 2;
+   bool histogram = !counts && rule->HistogramSufficient();
+
+   int num_threads = Parallel() ? _pool->NumThreads() : 1;
+   _next_states.resize(_agents.size());
+   _neighbor_states.resize(num_threads);
+   _candidates.resize(num_threads);
+   _thread_state_counts.assign(num_threads * MAX_STATES, 0);
+
+   // each thread takes a band of rows of cells
+   ForEach(_grid.num_cells * _grid.num_cells, [&](int begin, int end, int thread)
+           {
+              int* state_counts = &_thread_state_counts[thread * MAX_STATES];
+              for(int k = _grid.start[begin]; k < _grid.start[end]; k++)
+              {
+                 int a = _grid.agents[k];
+                 FillRow(_grid, k, network, _candidates[thread]);
+                 if(_agents[a].IsInteractive())
+                 {
+                    int state = UpdateAgent(a, rule, network.GetNeighbors(a), counts, histogram,
+                                            true, _neighbor_states[thread]);
+                    state_counts[state]++;
+                 }
+                 else
+                 {
+                    // dark agents keep their states
+                    _next_states[a] = _agent_states[a];
+                    state_counts[_agent_states[a]]++;
+                 }
+              }
+           });
+
+   // add up the threads' counts
+   int* state_counts = &_thread_state_counts[0];
+   for(int thread = 1; thread < num_threads; thread++)
+   {
+      for(int s = 0; s < MAX_STATES; s++)
       {
-         agent.GoInteractive();
+         state_counts[s] += _thread_state_counts[thread * MAX_STATES + s];
       }
    }
+   std::swap(_agent_states, _next_states);
+   for(int s = _num_states; s < MAX_STATES; s++)
+   {
+      if(state_counts[s] != 0) _num_states = s + 1;
+   }
+   _state_densities.assign(_num_states, 0.0);
+   for(int s = 0; s < _num_states; s++)
+   {
+      _state_densities[s] = state_counts[s] / (double)_agent_states.size();
+   }
+}
+
+template<typename Real>
+std::shared_ptr<NetworkSnapshot> BasicModel<Real>::AdvanceEvents()
+{
+   _kinetic.Advance(_agents, _steps);
+   UpdateInteractivity();
+   std::shared_ptr<NetworkSnapshot> network = NetworkBuffer();
+   *network = _kinetic.Snapshot();
+   return network;
+}
 
-   std::shared_ptr<NetworkSnapshot> current_network = CurrentNetwork();
-   std::vector<int> new_states(_agents.size());
-   for(int a = 0; a < _agent_states.size(); a++)
+template<typename Real>
+void BasicModel<Real>::Step(const Rule* rule)
+{
+   _steps++;
+   StartThreads();
+   if(_fused && !_event_driven)
+   {
+      MoveAndBin();
+      UpdateInteractivity();
+      std::shared_ptr<NetworkSnapshot> current_network = NetworkBuffer();
+      InteractAndTally(rule, *current_network);
+      Record(_state_densities, current_network);
+      return;
+   }
+
+   std::shared_ptr<NetworkSnapshot> current_network = _event_driven ? AdvanceEvents() : MoveAgents();
+   UpdateStates(rule, *current_network, true);
+   Record(StateDensities(), current_network);
+}
+
+template<typename Real>
+void BasicModel<Real>::Step(const Rule* rule, StateBatch& batch)
+{
+   if(_noise_probability != 0.0)
+   {
+      throw std::logic_error("shared trajectories do not support noise");
+   }
+
+   _steps++;
+   StartThreads();
+   std::shared_ptr<NetworkSnapshot> current_network = _event_driven ? AdvanceEvents() : MoveAgents();
+   UpdateStates(rule, *current_network, false);
+   UpdateBatch(rule, *current_network, batch);
+   Record(StateDensities(), current_network);
+}
+
+template<typename Real>
+int BasicModel<Real>::UpdateAgent(int a, const Rule* rule, const std::vector<int>& neighbors,
+                                  bool counts, bool histogram, bool allow_turns,
+                                  std::vector<int>& neighbor_states)
+{
+   int state_counts[MAX_STATES];
+   std::fill(state_counts, state_counts + _num_states, 0);
+   neighbor_states.clear();
+   for(int n : neighbors)
    {
-      if(_agents[a].IsInteractive())
+      if(_agents[n].IsInteractive())
       {
-         auto neighbors = current_network->GetNeighbors(a);
-         std::vector<int> neighbor_states;
-         for(int n : neighbors)
+         int state;
+         if(_noise_probability < 0.0) {
+            if(NoiseEvent(a))
+            {
+               continue; // message lost
+            }
+            state = _agent_states[n];
+         }
+         else
          {
-            if(_agents[n].IsInteractive())
+            state = Noise(_agent_states[n], a);
+         }
+
+         if(counts || histogram)
+         {
+            state_counts[state]++;
+         }
+         else
+         {
+            neighbor_states.push_back(state);
+         }
+      }
+   }
+   int self = _agent_states[a];
+   std::pair<int, double> update = counts
+      ? rule->Apply(self, state_counts[1], state_counts[0] + state_counts[1])
+      : histogram
+      ? rule->Apply(self, state_counts, _num_states)
+      : rule->Apply(self, neighbor_states);
+   if(update.first < 0 || update.first >= MAX_STATES)
+   {
+      throw std::out_of_range("rule yielded a state out of range");
+   }
+   _next_states[a] = update.first;
+   if(update.second != 0.0)
+   {
+      if(!allow_turns)
+      {
+         throw std::logic_error("shared trajectories require a rule that never turns agents");
+      }
+      TurnAgent(a, update.second);
+   }
+   return update.first;
+}
+
+template<typename Real>
+void BasicModel<Real>::UpdateStates(const Rule* rule, const NetworkSnapshot& current_network, bool allow_turns)
+{
+   // rules that only need the neighbor counts (binary states) or the
+   // histogram of neighbor states are applied without collecting the
+   // neighbor states.
+   bool counts    = rule->CountsSufficient() && _num_states == 2;
+   bool histogram = !counts && rule->HistogramSufficient();
+
+   // dark agents keep their states
+   _next_states = _agent_states;
+   int num_threads = Parallel() ? _pool->NumThreads() : 1;
+   _neighbor_states.resize(num_threads);
+   _thread_num_states.resize(num_threads);
+   ForEach(_interactive.size(), [&](int begin, int end, int thread)
+           {
+              int num_states = _num_states;
+              for(int i = begin; i < end; i++)
+              {
+                 int a = _interactive[i];
+                 int state = UpdateAgent(a, rule, current_network.GetNeighbors(a),
+                                         counts, histogram, allow_turns, _neighbor_states[thread]);
+                 num_states = std::max(num_states, state + 1);
+              }
+              _thread_num_states[thread] = num_states;
+           });
+   std::swap(_agent_states, _next_states);
+   _num_states = *std::max_element(_thread_num_states.begin(), _thread_num_states.end());
+}
+
+template<typename Real>
+void BasicModel<Real>::UpdateBatch(const Rule* rule, const NetworkSnapshot& current_network, StateBatch& batch)
+{
+   int words = batch.Words();
+   std::vector<uint64_t>& next = _batch_next;
+   next.resize(batch.NumAgents() * words);
+
+   // rule results for each neighborhood size, rows[total][2*ones + self];
+   // the rule may differ from step to step, so the rows are rebuilt
+   // each step into the buffers of the last
+   std::vector<std::vector<uint8_t>>& rows = _batch_rows;
+   std::vector<int>& interactive_neighbors = _batch_neighbors;
+   int num_rows = 0;
+
+   // dark agents keep their states
+   std::copy(batch.States(0), batch.States(0) + batch.NumAgents() * words, next.begin());
+   for(int a : _interactive)
+   {
+      const uint64_t* self = batch.States(a);
+      interactive_neighbors.clear();
+      for(int n : current_network.GetNeighbors(a))
+      {
+         if(_agents[n].IsInteractive()) interactive_neighbors.push_back(n);
+      }
+
+      int total = interactive_neighbors.size();
+      for(; num_rows <= total; num_rows++)
+      {
+         int size = num_rows;
+         if((int) rows.size() <= size) rows.emplace_back();
+         std::vector<uint8_t>& row = rows[size];
+         row.resize(2*(size+1));
+         for(int ones = 0; ones <= size; ones++)
+         {
+            for(int state = 0; state <= 1; state++)
             {
-               if(_noise_probability < 0.0) {
-                  if(!_noise(_rng))
-                  {
-                     neighbor_states.push_back(_agent_states[n]);
-                  }
-               }
-               else
+               std::pair<int, double> update = rule->Apply(state, ones, size);
+               if(update.second != 0.0)
                {
-                  neighbor_states.push_back(Noise(_agent_states[n]));
+                  throw std::logic_error("shared trajectories require a rule that never turns agents");
                }
+               row[2*ones + state] = update.first != 0;
             }
          }
-         std::pair<int, double> update = rule->Apply(_agent_states[a], neighbor_states);
-         new_states[a] = update.first;
-         _agents[a].SetHeading(_agents[a].GetHeading() + Heading(update.second));
       }
-      else
+      const std::vector<uint8_t>& row = rows[total];
+
+      // count the ones among the neighbors in every vector at once
+      int num_planes = bitslice::Planes(total);
+      for(int w = 0; w < words; w++)
       {
-         new_states[a] = _agent_states[a];
+         uint64_t planes[bitslice::MAX_PLANES] = {0};
+         for(int n : interactive_neighbors)
+         {
+            bitslice::Add(planes, num_planes, batch.States(n)[w]);
+         }
+
+         uint64_t result = 0;
+         for(int ones = 0; ones <= total; ones++)
+         {
+            uint64_t greater, equal;
+            bitslice::Compare(planes, num_planes, ones, greater, equal);
+            result |= equal & ((row[2*ones+1] ? self[w] : 0) | (row[2*ones] ? ~self[w] : 0));
+         }
+
+         uint64_t active = batch.ActiveMask(w);
+         next[a*words + w] = (result & active) | (self[w] & ~active);
       }
    }
-   _agent_states = new_states;
-   _stats.PushState(CurrentDensity(), current_network);
+   batch.Update(next);
+}
+
+template<typename Real>
+std::unique_ptr<ModelInterface> BasicModel<Real>::Clone() const
+{
+   std::unique_ptr<BasicModel> copy = std::make_unique<BasicModel>(*this);
+   copy->_pool = nullptr;
+   copy->_observers.clear();
+   return copy;
+}
+
+template<typename Real>
+std::unique_ptr<ModelInterface> BasicModel<Real>::Fork(uint64_t stream) const
+{
+   std::unique_ptr<BasicModel> branch = std::make_unique<BasicModel>(*this);
+   branch->_pool = nullptr;
+   branch->_observers.clear();
+
+   SplitMix64 seeds(stream);
+   branch->_rng.seed(seeds());
+   for(SplitMix64& noise_rng : branch->_noise_rngs)
+   {
+      noise_rng = SplitMix64(seeds());
+   }
+   for(Agent& agent : branch->_agents)
+   {
+      agent.Reseed(seeds());
+   }
+   // the parent's pending gaps would put every branch's next noisy
+   // observations in the same place
+   branch->DrawNoiseGaps();
+   return branch;
 }
+
+template class BasicModel<float>;
+template class BasicModel<double>;
@@ -1,21 +1,59 @@
 #include "ModelStats.hpp"
+#include "Checkpoint.hpp"
 
+#include <algorithm>
 #include <cmath>
 
 ModelStats::ModelStats(int num_agents) :
-   _aggregate_network(num_agents)
+   _aggregate(num_agents),
+   _num_agents(num_agents)
 {}
 
+void ModelStats::ClearHistories()
+{
+   _archive.Clear();
+   _densities.Clear();
+   _aggregate.Clear();
+}
+
+void ModelStats::Clear()
+{
+   _initial_density = 0.0;
+   std::fill(_recent_density, _recent_density + 3, 0.0);
+   _elapsed = 0;
+   ClearHistories();
+}
+
 ModelStats::~ModelStats() {}
 
 void ModelStats::PushState(double density, std::shared_ptr<NetworkSnapshot> snapshot)
 {
+   PushState(std::vector<double>{1.0 - density, density}, snapshot);
+}
+
+void ModelStats::PushState(const std::vector<double>& state_densities,
+                           std::shared_ptr<NetworkSnapshot> snapshot)
+{
+   double density = state_densities.size() > 1 ? state_densities[1] : 0.0;
+   if(_elapsed == 0)
+   {
+      _initial_density = density;
+   }
+   _recent_density[2] = _recent_density[1];
+   _recent_density[1] = _recent_density[0];
+   _recent_density[0] = density;
+   _elapsed++;
+   if(_convergence_only)
+   {
+      return;
+   }
+
+   int step = _elapsed - 1;
    if(!_network_summary_only) {
-      _network.AppendSnapshot(snapshot);
+      _archive.Observe(step, state_densities, snapshot);
    }
-   _aggregate_network.Union(*snapshot);
-   _network_density.push_back(_aggregate_network.Density());
-   _ca_density.push_back(density);
+   _aggregate.Observe(step, state_densities, snapshot);
+   _densities.Observe(step, state_densities, snapshot);
 }
 
 void ModelStats::NetworkSummaryOnly()
@@ -23,69 +61,118 @@ void ModelStats::NetworkSummaryOnly()
    _network_summary_only = true;
 }
 
+void ModelStats::ConvergenceOnly()
+{
+   _convergence_only = true;
+   ClearHistories();
+}
+
+void ModelStats::Reserve(int steps)
+{
+   _densities.Reserve(steps);
+   _aggregate.Reserve(steps);
+}
+
 const Network& ModelStats::GetNetwork() const
 {
-   return _network;
+   return _archive.GetNetwork();
 }
 
 unsigned int ModelStats::ElapsedTime() const
 {
-   return _network.Size();
+   return _elapsed;
 }
 
 bool ModelStats::IsCorrect() const
 {
-   if(_ca_density.size() == 0)
+   if(_elapsed == 0)
    {
       return false;
    }
-   else if(_ca_density[0] >= 0.5)
+   else if(_initial_density >= 0.5)
    {
-      return _ca_density.back() == 1.0;
+      return _recent_density[0] == 1.0;
    }
    else
    {
-      return _ca_density.back() == 0.0;
+      return _recent_density[0] == 0.0;
    }
 }
 
 bool ModelStats::IsSynchronized() const
 {
-   if(_ca_density.size() < 2)
+   if(_elapsed < 3)
    {
       return false;
    }
 
-   return _ca_density.back() == 1 - *(_ca_density.rbegin()+1)
-      && _ca_density.back() == *(_ca_density.rbegin()+2);
+   return _recent_density[0] == 1 - _recent_density[1]
+      && _recent_density[0] == _recent_density[2];
+}
+
+std::vector<double> ModelStats::GetDensityHistory() const
+{
+   return _densities.GetDensityHistory();
+}
+
+std::vector<double> ModelStats::GetDensityHistory(int state) const
+{
+   return _densities.GetDensityHistory(state);
 }
 
-const std::vector<double>& ModelStats::GetDensityHistory() const
+int ModelStats::NumStates() const
 {
-   return _ca_density;
+   return _densities.NumStates();
 }
 
 std::vector<double> ModelStats::AggregateDensityHistory() const
 {
-   return _network_density;
+   return _aggregate.DensityHistory();
 }
 
 double ModelStats::AverageAggregateDegree() const
 {
-   return _aggregate_network.AverageDegree();
+   return _aggregate.Aggregate().AverageDegree();
 }
 
 double ModelStats::AggregateDegreeStdDev() const
 {
-   return sqrt(_aggregate_network.DegreeVariance());
+   return sqrt(_aggregate.Aggregate().DegreeVariance());
 }
 
 double ModelStats::MedianAggregateDegree() const
 {
-   return _aggregate_network.MedianDegree();
+   return _aggregate.Aggregate().MedianDegree();
 }
 
 double ModelStats::CurrentCADensity() const
 {
-   return _ca_density.back();
+   return _recent_density[0];
+}
+
+void ModelStats::Save(std::ostream& out) const
+{
+   checkpoint::Write(out, _network_summary_only);
+   checkpoint::Write(out, _convergence_only);
+   checkpoint::Write(out, _initial_density);
+   checkpoint::Write(out, _recent_density);
+   checkpoint::Write(out, _elapsed);
+   _archive.Save(out);
+   _densities.Save(out);
+   _aggregate.Save(out);
+}
+
+void ModelStats::Restore(std::istream& in)
+{
+   _network_summary_only = checkpoint::Read<bool>(in);
+   _convergence_only = checkpoint::Read<bool>(in);
+   _initial_density = checkpoint::Read<double>(in);
+   for(double& density : _recent_density)
+   {
+      density = checkpoint::Read<double>(in);
+   }
+   _elapsed = checkpoint::Read<unsigned int>(in);
+   _archive.Restore(in);
+   _densities.Restore(in);
+   _aggregate.Restore(in);
 }
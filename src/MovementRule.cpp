@@ -1,34 +1,61 @@
 #include "MovementRule.hpp"
+#include "Checkpoint.hpp"
 
 #include <cmath> // M_PI
+#include <stdexcept>
+#include <typeinfo>
 
-LevyWalk::LevyWalk(double mu, int max_step) :
+template<typename Real>
+void BasicMovementRule<Real>::Save(std::ostream& out) const
+{
+   if(typeid(*this) != typeid(BasicMovementRule))
+   {
+      throw std::logic_error(std::string("can't checkpoint movement rule ") + typeid(*this).name());
+   }
+   checkpoint::Write<uint8_t>(out, STRAIGHT);
+}
+
+template<typename Real>
+std::shared_ptr<BasicMovementRule<Real>>
+BasicMovementRule<Real>::Load(std::istream& in, const std::shared_ptr<BasicMovementRule>& previous)
+{
+   switch(checkpoint::Read<uint8_t>(in))
+   {
+   case STRAIGHT:
+      return std::make_shared<BasicMovementRule>();
+   case LEVY_WALK:
+      return BasicLevyWalk<Real>::Load(in, previous);
+   case CORRELATED_RANDOM_WALK:
+      return std::make_shared<BasicCorrelatedRandomWalk<Real>>(checkpoint::Read<Real>(in));
+   case RANDOM_WALK:
+      return std::make_shared<BasicRandomWalk<Real>>();
+   default:
+      throw checkpoint::Error("unknown movement rule");
+   }
+}
+
+template<typename Real>
+BasicLevyWalk<Real>::BasicLevyWalk(double mu, int max_step) :
    mu(mu),
    max_step(max_step),
    next_turn(0),
    current_time(0),
-   heading_distribution(0, 2*M_PI)
+   heading_distribution(0, 2*M_PI),
+   step_length(std::make_shared<PowerLawSampler>(mu, max_step))
 {}
 
-LevyWalk::~LevyWalk() {}
+template<typename Real>
+BasicLevyWalk<Real>::~BasicLevyWalk() {}
 
-int gen_power_law(double mu, int max_step, std::mt19937_64& gen)
-{
-   std::uniform_real_distribution<double> u(0.0,1.0);
-   double pmin = powf(1.0, -mu+1);
-   double pmax = powf((double)max_step, -mu+1);
-   double z    = powf((pmax - pmin)*u(gen) + pmin, 1.0/(-mu+1));
-   return floor(z);
-}
-
-Heading LevyWalk::Turn(const Point&     current_position,
-                       const Heading&   current_heading,
-                       std::mt19937_64& gen)
+template<typename Real>
+BasicHeading<Real> BasicLevyWalk<Real>::Turn(const Point&     current_position,
+                                             const Heading&   current_heading,
+                                             std::mt19937_64& gen)
 {
    current_time++;
    if(current_time >= next_turn)
    {
-      next_turn = current_time+gen_power_law(mu, max_step, gen);
+      next_turn = current_time + (*step_length)(gen);
       return Heading(heading_distribution(gen));
    }
    else
@@ -37,41 +64,128 @@ Heading LevyWalk::Turn(const Point&     current_position,
    }
 }
 
-std::shared_ptr<MovementRule> LevyWalk::Clone() const
+template<typename Real>
+unsigned int BasicLevyWalk<Real>::StraightSteps() const
+{
+   // Turn() increments the clock before comparing it to next_turn
+   return next_turn > current_time + 1 ? next_turn - current_time - 1 : 0;
+}
+
+template<typename Real>
+void BasicLevyWalk<Real>::Skip(unsigned int k)
 {
-   return std::make_shared<LevyWalk>(*this);
+   current_time += k;
 }
 
-RandomWalk::RandomWalk() : heading_distribution(0, 2*M_PI) {}
-RandomWalk::~RandomWalk() {}
+template<typename Real>
+void BasicLevyWalk<Real>::Reset()
+{
+   next_turn = 0;
+   current_time = 0;
+}
+
+template<typename Real>
+std::shared_ptr<BasicMovementRule<Real>> BasicLevyWalk<Real>::Clone() const
+{
+   return std::make_shared<BasicLevyWalk>(*this);
+}
 
-Heading RandomWalk::Turn(const Point& current_position,
-                         const Heading& current_heading,
-                         std::mt19937_64& gen)
+template<typename Real>
+void BasicLevyWalk<Real>::Save(std::ostream& out) const
+{
+   checkpoint::Write<uint8_t>(out, this->LEVY_WALK);
+   checkpoint::Write(out, mu);
+   checkpoint::Write(out, max_step);
+   checkpoint::Write(out, next_turn);
+   checkpoint::Write(out, current_time);
+}
+
+template<typename Real>
+std::shared_ptr<BasicMovementRule<Real>>
+BasicLevyWalk<Real>::Load(std::istream& in, const std::shared_ptr<BasicMovementRule<Real>>& previous)
+{
+   double mu = checkpoint::Read<double>(in);
+   int max_step = checkpoint::Read<int>(in);
+   std::shared_ptr<BasicLevyWalk> rule;
+   auto levy = std::dynamic_pointer_cast<BasicLevyWalk>(previous);
+   if(levy && levy->mu == mu && levy->max_step == max_step)
+   {
+      rule = std::make_shared<BasicLevyWalk>(*levy);
+   }
+   else
+   {
+      if(max_step < 1)
+      {
+         throw checkpoint::Error("bad Levy walk");
+      }
+      rule = std::make_shared<BasicLevyWalk>(mu, max_step);
+   }
+   rule->next_turn = checkpoint::Read<unsigned int>(in);
+   rule->current_time = checkpoint::Read<unsigned int>(in);
+   return rule;
+}
+
+template<typename Real>
+BasicRandomWalk<Real>::BasicRandomWalk() : heading_distribution(0, 2*M_PI) {}
+
+template<typename Real>
+BasicRandomWalk<Real>::~BasicRandomWalk() {}
+
+template<typename Real>
+BasicHeading<Real> BasicRandomWalk<Real>::Turn(const Point& current_position,
+                                               const Heading& current_heading,
+                                               std::mt19937_64& gen)
 {
    return Heading(heading_distribution(gen));
 }
 
-std::shared_ptr<MovementRule> RandomWalk::Clone() const
+template<typename Real>
+std::shared_ptr<BasicMovementRule<Real>> BasicRandomWalk<Real>::Clone() const
+{
+   return std::make_shared<BasicRandomWalk>();
+}
+
+template<typename Real>
+void BasicRandomWalk<Real>::Save(std::ostream& out) const
 {
-   return std::make_shared<RandomWalk>();
+   checkpoint::Write<uint8_t>(out, this->RANDOM_WALK);
 }
 
-CorrelatedRandomWalk::CorrelatedRandomWalk(double sigma) :
+template<typename Real>
+BasicCorrelatedRandomWalk<Real>::BasicCorrelatedRandomWalk(double sigma) :
    _sigma(sigma)
 {}
 
-CorrelatedRandomWalk::~CorrelatedRandomWalk() {}
+template<typename Real>
+BasicCorrelatedRandomWalk<Real>::~BasicCorrelatedRandomWalk() {}
 
-Heading CorrelatedRandomWalk::Turn(const Point& current_position,
+template<typename Real>
+BasicHeading<Real> BasicCorrelatedRandomWalk<Real>::Turn(const Point& current_position,
                   const Heading& current_heading,
                   std::mt19937_64& gen)
 {
-   std::normal_distribution<double> heading_rv(current_heading.Radians(), _sigma);
+   std::normal_distribution<Real> heading_rv(current_heading.Radians(), _sigma);
    return Heading(heading_rv(gen));
 }
 
-std::shared_ptr<MovementRule> CorrelatedRandomWalk::Clone() const
+template<typename Real>
+std::shared_ptr<BasicMovementRule<Real>> BasicCorrelatedRandomWalk<Real>::Clone() const
 {
-   return std::make_shared<CorrelatedRandomWalk>(_sigma);
+   return std::make_shared<BasicCorrelatedRandomWalk>(_sigma);
 }
+
+template<typename Real>
+void BasicCorrelatedRandomWalk<Real>::Save(std::ostream& out) const
+{
+   checkpoint::Write<uint8_t>(out, this->CORRELATED_RANDOM_WALK);
+   checkpoint::Write(out, _sigma);
+}
+
+template class BasicMovementRule<float>;
+template class BasicMovementRule<double>;
+template class BasicLevyWalk<float>;
+template class BasicLevyWalk<double>;
+template class BasicRandomWalk<float>;
+template class BasicRandomWalk<double>;
+template class BasicCorrelatedRandomWalk<float>;
+template class BasicCorrelatedRandomWalk<double>;
@@ -1,9 +1,37 @@
 #include "Network.hpp"
+#include "Checkpoint.hpp"
 
 #include <algorithm>
 
 /// NetworkSnapshot functions
 
+/**
+ * Add v to a sorted list if it is not already there. Edges are
+ * usually added in increasing order, so this is normally an append.
+ */
+void insert_sorted(std::vector<int>& neighbors, int v)
+{
+   if(neighbors.empty() || neighbors.back() < v)
+   {
+      neighbors.push_back(v);
+      return;
+   }
+   auto position = std::lower_bound(neighbors.begin(), neighbors.end(), v);
+   if(*position != v)
+   {
+      neighbors.insert(position, v);
+   }
+}
+
+void erase_sorted(std::vector<int>& neighbors, int v)
+{
+   auto position = std::lower_bound(neighbors.begin(), neighbors.end(), v);
+   if(position != neighbors.end() && *position == v)
+   {
+      neighbors.erase(position);
+   }
+}
+
 NetworkSnapshot::NetworkSnapshot(int num_vertices) :
    _num_vertices(num_vertices),
    _adjacency_list(num_vertices)
@@ -20,8 +48,38 @@ void NetworkSnapshot::AddEdge(int i, int j)
    }
    else
    {
-      _adjacency_list[i].insert(j);
-      _adjacency_list[j].insert(i);
+      insert_sorted(_adjacency_list[i], j);
+      insert_sorted(_adjacency_list[j], i);
+   }
+}
+
+void NetworkSnapshot::AddHalfEdge(int i, int j)
+{
+   if(i == j || i < 0 || j < 0 || i >= _num_vertices || j >= _num_vertices)
+   {
+      throw(std::out_of_range("NetworkSnapshot::AddHalfEdge()"));
+   }
+   insert_sorted(_adjacency_list[i], j);
+}
+
+void NetworkSnapshot::RemoveEdge(int i, int j)
+{
+   if(i == j || i < 0 || j < 0 || i >= _num_vertices || j >= _num_vertices)
+   {
+      throw(std::out_of_range("NetworkSnapshot::RemoveEdge()"));
+   }
+   else
+   {
+      erase_sorted(_adjacency_list[i], j);
+      erase_sorted(_adjacency_list[j], i);
+   }
+}
+
+void NetworkSnapshot::Clear()
+{
+   for(auto& neighbors : _adjacency_list)
+   {
+      neighbors.clear();
    }
 }
 
@@ -35,7 +93,7 @@ double NetworkSnapshot::Density() const
    return n / (_num_vertices * (_num_vertices-1)); // XXX
 }
 
-std::set<int> NetworkSnapshot::GetNeighbors(int v) const
+const std::vector<int>& NetworkSnapshot::GetNeighbors(int v) const
 {
    if(v < 0 || v >= _num_vertices)
    {
@@ -58,7 +116,7 @@ double NetworkSnapshot::DegreeVariance() const
 {
    double avg = AverageDegree();
    double variance = 0.0;
-   for(auto adjacencies : _adjacency_list)
+   for(const auto& adjacencies : _adjacency_list)
    {
       variance += (avg - adjacencies.size())*(avg - adjacencies.size());
    }
@@ -68,7 +126,7 @@ double NetworkSnapshot::DegreeVariance() const
 double NetworkSnapshot::MedianDegree() const
 {
    std::vector<unsigned int> degrees;
-   for(auto adjacencies : _adjacency_list)
+   for(const auto& adjacencies : _adjacency_list)
    {
       degrees.push_back(adjacencies.size());
    }
@@ -121,8 +179,10 @@ void NetworkSnapshot::Union(const NetworkSnapshot& s)
 {
    for(int i = 0; i < _adjacency_list.size(); i++)
    {
-      _adjacency_list[i].insert(s._adjacency_list[i].begin(),
-                                s._adjacency_list[i].end());
+      for(int v : s._adjacency_list[i])
+      {
+         insert_sorted(_adjacency_list[i], v);
+      }
    }
 }
 
@@ -136,6 +196,36 @@ int NetworkSnapshot::Degree(int v) const
    return _adjacency_list[v].size();
 }
 
+bool NetworkSnapshot::HasEdge(int i, int j) const
+{
+   const std::vector<int>& neighbors = _adjacency_list[i];
+   return std::binary_search(neighbors.begin(), neighbors.end(), j);
+}
+
+void NetworkSnapshot::Save(std::ostream& out) const
+{
+   checkpoint::Write<uint64_t>(out, _adjacency_list.size());
+   for(const std::vector<int>& neighbors : _adjacency_list)
+   {
+      checkpoint::WriteVector(out, neighbors);
+   }
+}
+
+void NetworkSnapshot::Restore(std::istream& in)
+{
+   uint64_t size = checkpoint::Read<uint64_t>(in);
+   if(size > INT32_MAX)
+   {
+      throw checkpoint::Error("implausible network size");
+   }
+   _num_vertices = size;
+   _adjacency_list.resize(size);
+   for(std::vector<int>& neighbors : _adjacency_list)
+   {
+      checkpoint::ReadVector(in, neighbors);
+   }
+}
+
 bool operator== (const NetworkSnapshot& s, const NetworkSnapshot& g)
 {
    return s._adjacency_list == g._adjacency_list;
@@ -167,12 +257,12 @@ Network::~Network() {}
 
 void Network::AppendSnapshot(std::shared_ptr<NetworkSnapshot> snapshot)
 {
-   _snapshots.push_back(snapshot);
+   _snapshots.Append(snapshot);
 }
 
 std::shared_ptr<NetworkSnapshot> Network::GetSnapshot(unsigned int t) const
 {
-   if(t > _snapshots.size())
+   if(t >= _snapshots.Size())
    {
       throw(std::out_of_range("Network::GetSnapshot()"));
    }
@@ -184,16 +274,42 @@ std::shared_ptr<NetworkSnapshot> Network::GetSnapshot(unsigned int t) const
 
 unsigned int Network::Size() const
 {
-   return _snapshots.size();
+   return _snapshots.Size();
+}
+
+void Network::Clear()
+{
+   _snapshots.Clear();
+}
+
+void Network::Save(std::ostream& out) const
+{
+   checkpoint::Write<uint64_t>(out, _snapshots.Size());
+   for(size_t t = 0; t < _snapshots.Size(); t++)
+   {
+      _snapshots[t]->Save(out);
+   }
+}
+
+void Network::Restore(std::istream& in)
+{
+   uint64_t size = checkpoint::Read<uint64_t>(in);
+   _snapshots.Clear();
+   for(uint64_t t = 0; t < size; t++)
+   {
+      auto snapshot = std::make_shared<NetworkSnapshot>(0);
+      snapshot->Restore(in);
+      _snapshots.Append(snapshot);
+   }
 }
 
 NetworkSnapshot Network::Aggregate() const
 {
    int size = _snapshots[0]->Size();
    NetworkSnapshot aggregate(size);
-   for(std::shared_ptr<NetworkSnapshot> snapshot : _snapshots)
+   for(size_t t = 0; t < _snapshots.Size(); t++)
    {
-      aggregate.Union(*snapshot);
+      aggregate.Union(*_snapshots[t]);
    }
    return aggregate;
 }
@@ -0,0 +1,337 @@
+#include "Observer.hpp"
+#include "Checkpoint.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void DensityTracker::Observe(int step, const std::vector<double>& state_densities,
+                             std::shared_ptr<NetworkSnapshot> network)
+{
+   if(state_densities.size() > 2 && state_densities.size() > _state_density.size())
+   {
+      // Until now every agent was in state 0 or 1.
+      if(_state_density.empty())
+      {
+         _state_density.resize(2);
+         for(size_t t = 0; t < _ca_density.Size(); t++)
+         {
+            _state_density[0].Append(1.0 - _ca_density[t]);
+         }
+      }
+      History<double> never;
+      for(size_t t = 0; t < _ca_density.Size(); t++)
+      {
+         never.Append(0.0);
+      }
+      _state_density.resize(state_densities.size(), never);
+   }
+   for(size_t s = 0; s < _state_density.size(); s++)
+   {
+      if(s != 1)
+      {
+         _state_density[s].Append(s < state_densities.size() ? state_densities[s] : 0.0);
+      }
+   }
+   _ca_density.Append(state_densities.size() > 1 ? state_densities[1] : 0.0);
+}
+
+void DensityTracker::Reserve(int observations)
+{
+   _ca_density.Reserve(observations);
+   for(auto& history : _state_density)
+   {
+      history.Reserve(observations);
+   }
+}
+
+void DensityTracker::Clear()
+{
+   _ca_density.Clear();
+   _state_density.clear();
+}
+
+std::vector<double> DensityTracker::GetDensityHistory() const
+{
+   return _ca_density.Vector();
+}
+
+std::vector<double> DensityTracker::GetDensityHistory(int state) const
+{
+   if(state == 1)
+   {
+      return _ca_density.Vector();
+   }
+   else if(state < (int) _state_density.size())
+   {
+      return _state_density[state].Vector();
+   }
+   else if(state == 0)
+   {
+      std::vector<double> history;
+      for(size_t t = 0; t < _ca_density.Size(); t++)
+      {
+         history.push_back(1.0 - _ca_density[t]);
+      }
+      return history;
+   }
+   return std::vector<double>(_ca_density.Size(), 0.0);
+}
+
+int DensityTracker::NumStates() const
+{
+   return std::max<int>(2, _state_density.size());
+}
+
+void DensityTracker::Save(std::ostream& out) const
+{
+   _ca_density.Save(out);
+   checkpoint::Write<uint64_t>(out, _state_density.size());
+   for(const History<double>& history : _state_density)
+   {
+      history.Save(out);
+   }
+}
+
+void DensityTracker::Restore(std::istream& in)
+{
+   _ca_density.Restore(in);
+   uint64_t num_states = checkpoint::Read<uint64_t>(in);
+   if(num_states > 256)
+   {
+      throw checkpoint::Error("implausible number of states");
+   }
+   _state_density.resize(num_states);
+   for(History<double>& history : _state_density)
+   {
+      history.Restore(in);
+   }
+}
+
+AggregateNetwork::AggregateNetwork(int num_agents) :
+   _own(num_agents)
+{}
+
+AggregateNetwork::AggregateNetwork(const AggregateNetwork& other) :
+   _shared(other.Share()),
+   _own(other.Size()),
+   _shared_ends(other._shared_ends + other._own_ends),
+   _density(other._density)
+{}
+
+AggregateNetwork& AggregateNetwork::operator=(const AggregateNetwork& other)
+{
+   if(this != &other)
+   {
+      _shared = other.Share();
+      _own = NetworkSnapshot(other.Size());
+      _shared_ends = other._shared_ends + other._own_ends;
+      _own_ends = 0;
+      _density = other._density;
+      _merged = nullptr;
+   }
+   return *this;
+}
+
+std::shared_ptr<const NetworkSnapshot> AggregateNetwork::Share() const
+{
+   std::lock_guard<std::mutex> lock(_merging);
+   if(_own_ends == 0)
+   {
+      return _shared;
+   }
+   if(!_merged)
+   {
+      std::shared_ptr<NetworkSnapshot> merged;
+      if(_shared)
+      {
+         merged = std::make_shared<NetworkSnapshot>(*_shared);
+         merged->Union(_own);
+      }
+      else
+      {
+         merged = std::make_shared<NetworkSnapshot>(_own);
+      }
+      _merged = merged;
+   }
+   return _merged;
+}
+
+void AggregateNetwork::Observe(int step, const std::vector<double>& state_densities,
+                               std::shared_ptr<NetworkSnapshot> network)
+{
+   if(_merged)
+   {
+      // copies share everything observed so far
+      _shared = std::move(_merged);
+      _merged = nullptr;
+      _shared_ends += _own_ends;
+      _own_ends = 0;
+      _own.Clear();
+   }
+
+   int size = _own.Size();
+   for(int i = 0; i < size; i++)
+   {
+      int degree = _own.Degree(i);
+      for(int j : network->GetNeighbors(i))
+      {
+         if(!_shared || !_shared->HasEdge(i, j))
+         {
+            _own.AddHalfEdge(i, j);
+         }
+      }
+      _own_ends += _own.Degree(i) - degree;
+   }
+   _density.Append((double) (_shared_ends + _own_ends) / ((double) size * (size - 1)));
+}
+
+void AggregateNetwork::Reserve(int observations)
+{
+   _density.Reserve(observations);
+}
+
+void AggregateNetwork::Clear()
+{
+   _shared = nullptr;
+   _merged = nullptr;
+   _own.Clear();
+   _shared_ends = 0;
+   _own_ends = 0;
+   _density.Clear();
+}
+
+int AggregateNetwork::Size() const
+{
+   return _own.Size();
+}
+
+NetworkSnapshot AggregateNetwork::Aggregate() const
+{
+   if(!_shared)
+   {
+      return _own;
+   }
+   NetworkSnapshot aggregate(*_shared);
+   aggregate.Union(_own);
+   return aggregate;
+}
+
+std::vector<double> AggregateNetwork::DensityHistory() const
+{
+   return _density.Vector();
+}
+
+void AggregateNetwork::Save(std::ostream& out) const
+{
+   Aggregate().Save(out);
+   _density.Save(out);
+}
+
+void AggregateNetwork::Restore(std::istream& in)
+{
+   _shared = nullptr;
+   _merged = nullptr;
+   _own.Restore(in);
+   _shared_ends = 0;
+   _own_ends = 2L * _own.EdgeCount();
+   _density.Restore(in);
+}
+
+void SnapshotArchive::Observe(int step, const std::vector<double>& state_densities,
+                              std::shared_ptr<NetworkSnapshot> network)
+{
+   _network.AppendSnapshot(network);
+}
+
+void SnapshotArchive::Clear()
+{
+   _network.Clear();
+}
+
+const Network& SnapshotArchive::GetNetwork() const
+{
+   return _network;
+}
+
+void SnapshotArchive::Save(std::ostream& out) const
+{
+   _network.Save(out);
+}
+
+void SnapshotArchive::Restore(std::istream& in)
+{
+   _network.Restore(in);
+}
+
+void DegreeStats::Observe(int step, const std::vector<double>& state_densities,
+                          std::shared_ptr<NetworkSnapshot> network)
+{
+   _mean.push_back(network->AverageDegree());
+   _std_dev.push_back(std::sqrt(network->DegreeVariance()));
+   _median.push_back(network->MedianDegree());
+}
+
+const std::vector<double>& DegreeStats::Mean() const
+{
+   return _mean;
+}
+
+const std::vector<double>& DegreeStats::StdDev() const
+{
+   return _std_dev;
+}
+
+const std::vector<double>& DegreeStats::Median() const
+{
+   return _median;
+}
+
+int ComponentStats::Find(int v)
+{
+   while(_parent[v] != v)
+   {
+      _parent[v] = _parent[_parent[v]];
+      v = _parent[v];
+   }
+   return v;
+}
+
+void ComponentStats::Observe(int step, const std::vector<double>& state_densities,
+                             std::shared_ptr<NetworkSnapshot> network)
+{
+   int size = network->Size();
+   _parent.resize(size);
+   _size.assign(size, 1);
+   for(int v = 0; v < size; v++)
+   {
+      _parent[v] = v;
+   }
+
+   int count = size;
+   for(int v = 0; v < size; v++)
+   {
+      for(int u : network->GetNeighbors(v))
+      {
+         int a = Find(u), b = Find(v);
+         if(a != b)
+         {
+            if(_size[a] < _size[b]) std::swap(a, b);
+            _parent[b] = a;
+            _size[a] += _size[b];
+            count--;
+         }
+      }
+   }
+   _count.push_back(count);
+   _largest.push_back(size == 0 ? 0 : *std::max_element(_size.begin(), _size.end()));
+}
+
+const std::vector<int>& ComponentStats::Count() const
+{
+   return _count;
+}
+
+const std::vector<int>& ComponentStats::Largest() const
+{
+   return _largest;
+}
@@ -1,41 +1,38 @@
 #include "OneDLattice.hpp"
-#include "Point.hpp"
+
 #include <algorithm>
 
 OneDLattice::OneDLattice(int num_cells, int radius) :
-   _lattice(num_cells),
-   _states(num_cells),
+   _num_cells(num_cells),
+   _radius(radius),
+   _old_cells((num_cells + 63) / 64, 0),
+   _cells((num_cells + 63) / 64, 0),
    _steps(0)
 {
    std::random_device rd;
    _rng.seed(rd());
-
-   for(int i = 0; i < num_cells; i++)
-   {
-      for(int j = i - radius; j <= i + radius; j++)
-      {
-         if(i == j)
-         {
-            continue; // no self edges
-         }
-         else if(j < 0)
-         {
-            _lattice.AddEdge(i, num_cells + j);
-         }
-         else if(j >= num_cells)
-         {
-            _lattice.AddEdge(i, j - num_cells);
-         }
-         else
-         {
-            _lattice.AddEdge(i, j);
-         }
-      }
-   }
 }
 
 OneDLattice::~OneDLattice() {}
 
+int OneDLattice::Get(const std::vector<uint64_t>& cells, int i) const
+{
+   return (cells[i >> 6] >> (i & 63)) & 1;
+}
+
+void OneDLattice::Set(std::vector<uint64_t>& cells, int i, int state)
+{
+   uint64_t bit = (uint64_t)1 << (i & 63);
+   cells[i >> 6] = (cells[i >> 6] & ~bit) | (-(uint64_t)(state != 0) & bit);
+}
+
+int OneDLattice::Degree() const
+{
+   // once the neighborhood wraps around the ring every other cell is
+   // a neighbor (the same cell is not counted twice).
+   return 2*_radius + 1 >= _num_cells ? _num_cells - 1 : 2*_radius;
+}
+
 void OneDLattice::Seed(int seed)
 {
    _rng.seed(seed);
@@ -44,74 +41,102 @@ void OneDLattice::Seed(int seed)
 void OneDLattice::SetDensity(double density)
 {
    std::uniform_real_distribution<double> uniform(0.0, 1.0);
-   for(int& x : _states)
+   for(int i = 0; i < _num_cells; i++)
    {
       double p = uniform(_rng);
-      if(p < density)
-      {
-         x = 1;
-      }
-      else
-      {
-         x = 0;
-      }
+      Set(_cells, i, p < density);
    }
    _steps = 0;
 }
 
+int OneDLattice::CountOnes(const std::vector<uint64_t>& cells) const
+{
+   int ones = 0;
+   for(uint64_t word : cells)
+   {
+      ones += __builtin_popcountll(word);
+   }
+   return ones;
+}
+
 double OneDLattice::GetDensity() const
 {
-   return (double)std::accumulate(_states.begin(), _states.end(), 0) / (double)_states.size();
+   return (double)CountOnes(_cells) / (double)_num_cells;
 }
 
 void OneDLattice::Step(const Rule& rule)
 {
-   // XXX: This is (almost) duplicate code from Model::Step
-   //      - should refactor!
-   std::vector<int> new_states(_states.size());
-   for(int i = 0; i < _states.size(); i++)
+   int degree = Degree();
+   _rule_table.resize(2*(degree+1));
+   for(int ones = 0; ones <= degree; ones++)
    {
-      auto neighbors = _lattice.GetNeighbors(i);
-      std::vector<int> neighbor_states;
-      for(int n : neighbors)
+      _rule_table[2*ones]   = rule.Apply(0, ones, degree).first != 0;
+      _rule_table[2*ones+1] = rule.Apply(1, ones, degree).first != 0;
+   }
+
+   std::swap(_old_cells, _cells);
+   const std::vector<uint64_t>& old_cells = _old_cells;
+
+   // number of ones in the window [i - r, i + r], including cell i
+   int window = 0;
+   if(degree == 2*_radius)
+   {
+      for(int j = -_radius; j <= _radius; j++)
       {
-         neighbor_states.push_back(_states[n]);
+         window += Get(old_cells, (j + _num_cells) % _num_cells);
       }
-      std::vector<Point> neighbor_positions;
-      for(int i = 0; i < neighbors.size(); i++)
+   }
+   else
+   {
+      window = CountOnes(old_cells);
+   }
+
+   int enter = (_radius + 1) % _num_cells;          // cell entering the window next
+   int leave = (_num_cells - _radius) % _num_cells; // cell leaving the window next
+   uint64_t word = 0;
+   for(int i = 0; i < _num_cells; i++)
+   {
+      int self = Get(old_cells, i);
+      word |= (uint64_t)_rule_table[2*(window - self) + self] << (i & 63);
+      if((i & 63) == 63 || i == _num_cells - 1)
       {
-         if(i < neighbors.size()/2)
-         {
-            neighbor_positions.push_back(Point(-1, 0));
-         }
-         else
-         {
-            neighbor_positions.push_back(Point(1, 0));
-         }
+         _cells[i >> 6] = word;
+         word = 0;
+      }
+
+      if(degree == 2*_radius)
+      {
+         window += Get(old_cells, enter) - Get(old_cells, leave);
+         if(++enter == _num_cells) enter = 0;
+         if(++leave == _num_cells) leave = 0;
       }
-      new_states[i] = rule.Apply(_states[i], neighbor_states);
    }
-   _old_states = _states;
-   _states = new_states;
    _steps++;
 }
 
 bool OneDLattice::IsChanging() const
 {
    if(_steps <= 1) return true;
-   else            return _old_states != _states;
+   else            return _old_cells != _cells;
 }
 
 void OneDLattice::Shuffle()
 {
-   std::shuffle(_states.begin(), _states.end(), _rng);
+   // Fisher-Yates on the packed bits
+   for(int i = _num_cells - 1; i > 0; i--)
+   {
+      int j = std::uniform_int_distribution<int>(0, i)(_rng);
+      int s = Get(_cells, i);
+      Set(_cells, i, Get(_cells, j));
+      Set(_cells, j, s);
+   }
 }
 
 std::ostream& operator<<(std::ostream &out, const OneDLattice& l)
 {
-   for(auto s : l._states)
+   for(int i = 0; i < l._num_cells; i++)
    {
-      out << s;
+      out << l.Get(l._cells, i);
    }
    return out;
 }
@@ -1,26 +1,31 @@
 #include "Point.hpp"
 #include <cmath>
 
-Point::Point(double x, double y) :
+template<typename Real>
+BasicPoint<Real>::BasicPoint(Real x, Real y) :
    _x(x),
    _y(y)
 {}
 
-Point::~Point() {}
+template<typename Real>
+BasicPoint<Real>::~BasicPoint() {}
 
-double Point::GetX() const
+template<typename Real>
+Real BasicPoint<Real>::GetX() const
 {
    return _x;
 }
 
-double Point::GetY() const
+template<typename Real>
+Real BasicPoint<Real>::GetY() const
 {
    return _y;
 }
 
-double Point::Distance(const Point& p) const
+template<typename Real>
+Real BasicPoint<Real>::Distance(const BasicPoint& p) const
 {
-   return sqrt(pow(_x - p._x, 2) + pow(_y - p._y, 2));
+   return std::sqrt((_x - p._x)*(_x - p._x) + (_y - p._y)*(_y - p._y));
 }
 
 /**
@@ -32,7 +37,8 @@ bool in_range(double x, double min, double max)
 }
 
 #if 0
-bool Point::NorthEeastOf(const Point& p) const
+template<typename Real>
+bool BasicPoint<Real>::NorthEeastOf(const BasicPoint& p) const
 {
    double adjusted_x = _x - p._x;
    double adjusted_y = _y - p._y;
@@ -40,7 +46,8 @@ bool Point::NorthEeastOf(const Point& p) const
    return in_range(theta, M_PI/8.0, 3*M_PI/8.0);
 }
 
-bool Point::NorthWestOf(const Point& p) const
+template<typename Real>
+bool BasicPoint<Real>::NorthWestOf(const BasicPoint& p) const
 {
    double adjusted_x = _x - p._x;
    double adjusted_y = _y - p._y;
@@ -49,7 +56,8 @@ bool Point::NorthWestOf(const Point& p) const
 }
 #endif
 
-bool Point::DueNorthOf(const Point& p) const
+template<typename Real>
+bool BasicPoint<Real>::DueNorthOf(const BasicPoint& p) const
 {
    double adjusted_x = _x - p._x;
    double adjusted_y = _y - p._y;
@@ -57,7 +65,8 @@ bool Point::DueNorthOf(const Point& p) const
    return in_range(theta, 3*M_PI/8.0, 5*M_PI/8.0);
 }
 
-bool Point::NorthOf(const Point& p) const
+template<typename Real>
+bool BasicPoint<Real>::NorthOf(const BasicPoint& p) const
 {
    double adjusted_x = _x - p._x;
    double adjusted_y = _y - p._y;
@@ -65,7 +74,8 @@ bool Point::NorthOf(const Point& p) const
    return in_range(theta, M_PI/4.0, 3*M_PI/4.0);
 }
 
-bool Point::DueEastOf(const Point& p) const
+template<typename Real>
+bool BasicPoint<Real>::DueEastOf(const BasicPoint& p) const
 {
    double adjusted_x = _x - p._x;
    double adjusted_y = _y - p._y;
@@ -73,7 +83,8 @@ bool Point::DueEastOf(const Point& p) const
    return in_range(theta, -M_PI/8.0, M_PI/8.0);
 }
 
-bool Point::EastOf(const Point& p) const
+template<typename Real>
+bool BasicPoint<Real>::EastOf(const BasicPoint& p) const
 {
    double adjusted_x = _x - p._x;
    double adjusted_y = _y - p._y;
@@ -81,7 +92,8 @@ bool Point::EastOf(const Point& p) const
    return in_range(theta, -M_PI/4.0, M_PI/4.0);
 }
 
-bool Point::DueWestOf(const Point& p) const
+template<typename Real>
+bool BasicPoint<Real>::DueWestOf(const BasicPoint& p) const
 {
    double adjusted_x = _x - p._x;
    double adjusted_y = _y - p._y;
@@ -93,7 +105,8 @@ bool Point::DueWestOf(const Point& p) const
    return in_range(theta, 7.0*M_PI/8.0, 9.0*M_PI/8.0);
 }
 
-bool Point::WestOf(const Point& p) const
+template<typename Real>
+bool BasicPoint<Real>::WestOf(const BasicPoint& p) const
 {
    double adjusted_x = _x - p._x;
    double adjusted_y = _y - p._y;
@@ -105,7 +118,8 @@ bool Point::WestOf(const Point& p) const
    return in_range(theta, 3*M_PI/4.0, 5*M_PI/4.0);
 }
 
-bool Point::DueSouthOf(const Point& p) const
+template<typename Real>
+bool BasicPoint<Real>::DueSouthOf(const BasicPoint& p) const
 {
    double adjusted_x = _x - p._x;
    double adjusted_y = _y - p._y;
@@ -117,7 +131,8 @@ bool Point::DueSouthOf(const Point& p) const
    return in_range(theta, (2*M_PI)-5.0*M_PI/8.0, (2*M_PI)-3.0*M_PI/8.0);
 }
 
-bool Point::SouthOf(const Point& p) const
+template<typename Real>
+bool BasicPoint<Real>::SouthOf(const BasicPoint& p) const
 {
    double adjusted_x = _x - p._x;
    double adjusted_y = _y - p._y;
@@ -129,22 +144,36 @@ bool Point::SouthOf(const Point& p) const
    return in_range(theta, (2*M_PI)-3.0*M_PI/4.0, (2*M_PI)-M_PI/4.0);
 }
 
-bool Point::Within(double d, const Point& p) const
+template<typename Real>
+bool BasicPoint<Real>::Within(Real d, const BasicPoint& p) const
 {
    return Distance(p) <= d;
 }
 
-bool operator== (const Point& p, const Point& q)
+template<typename Real>
+bool operator== (const BasicPoint<Real>& p, const BasicPoint<Real>& q)
 {
-   return (p._x == q._x) && (p._y == q._y);
+   return (p.GetX() == q.GetX()) && (p.GetY() == q.GetY());
 }
 
-bool operator!= (const Point& p, const Point& q)
+template<typename Real>
+bool operator!= (const BasicPoint<Real>& p, const BasicPoint<Real>& q)
 {
    return !(p == q);
 }
 
-std::ostream& operator<< (std::ostream& out, const Point& p)
+template<typename Real>
+std::ostream& operator<< (std::ostream& out, const BasicPoint<Real>& p)
 {
-   return out << "Point(" << p._x << "," << p._y << ")";
+   return out << "Point(" << p.GetX() << "," << p.GetY() << ")";
 }
+
+template class BasicPoint<float>;
+template class BasicPoint<double>;
+
+template bool operator== (const BasicPoint<float>&, const BasicPoint<float>&);
+template bool operator== (const BasicPoint<double>&, const BasicPoint<double>&);
+template bool operator!= (const BasicPoint<float>&, const BasicPoint<float>&);
+template bool operator!= (const BasicPoint<double>&, const BasicPoint<double>&);
+template std::ostream& operator<< (std::ostream&, const BasicPoint<float>&);
+template std::ostream& operator<< (std::ostream&, const BasicPoint<double>&);
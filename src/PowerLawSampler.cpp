@@ -0,0 +1,98 @@
+#include "PowerLawSampler.hpp"
+
+#include <cmath>
+
+namespace
+{
+   /**
+    * P(z < x) for the continuous truncated power law on [1, max_step].
+    */
+   double power_law_cdf(double mu, int max_step, double x)
+   {
+      if(x >= max_step) return 1.0;
+      if(mu == 1.0)     return log(x) / log((double)max_step);
+      return (pow(x, 1.0 - mu) - 1.0) / (pow((double)max_step, 1.0 - mu) - 1.0);
+   }
+}
+
+PowerLawSampler::PowerLawSampler(double mu, int max_step)
+{
+   int n = max_step > 1 ? max_step - 1 : 1; // floor(z) == max_step has probability zero
+   _probability.resize(n);
+   _threshold.resize(n);
+   _alias.resize(n);
+
+   if(max_step <= 1)
+   {
+      _probability[0] = 1.0;
+   }
+   else
+   {
+      for(int k = 1; k <= n; k++)
+      {
+         _probability[k-1] = power_law_cdf(mu, max_step, k+1) - power_law_cdf(mu, max_step, k);
+      }
+   }
+
+   // Vose's alias method
+   std::vector<double> scaled(n);
+   std::vector<int> small;
+   std::vector<int> large;
+   for(int i = 0; i < n; i++)
+   {
+      scaled[i] = _probability[i] * n;
+      if(scaled[i] < 1.0) small.push_back(i);
+      else                large.push_back(i);
+   }
+
+   while(!small.empty() && !large.empty())
+   {
+      int s = small.back(); small.pop_back();
+      int l = large.back(); large.pop_back();
+
+      _threshold[s] = (uint32_t)std::min(scaled[s] * 4294967296.0, 4294967295.0);
+      _alias[s]     = l;
+
+      scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+      if(scaled[l] < 1.0) small.push_back(l);
+      else                large.push_back(l);
+   }
+
+   // Whatever is left over has (up to rounding) probability one.
+   for(int i : large)
+   {
+      _threshold[i] = 0xffffffff;
+      _alias[i]     = i;
+   }
+   for(int i : small)
+   {
+      _threshold[i] = 0xffffffff;
+      _alias[i]     = i;
+   }
+}
+
+int PowerLawSampler::operator()(std::mt19937_64& gen) const
+{
+   uint64_t r = gen();
+   // high bits choose the column, low bits decide between it and its alias
+   uint32_t column = (uint32_t)(((r >> 32) * _alias.size()) >> 32);
+   if((uint32_t)r < _threshold[column])
+   {
+      return column + 1;
+   }
+   else
+   {
+      return _alias[column] + 1;
+   }
+}
+
+double PowerLawSampler::Probability(int k) const
+{
+   if(k < 1 || k > _probability.size()) return 0.0;
+   return _probability[k-1];
+}
+
+int PowerLawSampler::MaxStep() const
+{
+   return _probability.size();
+}
@@ -41,6 +41,26 @@ bool Range::Contains(double k) const
    }
 }
 
+double Range::Min() const
+{
+   return min_;
+}
+
+double Range::Max() const
+{
+   return max_;
+}
+
+bool Range::IncludesMin() const
+{
+   return include_min_;
+}
+
+bool Range::IncludesMax() const
+{
+   return include_max_;
+}
+
 std::ostream& operator<<(std::ostream& out, const Range& r)
 {
    return out << (r.include_min_ ? "[" : "(") << r.min_ << "," << r.max_ << (r.include_max_ ? "]" : ")");
@@ -0,0 +1,155 @@
+#include "ReplicaLattice.hpp"
+#include "BitSlice.hpp"
+
+#include <algorithm>
+
+const int ReplicaLattice::WIDTH;
+
+ReplicaLattice::ReplicaLattice(int num_cells, int radius, bool flip) :
+   _num_cells(num_cells),
+   _radius(radius),
+   _flip(flip),
+   _old_cells(num_cells, 0),
+   _cells(num_cells, 0),
+   _active(~(uint64_t)0),
+   _steps(0)
+{
+   std::random_device rd;
+   _rng.seed(rd());
+}
+
+int ReplicaLattice::Degree() const
+{
+   return 2*_radius + 1 >= _num_cells ? _num_cells - 1 : 2*_radius;
+}
+
+void ReplicaLattice::Seed(int seed)
+{
+   _rng.seed(seed);
+}
+
+void ReplicaLattice::SetDensity(double density, int num_replicas)
+{
+   num_replicas = std::max(std::min(num_replicas, WIDTH), 0);
+   std::uniform_real_distribution<double> uniform(0.0, 1.0);
+   for(uint64_t& cell : _cells)
+   {
+      cell = 0;
+      for(int j = 0; j < num_replicas; j++)
+      {
+         cell |= (uint64_t)(uniform(_rng) < density) << j;
+      }
+   }
+   _active = num_replicas == WIDTH ? ~(uint64_t)0 : ((uint64_t)1 << num_replicas) - 1;
+   _steps = 0;
+}
+
+std::vector<double> ReplicaLattice::GetDensities() const
+{
+   std::vector<int> ones(WIDTH, 0);
+   for(uint64_t cell : _cells)
+   {
+      while(cell != 0)
+      {
+         ones[__builtin_ctzll(cell)]++;
+         cell &= cell - 1;
+      }
+   }
+
+   std::vector<double> densities(WIDTH);
+   for(int j = 0; j < WIDTH; j++)
+   {
+      densities[j] = (double)ones[j] / (double)_num_cells;
+   }
+   return densities;
+}
+
+std::vector<int> ReplicaLattice::GetStates(int j) const
+{
+   std::vector<int> states(_num_cells);
+   for(int i = 0; i < _num_cells; i++)
+   {
+      states[i] = (_cells[i] >> j) & 1;
+   }
+   return states;
+}
+
+void ReplicaLattice::Step()
+{
+   // the majority is taken over the neighbors and the cell itself
+   int total = Degree() + 1;
+   int num_planes = bitslice::Planes(total);
+
+   std::swap(_old_cells, _cells);
+   const std::vector<uint64_t>& old_cells = _old_cells;
+
+   // count of ones in the window [i - r, i + r] for i = 0
+   uint64_t planes[bitslice::MAX_PLANES] = {0};
+   bool wrapped = Degree() != 2*_radius;
+   if(wrapped)
+   {
+      for(uint64_t cell : old_cells) bitslice::Add(planes, num_planes, cell);
+   }
+   else
+   {
+      for(int j = -_radius; j <= _radius; j++)
+      {
+         bitslice::Add(planes, num_planes, old_cells[(j + _num_cells) % _num_cells]);
+      }
+   }
+
+   // MajorityRule: one if more than half are ones, tie if exactly half
+   int  half     = total / 2;
+   bool can_tie  = total % 2 == 0;
+   int  enter    = (_radius + 1) % _num_cells;
+   int  leave    = (_num_cells - _radius) % _num_cells;
+   uint64_t changed = 0;
+   for(int i = 0; i < _num_cells; i++)
+   {
+      uint64_t self = old_cells[i];
+      uint64_t greater, equal;
+      bitslice::Compare(planes, num_planes, half, greater, equal);
+
+      uint64_t next = greater;
+      if(can_tie)
+      {
+         next |= equal & (_flip ? ~self : self);
+      }
+      next = (next & _active) | (self & ~_active);
+      _cells[i] = next;
+      changed |= next ^ self;
+
+      if(!wrapped)
+      {
+         bitslice::Add(planes, num_planes, old_cells[enter]);
+         bitslice::Subtract(planes, num_planes, old_cells[leave]);
+         if(++enter == _num_cells) enter = 0;
+         if(++leave == _num_cells) leave = 0;
+      }
+   }
+
+   _steps++;
+   if(_steps > 1)
+   {
+      _active &= changed;
+   }
+}
+
+uint64_t ReplicaLattice::ChangingMask() const
+{
+   return _active;
+}
+
+bool ReplicaLattice::IsChanging() const
+{
+   return _active != 0;
+}
+
+void ReplicaLattice::Shuffle()
+{
+   for(int i = _num_cells - 1; i > 0; i--)
+   {
+      int j = std::uniform_int_distribution<int>(0, i)(_rng);
+      std::swap(_cells[i], _cells[j]);
+   }
+}
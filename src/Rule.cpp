@@ -1,6 +1,24 @@
 #include "Rule.hpp"
 
-#include <numeric> // std::accumulate
+#include <numeric>   // std::accumulate
+#include <algorithm> // std::fill
+
+std::pair<int, double> Rule::Apply(int self, int ones, int total) const
+{
+   std::vector<int> neighbors(total, 0);
+   std::fill(neighbors.begin(), neighbors.begin() + ones, 1);
+   return Apply(self, neighbors);
+}
+
+std::pair<int, double> Rule::Apply(int self, const int* counts, int num_states) const
+{
+   std::vector<int> neighbors;
+   for(int s = 0; s < num_states; s++)
+   {
+      neighbors.insert(neighbors.end(), counts[s], s);
+   }
+   return Apply(self, neighbors);
+}
 
 Identity::Identity() {}
 Identity::~Identity() {}
@@ -10,18 +28,33 @@ std::pair<int, double> Identity::Apply(int self, const std::vector<int>& neighbo
    return std::make_pair(self, 0);
 }
 
+std::pair<int, double> Identity::Apply(int self, int ones, int total) const
+{
+   return std::make_pair(self, 0);
+}
+
+std::pair<int, double> Identity::Apply(int self, const int* counts, int num_states) const
+{
+   return std::make_pair(self, 0);
+}
+
 MajorityRule::MajorityRule() {}
 MajorityRule::MajorityRule(bool f) : flip(f) {}
 MajorityRule::~MajorityRule() {}
 
 std::pair<int, double> MajorityRule::Apply(int self, const std::vector<int>& neighbors) const
 {
-   int n = std::accumulate(neighbors.begin(), neighbors.end(), 0) + self;
-   if((double)n > ((double)neighbors.size()+1) / 2.0)
+   return Apply(self, std::accumulate(neighbors.begin(), neighbors.end(), 0), neighbors.size());
+}
+
+std::pair<int, double> MajorityRule::Apply(int self, int ones, int total) const
+{
+   int n = ones + self;
+   if((double)n > ((double)total+1) / 2.0)
    {
       return std::make_pair(1, 0);
    }
-   else if((double)n == (double)(neighbors.size()+1) / 2.0)
+   else if((double)n == (double)(total+1) / 2.0)
    {
       return std::make_pair(flip ? 1 - self : self, 0);
    }
@@ -39,6 +72,16 @@ std::pair<int, double> Constant::Apply(int self, const std::vector<int>& neighbo
    return std::make_pair(state, 0);
 }
 
+std::pair<int, double> Constant::Apply(int self, int ones, int total) const
+{
+   return std::make_pair(state, 0);
+}
+
+std::pair<int, double> Constant::Apply(int self, const int* counts, int num_states) const
+{
+   return std::make_pair(state, 0);
+}
+
 /**
  * Utility function to compute the density in the neighborhood
  * including self.
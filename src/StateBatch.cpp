@@ -0,0 +1,133 @@
+#include "StateBatch.hpp"
+#include "BitSlice.hpp"
+
+#include <algorithm> // std::min
+
+StateBatch::StateBatch(int num_agents, const std::vector<double>& densities, std::mt19937_64& gen) :
+   _num_agents(num_agents),
+   _num_vectors(densities.size()),
+   _words((densities.size() + 63) / 64),
+   _states(num_agents * ((densities.size() + 63) / 64), 0),
+   _active((densities.size() + 63) / 64, 0),
+   _initial_density(densities.size()),
+   _ones(densities.size(), 0),
+   _convergence_time(densities.size(), -1),
+   _steps(0)
+{
+   for(int j = 0; j < _num_vectors; j++)
+   {
+      std::bernoulli_distribution state_distribution(densities[j]);
+      for(int a = 0; a < _num_agents; a++)
+      {
+         _states[a*_words + j/64] |= (uint64_t)state_distribution(gen) << (j % 64);
+      }
+      _active[j/64] |= (uint64_t)1 << (j % 64);
+   }
+
+   Tally();
+   for(int j = 0; j < _num_vectors; j++)
+   {
+      _initial_density[j] = Density(j);
+   }
+}
+
+int StateBatch::NumAgents() const
+{
+   return _num_agents;
+}
+
+int StateBatch::NumVectors() const
+{
+   return _num_vectors;
+}
+
+int StateBatch::Words() const
+{
+   return _words;
+}
+
+const uint64_t* StateBatch::States(int a) const
+{
+   return &_states[a*_words];
+}
+
+uint64_t StateBatch::ActiveMask(int w) const
+{
+   return _active[w];
+}
+
+void StateBatch::Update(const std::vector<uint64_t>& next)
+{
+   _states = next;
+   _steps++;
+   Tally();
+}
+
+void StateBatch::Tally()
+{
+   int num_planes = bitslice::Planes(_num_agents);
+   for(int w = 0; w < _words; w++)
+   {
+      uint64_t planes[bitslice::MAX_PLANES] = {0};
+      for(int a = 0; a < _num_agents; a++)
+      {
+         bitslice::Add(planes, num_planes, _states[a*_words + w]);
+      }
+
+      for(int j = w*64; j < std::min(_num_vectors, (w+1)*64); j++)
+      {
+         _ones[j] = bitslice::Count(planes, num_planes, j % 64);
+         if(_convergence_time[j] < 0 && (_ones[j] == 0 || _ones[j] == _num_agents))
+         {
+            _convergence_time[j] = _steps;
+            _active[w] &= ~((uint64_t)1 << (j % 64));
+         }
+      }
+   }
+}
+
+int StateBatch::State(int j, int a) const
+{
+   return (_states[a*_words + j/64] >> (j % 64)) & 1;
+}
+
+double StateBatch::InitialDensity(int j) const
+{
+   return _initial_density[j];
+}
+
+double StateBatch::Density(int j) const
+{
+   return (double)_ones[j] / (double)_num_agents;
+}
+
+bool StateBatch::IsConverged(int j) const
+{
+   return _convergence_time[j] >= 0;
+}
+
+int StateBatch::ConvergenceTime(int j) const
+{
+   return _convergence_time[j];
+}
+
+bool StateBatch::IsCorrect(int j) const
+{
+   if(_initial_density[j] >= 0.5)
+   {
+      return Density(j) == 1.0;
+   }
+   else
+   {
+      return Density(j) == 0.0;
+   }
+}
+
+bool StateBatch::AllConverged() const
+{
+   for(uint64_t active : _active)
+   {
+      if(active != 0) return false;
+   }
+   return true;
+}
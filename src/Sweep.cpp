@@ -0,0 +1,131 @@
+#include "Sweep.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "ThreadPool.hpp"
+
+namespace
+{
+   /**
+    * A worker's tasks. The owner takes from the back and thieves from
+    * the front.
+    */
+   struct TaskQueue
+   {
+      std::mutex      mutex;
+      std::deque<size_t> tasks;
+
+      bool PopBack(size_t& task)
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         if(tasks.empty()) return false;
+         task = tasks.back();
+         tasks.pop_back();
+         return true;
+      }
+
+      bool PopFront(size_t& task)
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         if(tasks.empty()) return false;
+         task = tasks.front();
+         tasks.pop_front();
+         return true;
+      }
+   };
+}
+
+Sweep::Sweep(int num_points, int num_replicas, int num_threads) :
+   _num_points(std::max(num_points, 0)),
+   _num_replicas(std::max(num_replicas, 0)),
+   _num_threads(num_threads),
+   _steals(0)
+{
+   if(_num_threads <= 0)
+   {
+      _num_threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+   }
+}
+
+int Sweep::NumPoints() const
+{
+   return _num_points;
+}
+
+int Sweep::NumReplicas() const
+{
+   return _num_replicas;
+}
+
+int Sweep::NumThreads() const
+{
+   return _num_threads;
+}
+
+int Sweep::Steals() const
+{
+   return _steals;
+}
+
+void Sweep::Schedule(const std::function<void(int point, int replica)>& task)
+{
+   size_t num_tasks = static_cast<size_t>(_num_points) * _num_replicas;
+   int num_workers = static_cast<int>(std::max<size_t>(std::min<size_t>(_num_threads, num_tasks), 1));
+   std::vector<TaskQueue> queues(num_workers);
+   for(size_t t = 0; t < num_tasks; t++)
+   {
+      queues[t % num_workers].tasks.push_back(t);
+   }
+
+   // Tasks never make more tasks, so a worker that finds every queue
+   // empty is done.
+   std::atomic<bool> failed(false);
+   std::atomic<int>  steals(0);
+   ThreadPool pool(num_workers);
+   pool.ParallelFor(num_workers, [&](int, int, int worker)
+                    {
+                       size_t t;
+                       while(!failed)
+                       {
+                          bool stolen = false;
+                          if(!queues[worker].PopBack(t))
+                          {
+                             for(int v = 1; v < num_workers && !stolen; v++)
+                             {
+                                stolen = queues[(worker + v) % num_workers].PopFront(t);
+                             }
+                             if(!stolen) return;
+                             steals++;
+                          }
+
+                          try
+                          {
+                             task(static_cast<int>(t / _num_replicas), static_cast<int>(t % _num_replicas));
+                          }
+                          catch(...)
+                          {
+                             failed = true;
+                             throw;
+                          }
+                       }
+                    });
+   _steals = steals;
+}
+
+std::vector<double> Sweep::Proportion(const std::function<bool(int point, int replica)>& success)
+{
+   std::vector<int> counts = Run<int>([&](int point, int replica) { return success(point, replica) ? 1 : 0; },
+                                      [](const int& a, const int& b) { return a + b; },
+                                      0);
+   std::vector<double> proportions;
+   for(int count : counts)
+   {
+      proportions.push_back(_num_replicas > 0 ? (double) count / _num_replicas : 0.0);
+   }
+   return proportions;
+}
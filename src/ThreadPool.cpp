@@ -0,0 +1,110 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(int num_threads) :
+   _task(nullptr),
+   _size(0),
+   _running(0),
+   _generation(0),
+   _stop(false)
+{
+   for(int worker = 1; worker < num_threads; worker++)
+   {
+      _threads.emplace_back(&ThreadPool::Work, this, worker);
+   }
+}
+
+ThreadPool::~ThreadPool()
+{
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+   }
+   _start.notify_all();
+   for(std::thread& thread : _threads)
+   {
+      thread.join();
+   }
+}
+
+int ThreadPool::NumThreads() const
+{
+   return _threads.size() + 1;
+}
+
+void ThreadPool::RunShare(int worker)
+{
+   long long num_threads = NumThreads();
+   int begin = _size * worker / num_threads;
+   int end   = _size * (worker + 1) / num_threads;
+   try
+   {
+      (*_task)(begin, end, worker);
+   }
+   catch(...)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(!_error)
+      {
+         _error = std::current_exception();
+      }
+   }
+}
+
+void ThreadPool::Work(int worker)
+{
+   unsigned long generation = 0;
+   while(true)
+   {
+      {
+         std::unique_lock<std::mutex> lock(_mutex);
+         _start.wait(lock, [&]() { return _stop || _generation != generation; });
+         if(_stop)
+         {
+            return;
+         }
+         generation = _generation;
+      }
+
+      RunShare(worker);
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(--_running == 0)
+      {
+         _finished.notify_one();
+      }
+   }
+}
+
+void ThreadPool::ParallelFor(int size, const Task& task)
+{
+   if(_threads.empty())
+   {
+      task(0, size, 0);
+      return;
+   }
+
+   std::lock_guard<std::mutex> loop_lock(_loop_mutex);
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _task    = &task;
+      _size    = size;
+      _running = _threads.size();
+      _error   = nullptr;
+      _generation++;
+   }
+   _start.notify_all();
+
+   RunShare(0);
+
+   std::exception_ptr error;
+   {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _finished.wait(lock, [&]() { return _running == 0; });
+      error = _error;
+      _task = nullptr;
+   }
+   if(error)
+   {
+      std::rethrow_exception(error);
+   }
+}
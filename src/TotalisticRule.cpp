@@ -1,10 +1,53 @@
 #include "TotalisticRule.hpp"
 #include "Transition.hpp"
 
-#include <numeric>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 #include <utility>
 
+namespace
+{
+   const int NO_MATCH = std::numeric_limits<int>::max();
+
+   /**
+    * Indices, in table order, of the transitions that apply to state (or
+    * to any state if any_only) and compute the density as given.
+    */
+   std::vector<int> select_transitions(const std::vector<Transition>& table, bool include_self,
+                                       int density_state, bool any_only, int state)
+   {
+      std::vector<int> group;
+      for(int i = 0; i < (int)table.size(); i++)
+      {
+         const Transition& t = table[i];
+         if(t.include_self == include_self && t.density_state == density_state &&
+            (t.any_state || (!any_only && t.pre_state == state)))
+         {
+            group.push_back(i);
+         }
+      }
+      return group;
+   }
+
+   /**
+    * The new state and heading change when t fires for an agent in
+    * state self.
+    */
+   std::pair<int, double> apply(const Transition& t, int self)
+   {
+      if(t.result_self) return std::make_pair(self, t.heading_change);
+      else return std::make_pair(t.result_state, t.heading_change);
+   }
+}
+
+TotalisticRule::TotalisticRule()
+{
+   Compile();
+}
+
 std::istream& operator>>(std::istream& stream, TotalisticRule& rule)
 {
    TotalisticRule temp;
@@ -25,57 +68,243 @@ std::istream& operator>>(std::istream& stream, TotalisticRule& rule)
       line_number++;
    }
 
+   temp.Compile(rule.max_degree_);
    rule = std::move(temp);
    return stream;
 }
 
-double density(const std::vector<int>& neighborhood)
+void TotalisticRule::IntervalIndex::Build(const std::vector<Transition>& table,
+                                          const std::vector<int>& group)
 {
-   return ((double)std::accumulate(neighborhood.begin(), neighborhood.end(), 0)
-           / (double)neighborhood.size());
+   boundaries_.clear();
+   for(int i : group)
+   {
+      boundaries_.push_back(table[i].range.Min());
+      boundaries_.push_back(table[i].range.Max());
+   }
+   std::sort(boundaries_.begin(), boundaries_.end());
+   boundaries_.erase(std::unique(boundaries_.begin(), boundaries_.end()), boundaries_.end());
+
+   // Piece 2k is the open interval below boundaries_[k] and piece
+   // 2k+1 is boundaries_[k] itself. Nothing lies below the smallest or
+   // above the largest boundary. Every range either contains all of an
+   // open interval or none of it, so testing one point decides it.
+   int n = boundaries_.size();
+   first_.assign(2*n + 1, NO_MATCH);
+   for(int piece = 1; piece < 2*n; piece++)
+   {
+      int k = piece / 2;
+      double x = boundaries_[k];
+      if(piece % 2 == 0)
+      {
+         x = boundaries_[k-1] + (boundaries_[k] - boundaries_[k-1]) / 2.0;
+      }
+      for(int i : group)
+      {
+         if(table[i].range.Contains(x))
+         {
+            first_[piece] = i;
+            break;
+         }
+      }
+   }
 }
 
-bool matches(Transition& t, int self, const std::vector<int>& neighbors)
+int TotalisticRule::IntervalIndex::Find(double density) const
 {
-   if(t.any_state || self == t.pre_state)
+   if(std::isnan(density))
    {
-      double neighborhood_density;
+      return NO_MATCH;
+   }
+   auto boundary = std::lower_bound(boundaries_.begin(), boundaries_.end(), density);
+   int k = boundary - boundaries_.begin();
+   if(boundary != boundaries_.end() && *boundary == density)
+   {
+      return first_[2*k + 1];
+   }
+   return first_[2*k];
+}
 
-      std::vector<int> neighborhood(neighbors.size());
-      std::copy(neighbors.begin(), neighbors.end(), neighborhood.begin());
-      if(t.include_self)
+void TotalisticRule::BuildIndex()
+{
+   auto build = [this](bool any_only, int state)
       {
-         neighborhood.push_back(self);
+         StateIndex index;
+         for(const Transition& t : transition_table_)
+         {
+            if(!(t.any_state || (!any_only && t.pre_state == state))) continue;
+
+            bool seen = false;
+            for(const IntervalIndex& group : index)
+            {
+               seen |= group.include_self_ == t.include_self
+                  && group.density_state_ == t.density_state;
+            }
+            if(seen) continue;
+
+            IntervalIndex group;
+            group.include_self_  = t.include_self;
+            group.density_state_ = t.density_state;
+            group.Build(transition_table_,
+                        select_transitions(transition_table_, t.include_self, t.density_state, any_only, state));
+            index.push_back(group);
+         }
+         return index;
+      };
+
+   any_index_ = build(true, 0);
+   state_index_.clear();
+   for(const Transition& t : transition_table_)
+   {
+      if(!t.any_state && state_index_.count(t.pre_state) == 0)
+      {
+         state_index_[t.pre_state] = build(false, t.pre_state);
       }
+   }
+}
 
-      neighborhood_density = density(neighborhood);
+std::pair<int, double> TotalisticRule::Interpret(int self, const int* counts, int num_states) const
+{
+   const StateIndex* index = &any_index_;
+   auto found = state_index_.find(self);
+   if(found != state_index_.end())
+   {
+      index = &found->second;
+   }
 
-      if(t.range.Contains(neighborhood_density))
+   int sum   = 0;
+   int total = 0;
+   for(int s = 0; s < num_states; s++)
+   {
+      sum   += s * counts[s];
+      total += counts[s];
+   }
+
+   // The first matching transition is the earliest of the first
+   // matches in each group.
+   int first = NO_MATCH;
+   for(const IntervalIndex& group : *index)
+   {
+      int state = group.density_state_;
+      int n = state < 0 ? sum : (state < num_states ? counts[state] : 0);
+      int d = total;
+      if(group.include_self_)
       {
-         return true;
+         n += state < 0 ? self : (self == state);
+         d++;
       }
+      first = std::min(first, group.Find((double)n / (double)d));
    }
-   return false;
+   if(first != NO_MATCH)
+   {
+      return apply(transition_table_[first], self);
+   }
+
+   // If no rule applies then state remains unchanged.
+   return std::make_pair(self, 0); // XXX: is this the right thing to do.
 }
 
-std::pair<int, double> apply(Transition t, int self)
+std::vector<std::pair<int, double>> TotalisticRule::CompileRow(int degree) const
 {
-   if(t.result_self) return std::make_pair(self, t.heading_change);
-   else return std::make_pair(t.result_state, t.heading_change);
+   std::vector<Result> row(2*(degree+1));
+   for(int ones = 0; ones <= degree; ones++)
+   {
+      int counts[2] = {degree - ones, ones};
+      row[2*ones]   = Interpret(0, counts, 2);
+      row[2*ones+1] = Interpret(1, counts, 2);
+   }
+   return row;
 }
 
-std::pair<int, double> TotalisticRule::Apply(int self, const std::vector<int>& neighbors) const
+void TotalisticRule::Compile(int max_degree)
 {
-   // Look for rules that match the current state
-   // Apply the first rule that matches
-   for(Transition t : transition_table_)
+   BuildIndex();
+   max_degree_ = max_degree;
+   table_.clear();
+   for(int degree = 0; degree <= max_degree; degree++)
    {
-      if(matches(t, self, neighbors))
+      std::vector<Result> row = CompileRow(degree);
+      table_.insert(table_.end(), row.begin(), row.end());
+   }
+   lazy_rows_ = std::make_shared<LazyRows>();
+}
+
+const std::pair<int, double>* TotalisticRule::LazyRow(int degree) const
+{
+   bool publish = degree < LazyRows::PUBLISHED;
+   if(publish)
+   {
+      const Result* built = lazy_rows_->published[degree].load(std::memory_order_acquire);
+      if(built != nullptr)
       {
-         return apply(t, self);
+         return built;
       }
    }
 
-   // If no rule applies then state remains unchanged.
-   return std::make_pair(self, 0); // XXX: is this the right thing to do.
+   std::lock_guard<std::mutex> lock(lazy_rows_->mutex);
+   auto row = lazy_rows_->rows.find(degree);
+   if(row == lazy_rows_->rows.end())
+   {
+      row = lazy_rows_->rows.emplace(degree, CompileRow(degree)).first;
+   }
+   if(publish)
+   {
+      lazy_rows_->published[degree].store(row->second.data(), std::memory_order_release);
+   }
+   return row->second.data();
+}
+
+std::pair<int, double> TotalisticRule::Apply(int self, int ones, int total) const
+{
+   if((self != 0 && self != 1) || ones < 0 || ones > total)
+   {
+      int counts[2] = {total - ones, ones};
+      return Interpret(self, counts, 2);
+   }
+
+   if(total <= max_degree_)
+   {
+      return table_[2*(total*(total+1)/2 + ones) + self];
+   }
+   return LazyRow(total)[2*ones + self];
+}
+
+std::pair<int, double> TotalisticRule::Apply(int self, const int* counts, int num_states) const
+{
+   for(int s = 2; s < num_states; s++)
+   {
+      if(counts[s] != 0)
+      {
+         return Interpret(self, counts, num_states);
+      }
+   }
+   int zeros = num_states > 0 ? counts[0] : 0;
+   int ones  = num_states > 1 ? counts[1] : 0;
+   return Apply(self, ones, zeros + ones);
+}
+
+std::pair<int, double> TotalisticRule::Apply(int self, const std::vector<int>& neighbors) const
+{
+   int sum = 0;
+   int max_state = 1;
+   for(int n : neighbors)
+   {
+      sum += n;
+      max_state = std::max(max_state, n);
+   }
+   if(max_state == 1)
+   {
+      return Apply(self, sum, neighbors.size());
+   }
+
+   std::vector<int> counts(max_state + 1, 0);
+   for(int n : neighbors)
+   {
+      if(n < 0)
+      {
+         throw std::out_of_range("negative neighbor state");
+      }
+      counts[n]++;
+   }
+   return Interpret(self, counts.data(), counts.size());
 }
@@ -1,18 +1,12 @@
-#include <random>
 #include <iostream>
 #include <cstdlib> // atoi
-#include <functional>
 #include <cmath>
-#include <thread> // hardware_concurrency()
-#include <mutex>
-#include <chrono>
-#include <utility>
-#include <map>
-#include <fstream>
+#include <vector>
 
 #include <getopt.h>
 
 #include "Model.hpp"
+#include "Sweep.hpp"
 
 struct config {
    int    num_agents;
@@ -22,101 +16,42 @@ struct config {
    int    num_iterations;
 } model_config;
 
-std::mutex density_lock;
-double next_density = 0.05;
 const double DENSITY_STEP = 0.05;
 const double MAX_DENSITY  = 4.0;
-
-std::mutex output_lock;
+const double STATE_DENSITY_STEP = 0.02;
 
 MajorityRule majority_rule;
 
-double evaluate_ca(int num_iterations, double speed, double initial_density, int arena_size)
-{
-   std::uniform_real_distribution<double> heading_distribution(0, 2*M_PI);
-   int num_correct = 0;
-   for(int iteration = 0; iteration < num_iterations; iteration++)
-   {
-      Model m(arena_size,
-              model_config.num_agents,
-              model_config.communication_range,
-              model_config.seed+iteration,
-              initial_density,
-              speed);
-
-      m.SetMovementRule(std::make_shared<RandomWalk>());
-      m.RecordNetworkDensityOnly();
-
-      for(int step = 0; step < 2500; step++)
-      {
-         m.Step(&majority_rule);
-         if(m.CurrentDensity() == 0 || m.CurrentDensity() == 1)
-         {
-            break; // done. no need to keep evaluating.
-         }
-      }
-
-      if(m.GetStats().IsCorrect())
-      {
-         num_correct++;
-      }
-   }
-
-   return (double) num_correct / num_iterations;
-}
-
-void evaluate_density(double agent_density)
+/**
+ * Run replica iteration at the given initial density.
+ */
+bool evaluate_ca(int iteration, double speed, double initial_density, int arena_size)
 {
-   double arena_size = sqrt(model_config.num_agents / agent_density);
-   std::map<double, double> results;
-   for(double state_density = 0.0; state_density <= 1.001; state_density += 0.02)
-   {
-      double proportion_correct = evaluate_ca(model_config.num_iterations, model_config.speed,
-                                              state_density, arena_size);
-      results.emplace(state_density, proportion_correct);
-   }
+   Model m(arena_size,
+           model_config.num_agents,
+           model_config.communication_range,
+           model_config.seed+iteration,
+           initial_density,
+           speed);
 
-   output_lock.lock(); // lock to avoid interleaving output :/
-   for(auto result : results)
-   {
-      std::cout << agent_density << " "
-                << result.first  << " "
-                << result.second
-                << std::endl;
-   }
-   std::cout << std::endl;
-   output_lock.unlock();
-}
+   m.SetMovementRule(std::make_shared<RandomWalk>());
+   m.RecordNetworkDensityOnly();
 
-void thread_main()
-{
-   while(true)
+   for(int step = 0; step < 2500; step++)
    {
-      density_lock.lock();
-
-      double density = next_density;
-      next_density += DENSITY_STEP;
-
-      density_lock.unlock();
-
-      if(density <= MAX_DENSITY)
-      {
-         evaluate_density(density);
-      }
-      else
+      m.Step(&majority_rule);
+      if(m.CurrentDensity() == 0 || m.CurrentDensity() == 1)
       {
-         return;
+         break; // done. no need to keep evaluating.
       }
    }
+
+   return m.GetStats().IsCorrect();
 }
 
 int main(int argc, char** argv)
 {
    int    opt_char;
-   int    sweep_density   = 0;
-   double density_step    = 0.01;
-   double initial_density = 0.0;
-   int    save_state      = 0;
 
    model_config.communication_range = 1;
    model_config.num_agents          = 100;
@@ -170,18 +105,37 @@ int main(int argc, char** argv)
 
    model_config.speed = atof(argv[optind]);
 
-   int num_threads = std::thread::hardware_concurrency();
-
-   std::vector<std::thread> threads;
-
-   for(int i = 0; i < num_threads; i++)
+   std::vector<double> agent_densities, state_densities;
+   for(int i = 1; i * DENSITY_STEP <= MAX_DENSITY + 1e-9; i++)
    {
-      threads.push_back(std::thread(thread_main));
+      agent_densities.push_back(i * DENSITY_STEP);
+   }
+   for(int i = 0; i * STATE_DENSITY_STEP <= 1.001; i++)
+   {
+      state_densities.push_back(i * STATE_DENSITY_STEP);
    }
 
-   for(auto& t : threads)
+   // a point for every pair of densities
+   int num_state_densities = state_densities.size();
+   Sweep sweep(agent_densities.size() * num_state_densities, model_config.num_iterations);
+   std::vector<double> proportions = sweep.Proportion([&](int point, int replica)
+      {
+         double agent_density = agent_densities[point / num_state_densities];
+         double arena_size = sqrt(model_config.num_agents / agent_density);
+         return evaluate_ca(replica, model_config.speed,
+                            state_densities[point % num_state_densities], arena_size);
+      });
+
+   for(int point = 0; point < (int) proportions.size(); point++)
    {
-      t.join();
+      std::cout << agent_densities[point / num_state_densities] << " "
+                << state_densities[point % num_state_densities] << " "
+                << proportions[point]
+                << std::endl;
+      if(point % num_state_densities == num_state_densities - 1)
+      {
+         std::cout << std::endl;
+      }
    }
 
    return 0;
@@ -65,7 +65,7 @@ int main(int argc, char** argv)
    for(int i = 0; i < 100; i++)
    {
       std::unique_ptr<LCA> lca = factory.Create(initial_density);
-      lca->MinimizeMemory();
+      lca->RecordConvergenceOnly();
       int time = lca->Run([](const ModelStats& s) {
                              return (s.CurrentCADensity() == 0.0 || s.CurrentCADensity() == 1.0);
                           });
@@ -0,0 +1,98 @@
+#include "LCAFactory.hpp"
+
+#include <getopt.h>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+/**
+ * Compare the classification accuracy of the single and double
+ * precision models.
+ *
+ * usage: precision_validation [factory options] trials [density ...]
+ *
+ * For each initial density (0.05, 0.10, ..., 0.95 by default) both
+ * precisions are run for the given number of trials. Each output line
+ * holds the density, the fraction of trials classified correctly in
+ * double and in single precision, their difference (single minus
+ * double), and the two-proportion z-score of that difference. |z| > 2 at many densities
+ * suggests single precision changes the outcome of the experiment.
+ */
+
+int count_correct(LCAFactory& factory, double initial_density, int trials)
+{
+   int num_correct = 0;
+   for(int i = 0; i < trials; i++)
+   {
+      std::unique_ptr<LCA> lca = factory.Create(initial_density);
+      lca->RecordConvergenceOnly();
+      lca->Run([](const ModelStats& s) {
+                  return (s.CurrentCADensity() == 0.0 || s.CurrentCADensity() == 1.0);
+               });
+      if(lca->GetStats().IsCorrect())
+      {
+         num_correct++;
+      }
+   }
+   return num_correct;
+}
+
+/**
+ * The z-score of the single precision proportion minus the double
+ * precision one.
+ */
+double z_score(int correct_double, int correct_single, int trials)
+{
+   double p_double = correct_double / (double)trials;
+   double p_single = correct_single / (double)trials;
+   double pooled   = (correct_double + correct_single) / (2.0*trials);
+   double standard_error = sqrt(pooled * (1 - pooled) * 2.0 / trials);
+   if(standard_error == 0.0)
+   {
+      return 0.0;
+   }
+   return (p_single - p_double) / standard_error;
+}
+
+int main(int argc, char** argv)
+{
+   LCAFactory double_factory;
+   LCAFactory single_factory;
+
+   int arg_index = double_factory.Init(argc, argv);
+   optind = 0; // rescan the same options for the second factory
+   single_factory.Init(argc, argv);
+   single_factory.SetSinglePrecision(true);
+   double_factory.SetSinglePrecision(false);
+
+   if(arg_index >= argc)
+   {
+      std::cerr << "usage: " << argv[0] << " [options] trials [density ...]" << std::endl;
+      return 1;
+   }
+   int trials = atoi(argv[arg_index++]);
+
+   std::vector<double> densities;
+   for(int i = arg_index; i < argc; i++)
+   {
+      densities.push_back(atof(argv[i]));
+   }
+   if(densities.empty())
+   {
+      for(int i = 1; i < 20; i++)
+      {
+         densities.push_back(i * 0.05);
+      }
+   }
+
+   for(double density : densities)
+   {
+      int correct_double = count_correct(double_factory, density, trials);
+      int correct_single = count_correct(single_factory, density, trials);
+      std::cout << density << " "
+                << correct_double / (double)trials << " "
+                << correct_single / (double)trials << " "
+                << (correct_single - correct_double) / (double)trials << " "
+                << z_score(correct_double, correct_single, trials) << std::endl;
+   }
+}
@@ -1,10 +1,11 @@
-#include "OneDLattice.hpp"
+#include "ReplicaLattice.hpp"
 
 #include <iostream>
 #include <future>
 #include <map>
 #include <utility>
 #include <functional> // std::bind
+#include <algorithm>
 
 #define NUM_REPLICAS 100
 
@@ -12,47 +13,53 @@ int num_agents;
 double density_step;
 int seed;
 
-MajorityRule majority_rule;
-
-bool evaluate_ca(OneDLattice& lattice)
+/**
+ * Evaluate up to 64 replicas at once, returning the number classified
+ * correctly.
+ */
+int evaluate_ca(ReplicaLattice& lattice, int replicas)
 {
-   double initial_density = lattice.GetDensity();
+   std::vector<double> initial_densities = lattice.GetDensities();
    for(int i = 0; i < 5000; i++)
    {
       lattice.Shuffle();
-      lattice.Step(majority_rule);
+      lattice.Step();
       if(!lattice.IsChanging())
       {
-         break; // stop evaluate if the ca state stops changing.
+         break; // stop evaluating once no replica is changing.
       }
    }
-   
-   if(initial_density < 0.5)
-   {
-      return lattice.GetDensity() == 0.0;
-   }
-   else
+
+   std::vector<double> final_densities = lattice.GetDensities();
+   int correct = 0;
+   for(int j = 0; j < replicas; j++)
    {
-      return lattice.GetDensity() == 1.0;
+      if(initial_densities[j] < 0.5)
+      {
+         correct += final_densities[j] == 0.0;
+      }
+      else
+      {
+         correct += final_densities[j] == 1.0;
+      }
    }
+   return correct;
 }
 
 std::map<double,double> evaluate_radius(int radius)
 {
-   OneDLattice lattice(num_agents, radius);
+   ReplicaLattice lattice(num_agents, radius);
    lattice.Seed(seed);
 
    std::map<double, double> results;
    for(double density = 0.0; density <= 1.001; density += density_step)
    {
       int correct = 0;
-      for(int i = 0; i < NUM_REPLICAS; i++)
+      for(int i = 0; i < NUM_REPLICAS; i += ReplicaLattice::WIDTH)
       {
-         lattice.SetDensity(density);
-         if(evaluate_ca(lattice))
-         {
-            correct++;
-         }
+         int replicas = std::min(NUM_REPLICAS - i, ReplicaLattice::WIDTH);
+         lattice.SetDensity(density, replicas);
+         correct += evaluate_ca(lattice, replicas);
       }
       results.emplace(std::make_pair(density, (double)correct / (double)NUM_REPLICAS));
    }
@@ -5,14 +5,14 @@
 #include <cmath>
 #include <utility>
 #include <map>
+#include <numeric> // accumulate
 #include <fstream>
-#include <thread>
-#include <mutex>
 
 #include <getopt.h>
 
 #include "Model.hpp"
 #include "Rule.hpp"
+#include "Sweep.hpp"
 
 struct model_config
 {
@@ -25,31 +25,6 @@ struct model_config
    Rule*  rule;
 } model_config;
 
-std::mutex density_lock;
-double init_density = 0.0;
-
-std::mutex results_lock;
-std::map<double, double> results;
-
-double next_density()
-{
-   double d;
-   
-   density_lock.lock();
-   d = init_density;
-   init_density += 0.01;
-   density_lock.unlock();
-
-   return d;
-}
-
-void store_result(double initial_density, double proportion_correct)
-{
-   results_lock.lock();
-   results.emplace(initial_density, proportion_correct);
-   results_lock.unlock();
-}
-
 std::shared_ptr<Model> make_spatial(int seed)
 {
    return std::make_shared<Model>(model_config.arena_size, model_config.num_agents,
@@ -74,7 +49,7 @@ std::vector<int> eval_network(const Rule& rule,
          neighbor_states.push_back(states[n]);
          neighbor_positions.push_back(agents[n].Position());
       }
-      new_states[a] = rule.Apply(states[a], neighbor_states);
+      new_states[a] = rule.Apply(states[a], neighbor_states).first;
    }
    return new_states;
 }
@@ -115,31 +90,9 @@ bool evaluate_ca(int seed, double initial_density)
    return density(agent_states) == round(actual_density);
 }
 
-void run_sweep()
-{
-   double d;
-   while((d = next_density()) < 1.001)
-   {
-      int correct = 0;
-      for(int replica = 0; replica < model_config.num_iterations; replica++)
-      {
-         if(evaluate_ca(model_config.seed+replica, d))
-         {
-            correct++;
-         }
-      }
-      store_result(d, (double)correct / (double)model_config.num_iterations);
-   }
-}
-
 int main(int argc, char** argv)
 {
    int    opt_char;
-   int    sweep_density   = 0;
-   double density_step    = 0.01;
-   double initial_density = 0.0;
-   int    num_iterations  = 100;
-   int    save_state      = 0;
 
    model_config.communication_range = 5;
    model_config.num_agents          = 100;
@@ -167,8 +120,7 @@ int main(int argc, char** argv)
       switch(opt_char)
       {
       case 'd':
-         initial_density = atof(optarg);
-         break;
+         break; // the sweep sets the initial densities
 
       case 'r':
          model_config.communication_range = atof(optarg);
@@ -201,22 +153,17 @@ int main(int argc, char** argv)
       }
    }
 
-   int num_threads = std::thread::hardware_concurrency();
-   std::vector<std::thread> threads;
-   for(int i = 0; i < num_threads; i++)
-   {
-      threads.push_back(std::thread(run_sweep));
-   }
+   // initial densities 0, 0.01, ..., 1
+   Sweep sweep(101, model_config.num_iterations);
+   std::vector<double> proportions = sweep.Proportion([](int point, int replica)
+                                                      {
+                                                         return evaluate_ca(model_config.seed+replica, point * 0.01);
+                                                      });
 
-   for(auto& thread : threads)
+   for(int point = 0; point < (int) proportions.size(); point++)
    {
-      thread.join();
+      std::cout << point * 0.01 << " " << proportions[point] << std::endl;
    }
 
-   for(auto result : results)
-   {
-      std::cout << result.first << " " << result.second << std::endl;
-   }
-   
    return 0;
 }
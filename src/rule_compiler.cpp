@@ -0,0 +1,311 @@
+#include "Transition.hpp"
+
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/**
+ * Generate C++ kernels for totalistic rule files.
+ *
+ * usage: rule_compiler output.cpp file.rule [file.rule ...]
+ *
+ * Each rule file that parses becomes a Rule subclass whose transitions
+ * are a chain of comparisons against constant thresholds, evaluated in
+ * the same order and with the same arithmetic as TotalisticRule. The
+ * output also defines CompiledRules() (see CompiledRules.hpp), which
+ * maps the file name (without .rule) and text to the kernel. Files
+ * that do not parse are skipped with a warning so that --rule falls
+ * back to the interpreter for them.
+ */
+
+struct RuleFile
+{
+   std::string             name;
+   std::string             source;
+   std::vector<Transition> transitions;
+};
+
+std::string rule_name(const std::string& path)
+{
+   std::string name = path.substr(path.find_last_of("/\\") + 1);
+   return name.substr(0, name.rfind(".rule"));
+}
+
+std::string class_name(const std::string& name)
+{
+   std::string identifier = "CompiledRule_";
+   for(char c : name)
+   {
+      identifier += std::isalnum((unsigned char)c) ? c : '_';
+   }
+   return identifier;
+}
+
+std::string string_literal(const std::string& str)
+{
+   std::ostringstream out;
+   out << '"';
+   for(char c : str)
+   {
+      switch(c)
+      {
+      case '\n': out << "\\n\"\n      \""; break;
+      case '\t': out << "\\t"; break;
+      case '"':  out << "\\\""; break;
+      case '\\': out << "\\\\"; break;
+      default:
+         if(std::isprint((unsigned char)c))
+         {
+            out << c;
+         }
+         else
+         {
+            out << "\\" << std::oct << std::setw(3) << std::setfill('0')
+                << (int)(unsigned char)c << std::dec;
+         }
+      }
+   }
+   out << '"';
+   return out.str();
+}
+
+/**
+ * A double literal that reads back as exactly the same value.
+ */
+std::string double_literal(double d)
+{
+   std::ostringstream out;
+   out << std::setprecision(std::numeric_limits<double>::max_digits10) << d;
+   std::string literal = out.str();
+   if(literal.find_first_of(".e") == std::string::npos)
+   {
+      literal += ".0";
+   }
+   return literal;
+}
+
+/**
+ * Parse a rule file the same way operator>>(istream&, TotalisticRule&)
+ * does.
+ */
+bool parse_rule(const std::string& path, RuleFile& rule)
+{
+   std::ifstream file(path);
+   if(!file)
+   {
+      std::cerr << path << ": cannot open" << std::endl;
+      return false;
+   }
+   rule.name = rule_name(path);
+   rule.source.assign(std::istreambuf_iterator<char>(file),
+                      std::istreambuf_iterator<char>());
+
+   std::istringstream stream(rule.source);
+   std::string line;
+   int line_number = 0;
+   while(std::getline(stream, line))
+   {
+      line_number++;
+      if(line.size() == 0 || line.front() == '#') continue;
+
+      try
+      {
+         rule.transitions.push_back(parser::parse_transition(line));
+      }
+      catch(const parser::ParseException& e)
+      {
+         std::cerr << path << ":" << line_number << ": " << e.message
+                   << "; not compiled" << std::endl;
+         return false;
+      }
+      catch(const std::exception& e)
+      {
+         std::cerr << path << ":" << line_number << ": cannot parse \""
+                   << line << "\"; not compiled" << std::endl;
+         return false;
+      }
+   }
+   return true;
+}
+
+/**
+ * The density a transition tests, given expressions for the number of
+ * neighbors, their sum, and the number in a given state.
+ */
+std::string density(const Transition& t, const std::string& total, const std::string& sum,
+                    const std::string& in_state)
+{
+   std::string numerator = t.density_state < 0 ? sum : in_state;
+   std::string denominator = total;
+   if(t.include_self)
+   {
+      numerator += t.density_state < 0
+         ? " + self"
+         : " + (self == " + std::to_string(t.density_state) + ")";
+      denominator += " + 1";
+   }
+   return "(double)(" + numerator + ") / (double)(" + denominator + ")";
+}
+
+/**
+ * The body of an Apply method evaluating the transitions in order.
+ */
+void write_transitions(std::ostream& out, const RuleFile& rule, const std::string& total,
+                       const std::string& sum,
+                       std::string (*in_state)(int state))
+{
+   for(const Transition& t : rule.transitions)
+   {
+      std::string d = density(t, total, sum, in_state(t.density_state));
+      out << "      if(";
+      if(!t.any_state)
+      {
+         out << "self == " << t.pre_state << " && ";
+      }
+      out << d << (t.range.IncludesMin() ? " >= " : " > ") << double_literal(t.range.Min())
+          << " &&\n         "
+          << d << (t.range.IncludesMax() ? " <= " : " < ") << double_literal(t.range.Max())
+          << ")\n"
+          << "         return std::make_pair("
+          << (t.result_self ? std::string("self") : std::to_string(t.result_state))
+          << ", " << double_literal(t.heading_change) << ");\n";
+   }
+   out << "      return std::make_pair(self, 0.0);\n";
+}
+
+// Neighbors in a state for Apply(self, ones, total), whose neighbors
+// are all 0 or 1.
+std::string binary_in_state(int state)
+{
+   return state == 0 ? "total - ones" : state == 1 ? "ones" : "0";
+}
+
+// Neighbors in a state for Apply(self, counts, num_states).
+std::string histogram_in_state(int state)
+{
+   std::string s = std::to_string(state);
+   return "(" + s + " < num_states ? counts[" + s + "] : 0)";
+}
+
+void write_rule(std::ostream& out, const RuleFile& rule)
+{
+   std::string name = class_name(rule.name);
+   out << "/** Generated from " << rule.name << ".rule */\n"
+       << "class " << name << " : public Rule\n"
+       << "{\n"
+       << "public:\n"
+       << "   using Rule::Apply;\n"
+       << "   std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override\n"
+       << "   {\n"
+       << "      int counts[MAX_STATES] = {0};\n"
+       << "      int num_states = 0;\n"
+       << "      for(int n : neighbors)\n"
+       << "      {\n"
+       << "         if(n < 0 || n >= MAX_STATES)\n"
+       << "            throw std::out_of_range(\"neighbor state out of range\");\n"
+       << "         counts[n]++;\n"
+       << "         num_states = std::max(num_states, n + 1);\n"
+       << "      }\n"
+       << "      return Apply(self, counts, num_states);\n"
+       << "   }\n"
+       << "\n"
+       << "   std::pair<int, double> Apply(int self, int ones, int total) const override\n"
+       << "   {\n";
+   write_transitions(out, rule, "total", "ones", binary_in_state);
+   out << "   }\n"
+       << "\n"
+       << "   std::pair<int, double> Apply(int self, const int* counts, int num_states) const override\n"
+       << "   {\n"
+       << "      int sum   = 0;\n"
+       << "      int total = 0;\n"
+       << "      for(int s = 0; s < num_states; s++)\n"
+       << "      {\n"
+       << "         sum   += s * counts[s];\n"
+       << "         total += counts[s];\n"
+       << "      }\n";
+   write_transitions(out, rule, "total", "sum", histogram_in_state);
+   out << "   }\n"
+       << "\n"
+       << "   bool CountsSufficient() const override\n"
+       << "   {\n"
+       << "      return true;\n"
+       << "   }\n"
+       << "\n"
+       << "   bool HistogramSufficient() const override\n"
+       << "   {\n"
+       << "      return true;\n"
+       << "   }\n"
+       << "};\n"
+       << "\n"
+       << "std::shared_ptr<Rule> make_" << name << "()\n"
+       << "{\n"
+       << "   return std::make_shared<" << name << ">();\n"
+       << "}\n"
+       << "\n";
+}
+
+int main(int argc, char** argv)
+{
+   if(argc < 2)
+   {
+      std::cerr << "usage: " << argv[0] << " output.cpp [file.rule ...]" << std::endl;
+      return 1;
+   }
+
+   std::vector<RuleFile> rules;
+   for(int i = 2; i < argc; i++)
+   {
+      RuleFile rule;
+      if(parse_rule(argv[i], rule))
+      {
+         rules.push_back(rule);
+      }
+   }
+
+   std::ostringstream out;
+   out << "// Generated by rule_compiler. Do not edit.\n"
+       << "#include \"CompiledRules.hpp\"\n"
+       << "#include \"AgentState.hpp\"\n"
+       << "\n"
+       << "#include <algorithm>\n"
+       << "#include <stdexcept>\n"
+       << "#include <utility>\n"
+       << "\n"
+       << "namespace\n"
+       << "{\n"
+       << "\n";
+   for(const RuleFile& rule : rules)
+   {
+      write_rule(out, rule);
+   }
+   out << "}\n"
+       << "\n"
+       << "const std::vector<CompiledRule>& CompiledRules()\n"
+       << "{\n"
+       << "   static const std::vector<CompiledRule> rules =\n"
+       << "      {\n";
+   for(const RuleFile& rule : rules)
+   {
+      out << "         {" << string_literal(rule.name) << ",\n"
+          << "          " << string_literal(rule.source) << ",\n"
+          << "          make_" << class_name(rule.name) << "},\n";
+   }
+   out << "      };\n"
+       << "   return rules;\n"
+       << "}\n";
+
+   std::ofstream output(argv[1]);
+   output << out.str();
+   if(!output)
+   {
+      std::cerr << argv[1] << ": cannot write" << std::endl;
+      return 1;
+   }
+   return 0;
+}
@@ -65,7 +65,7 @@ int main(int argc, char** argv)
    }
 
    std::unique_ptr<LCA> lca = factory.Create(initial_density);
-   lca->MinimizeMemory();
+   lca->RecordConvergenceOnly();
 
    sf::RenderWindow window(sf::VideoMode(600,600), "Liquid-CA");
 
@@ -127,7 +127,7 @@ int main(int argc, char** argv)
 
       window.clear(sf::Color::White);
       const std::vector<Agent>& agents = lca->GetAgents();
-      const std::vector<int>& states  = lca->GetStates();
+      const std::vector<AgentState>& states = lca->GetStates();
       auto network = lca->CurrentNetwork();
       for(int i = 0; i < agents.size(); i++)
       {
@@ -0,0 +1,71 @@
+#include "Model.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+/**
+ * Time the fused and phase-separated time steps.
+ *
+ * usage: step_benchmark [steps [num_agents ...]]
+ *
+ * For each number of agents (10^4, 10^5 and 10^6 by default) a model
+ * with the default density of agents (255 per 100x100) and
+ * communication range 5 is run for the given number of steps (10 by
+ * default) with the majority rule, first with separate phases and then
+ * fused. Each output line holds the number of agents, the seconds per
+ * step of each, and the speedup. The phase-separated step tests every
+ * pair of agents, so it is skipped above MAX_ALL_PAIRS agents.
+ */
+
+const int MAX_ALL_PAIRS = 100000;
+
+double seconds_per_step(int num_agents, int steps, bool fused)
+{
+   double arena_size = 100 * std::sqrt(num_agents / 255.0);
+   Model model(arena_size, num_agents, 5.0, 1234, 0.5);
+   model.SetFusedStep(fused);
+   model.RecordNetworkDensityOnly();
+   model.ReserveSteps(steps);
+   MajorityRule majority;
+
+   auto start = std::chrono::steady_clock::now();
+   for(int i = 0; i < steps; i++)
+   {
+      model.Step(&majority);
+   }
+   std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+   return elapsed.count() / steps;
+}
+
+int main(int argc, char** argv)
+{
+   int steps = argc > 1 ? atoi(argv[1]) : 10;
+   std::vector<int> sizes;
+   for(int i = 2; i < argc; i++)
+   {
+      sizes.push_back(atoi(argv[i]));
+   }
+   if(sizes.empty())
+   {
+      sizes = {10000, 100000, 1000000};
+   }
+
+   std::cout << "# agents phases fused speedup" << std::endl;
+   for(int num_agents : sizes)
+   {
+      double fused = seconds_per_step(num_agents, steps, true);
+      std::cout << num_agents << " ";
+      if(num_agents <= MAX_ALL_PAIRS)
+      {
+         double phases = seconds_per_step(num_agents, steps, false);
+         std::cout << phases << " " << fused << " " << phases / fused << std::endl;
+      }
+      else
+      {
+         std::cout << "- " << fused << " -" << std::endl;
+      }
+   }
+}
@@ -1,18 +1,11 @@
-#include <random>
 #include <iostream>
 #include <cstdlib>
-#include <functional>
-#include <cmath>
-#include <future>
-#include <thread> // hardware_concurrency()
-#include <chrono>
-#include <utility>
-#include <map>
-#include <fstream>
+#include <vector>
 
 #include <getopt.h>
 
 #include "Model.hpp"
+#include "Sweep.hpp"
 
 struct model_config
 {
@@ -22,7 +15,7 @@ struct model_config
    int    seed;
    double mu;
    double speed;
-   double num_iterations;
+   int    num_iterations;
 } model_config;
 
 // XXX: quick and dirty implementation of Contrarian
@@ -30,95 +23,47 @@ class ContrarianRule : public Rule {
 private:
    MajorityRule majority;
 public:
+   using Rule::Apply;
    ContrarianRule() {}
    ~ContrarianRule() {}
-   int Apply(int self, const std::vector<int>& neighbors) const override
+   std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override
       {
-         return 1 - majority.Apply(self, neighbors);
+         std::pair<int, double> result = majority.Apply(self, neighbors);
+         return std::make_pair(1 - result.first, result.second);
       }
 } contrarian_rule;
 
-std::mutex density_lock;
-double density = 0.0;
-
-std::mutex results_lock;
-std::map<double, double> results;
-
-double next_density()
-{
-   double d;
-
-   density_lock.lock();
-
-   d = density;
-   density += 0.01;
-
-   density_lock.unlock();
-
-   return d;
-}
-
-void record_result(double initial_density, double proportion_correct)
-{
-   results_lock.lock();
-   results.emplace(initial_density, proportion_correct);
-   results_lock.unlock();
-}
-
-double evaluate_ca(int num_iterations, double speed, double initial_density)
+/**
+ * Run replica iteration at the given speed and initial density.
+ * @return true if the agents synchronized.
+ */
+bool evaluate_ca(int iteration, double speed, double initial_density)
 {
-   std::uniform_real_distribution<double> heading_distribution(0, 2*M_PI);
-   int num_correct = 0;
-   for(int iteration = 0; iteration < num_iterations; iteration++)
+   Model m(model_config.arena_size,
+           model_config.num_agents,
+           model_config.communication_range,
+           model_config.seed+iteration,
+           initial_density,
+           speed);
+
+   // m.SetMovementRule(LevyWalk(model_config.mu, model_config.arena_size/speed));
+   m.SetMovementRule(std::make_shared<RandomWalk>());
+   m.RecordConvergenceOnly();
+   for(int step = 0; step < 5000; step++)
    {
-      Model m(model_config.arena_size,
-              model_config.num_agents,
-              model_config.communication_range,
-              model_config.seed+iteration,
-              initial_density,
-              speed);
-
-      // m.SetMovementRule(LevyWalk(model_config.mu, model_config.arena_size/speed));
-      m.SetMovementRule(std::make_shared<RandomWalk>());
-      m.RecordNetworkDensityOnly();
-      for(int step = 0; step < 5000; step++)
-      {
-         m.Step(&contrarian_rule);
-         if(m.GetStats().IsSynchronized())
-         {
-            break; // done. no need to keep evaluating.
-         }
-      }
-
+      m.Step(&contrarian_rule);
       if(m.GetStats().IsSynchronized())
       {
-         num_correct++;
+         break; // done. no need to keep evaluating.
       }
    }
 
-   return (double) num_correct / num_iterations;
-}
-
-
-void thread_main()
-{
-   double initial_density;
-   while((initial_density = next_density()) < 1.001)
-   {
-      double proportion_correct = evaluate_ca(model_config.num_iterations,
-                                              model_config.speed,
-                                              initial_density);
-      record_result(initial_density, proportion_correct);
-   }
+   return m.GetStats().IsSynchronized();
 }
 
 int main(int argc, char** argv)
 {
    int    opt_char;
-   int    sweep_density   = 0;
-   double density_step    = 0.01;
-   double initial_density = 0.0;
-   int    save_state      = 0;
 
    model_config.communication_range = 5;
    model_config.num_agents          = 100;
@@ -145,8 +90,7 @@ int main(int argc, char** argv)
       switch(opt_char)
       {
       case 'd':
-         initial_density = atof(optarg);
-         break;
+         break; // the sweep sets the initial densities
 
       case 'r':
          model_config.communication_range = atof(optarg);
@@ -190,25 +134,16 @@ int main(int argc, char** argv)
 
    model_config.speed = atof(argv[optind]);
 
-   int max_threads = std::thread::hardware_concurrency();
-   std::vector<std::thread> threads;
-
-   for(int i = 0; i < max_threads; i++)
-   {
-      threads.push_back(std::thread(thread_main));
-   }
-
-   for(auto& thread : threads)
-   {
-      thread.join();
-   }
+   // initial densities 0, 0.01, ..., 1
+   Sweep sweep(101, model_config.num_iterations);
+   std::vector<double> proportions = sweep.Proportion([](int point, int replica)
+                                                      {
+                                                         return evaluate_ca(replica, model_config.speed, point * 0.01);
+                                                      });
 
    // print the results
-   for(auto result : results)
+   for(int point = 0; point < (int) proportions.size(); point++)
    {
-      std::cout << result.first << " " << result.second << std::endl;
+      std::cout << point * 0.01 << " " << proportions[point] << std::endl;
    }
 }
-
-
-
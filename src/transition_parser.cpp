@@ -23,7 +23,7 @@ namespace parser {
    void result(std::string& rule, Transition& t)
    {
       std::string result = trim_leading_space(rule.substr(rule.find("->") + 2, rule.length()));
-      std::string result_state = result.substr(0,result_state.find_first_of(" ,\t")-1);
+      std::string result_state = result.substr(0, result.find_first_of(" ,\t"));
 
       if(result_state == "@")
       {
@@ -98,6 +98,30 @@ namespace parser {
       }
    }
 
+   void pre_density_state(std::string& pre, Transition& t)
+   {
+      int range_start = pre.find_first_of("[(");
+      int colon       = pre.find(':');
+      if(colon == std::string::npos || range_start == std::string::npos || colon > range_start)
+      {
+         return; // density of the mean state
+      }
+
+      int marker = pre.find_first_of("+-", pre.find_first_of(" "));
+      try
+      {
+         t.density_state = std::stoi(pre.substr(marker + 1, colon - marker - 1));
+      }
+      catch(std::invalid_argument e)
+      {
+         throw ParseException("invalid density state");
+      }
+      if(t.density_state < 0)
+      {
+         throw ParseException("invalid density state");
+      }
+   }
+
    Range pre_range(std::string& pre)
    {
       int range_start = pre.find_first_of("[(");
@@ -163,6 +187,7 @@ namespace parser {
    {
       return out << (t.any_state ? "@" : std::to_string(t.pre_state)) << " "
                  << (t.include_self ? "+" : "-") << " "
+                 << (t.density_state < 0 ? "" : std::to_string(t.density_state) + ":")
                  << t.range << " -> "
                  << (t.result_self ? "@" : std::to_string(t.result_state))
                  << ", " << t.heading_change
@@ -175,6 +200,7 @@ namespace parser {
       std::string precondition = pre_condition(str);
       pre_state(precondition, t);
       pre_inclusive(precondition, t);
+      pre_density_state(precondition, t);
       t.range = pre_range(precondition);
       result(str, t);
 
@@ -1,106 +1,96 @@
-#include <random>
 #include <iostream>
+#include <cstdint>
 #include <cstdlib>
-#include <functional>
-#include <cmath>
-#include <future>
-#include <thread> // hardware_concurrency()
-#include <chrono>
-#include <utility>
-#include <map>
-#include <fstream>
-
-#include <getopt.h>
+#include <vector>
 
 #include "Model.hpp"
 #include "LCAFactory.hpp"
+#include "Sweep.hpp"
 
 LCAFactory factory;
 
 int num_iterations;
 
-std::mutex density_lock;
-double density = 0.0;
-
-std::mutex results_lock;
-std::map<double, double> results;
+std::vector<double> sweep_densities;
 
-double next_density()
+/**
+ * Run one replica at initial_density to convergence, as the
+ * factory's task-th model so that the results don't depend on the
+ * order the tasks run in.
+ */
+bool evaluate_ca(double initial_density, uint64_t task)
 {
-   double d;
-
-   density_lock.lock();
-
-   d = density;
-   density += 0.01;
-
-   density_lock.unlock();
-
-   return d;
+   std::unique_ptr<LCA> lca = factory.Create(initial_density, task);
+   lca->RecordConvergenceOnly();
+   lca->Run([](const ModelStats& s) { return (s.CurrentCADensity() == 0.0 || s.CurrentCADensity() == 1.0); });
+   return lca->GetStats().IsCorrect();
 }
 
-void record_result(double initial_density, double proportion_correct)
+/**
+ * Score every initial density on one trajectory: 1 for each vector
+ * of the batch that converged correctly. Replica replica takes the
+ * factory's requests 2*replica and 2*replica + 1.
+ */
+std::vector<int> evaluate_batch(int replica)
 {
-   results_lock.lock();
-   results.emplace(initial_density, proportion_correct);
-   results_lock.unlock();
-}
+   std::unique_ptr<LCA> lca = factory.Create(0.5, 2*(uint64_t)replica);
+   lca->RecordConvergenceOnly();
+   StateBatch batch = factory.CreateBatch(sweep_densities, 2*(uint64_t)replica + 1);
+   lca->Run(batch);
 
-double evaluate_ca(int num_iterations, double initial_density)
-{
-   int num_correct = 0;
-   for(int iteration = 0; iteration < num_iterations; iteration++)
+   std::vector<int> correct(batch.NumVectors(), 0);
+   for(int j = 0; j < batch.NumVectors(); j++)
    {
-      std::unique_ptr<LCA> lca = factory.Create(initial_density);
-      lca->MinimizeMemory();
-      lca->Run([](const ModelStats& s) { return (s.CurrentCADensity() == 0.0 || s.CurrentCADensity() == 1.0); });
-
-      if(lca->GetStats().IsCorrect())
+      if(batch.IsCorrect(j))
       {
-         num_correct++;
+         correct[j] = 1;
       }
    }
-
-   return (double) num_correct / num_iterations;
-}
-
-void thread_main()
-{
-   double initial_density;
-   while((initial_density = next_density()) < 1.001)
-   {
-      double proportion_correct = evaluate_ca(num_iterations, initial_density);
-      record_result(initial_density, proportion_correct);
-   }
+   return correct;
 }
 
 int main(int argc, char** argv)
 {
-   int    opt_char;
-   int    sweep_density   = 0;
-   double density_step    = 0.01;
-   double initial_density = 0.0;
-   int    save_state      = 0;
-
    int arg_index = factory.Init(argc, argv);
    num_iterations = atoi(argv[arg_index]);
 
-   int max_threads = std::thread::hardware_concurrency();
-   std::vector<std::thread> threads;
-
-   for(int i = 0; i < max_threads; i++)
+   for(int i = 0; i <= 100; i++)
    {
-      threads.push_back(std::thread(thread_main));
+      sweep_densities.push_back(i * 0.01);
    }
 
-   for(auto& thread : threads)
+   std::vector<double> proportions;
+   if(factory.SharedTrajectory())
+   {
+      // one point, each replica a whole batch
+      Sweep sweep(1, num_iterations);
+      std::vector<int> correct =
+         sweep.Run<std::vector<int>>([](int, int replica) { return evaluate_batch(replica); },
+                                     [](const std::vector<int>& a, const std::vector<int>& b)
+                                     {
+                                        std::vector<int> sum(b);
+                                        for(size_t j = 0; j < a.size(); j++) sum[j] += a[j];
+                                        return sum;
+                                     },
+                                     std::vector<int>(sweep_densities.size(), 0))[0];
+      for(int c : correct)
+      {
+         proportions.push_back((double)c / num_iterations);
+      }
+   }
+   else
    {
-      thread.join();
+      Sweep sweep(sweep_densities.size(), num_iterations);
+      proportions = sweep.Proportion([&](int point, int replica)
+                                     {
+                                        uint64_t task = (uint64_t)point * num_iterations + replica;
+                                        return evaluate_ca(sweep_densities[point], task);
+                                     });
    }
 
    // print the results
-   for(auto result : results)
+   for(size_t j = 0; j < sweep_densities.size(); j++)
    {
-      std::cout << result.first << " " << result.second << std::endl;
+      std::cout << sweep_densities[j] << " " << proportions[j] << std::endl;
    }
 }
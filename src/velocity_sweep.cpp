@@ -1,18 +1,12 @@
-#include <random>
 #include <iostream>
 #include <cstdlib>
-#include <functional>
 #include <cmath>
-#include <future>
-#include <thread> // hardware_concurrency()
-#include <chrono>
-#include <utility>
-#include <map>
-#include <fstream>
+#include <vector>
 
 #include <getopt.h>
 
 #include "Model.hpp"
+#include "Sweep.hpp"
 
 struct model_config
 {
@@ -21,97 +15,47 @@ struct model_config
    int    arena_size;
    int    seed;
    double mu;
-   double num_iterations;
+   int    num_iterations;
    double noise;
    Rule  *rule;
    std::shared_ptr<MovementRule> movement_rule;
 } model_config;
 
-std::mutex speed_lock;
-double speed = 0;
 double max_speed = 300.0;
 double max_time  = 1000.0;
 
-std::mutex results_lock;
-std::map<double, double> results;
-
-bool synchronization = false;
-
-double next_speed()
+/**
+ * Run replica iteration at the given speed and initial density.
+ */
+bool evaluate_ca(int iteration, double speed, double initial_density)
 {
-   double s;
-
-   speed_lock.lock();
-
-   s = speed;
-   speed += 1.0;
-
-   speed_lock.unlock();
-
-   return s;
-}
-
-void record_result(double initial_density, double proportion_correct)
-{
-   results_lock.lock();
-   results.emplace(initial_density, proportion_correct);
-   results_lock.unlock();
-}
-
-double evaluate_ca(int num_iterations, double speed, double initial_density)
-{
-   int num_correct = 0;
-   for(int iteration = 0; iteration < num_iterations; iteration++)
+   Model m(model_config.arena_size,
+           model_config.num_agents,
+           model_config.communication_range,
+           model_config.seed+iteration,
+           initial_density,
+           speed);
+
+   // m.SetMovementRule(LevyWalk(model_config.mu, model_config.arena_size/speed));
+   m.SetMovementRule(model_config.movement_rule);
+   m.RecordNetworkDensityOnly();
+   m.SetNoise(model_config.noise);
+
+   for(int step = 0; step < max_time; step++)
    {
-      Model m(model_config.arena_size,
-              model_config.num_agents,
-              model_config.communication_range,
-              model_config.seed+iteration,
-              initial_density,
-              speed);
-
-      // m.SetMovementRule(LevyWalk(model_config.mu, model_config.arena_size/speed));
-      m.SetMovementRule(model_config.movement_rule);
-      m.RecordNetworkDensityOnly();
-      m.SetNoise(model_config.noise);
-
-      for(int step = 0; step < max_time; step++)
+      m.Step(model_config.rule);
+      if(m.CurrentDensity() == 0 || m.CurrentDensity() == 1)
       {
-         m.Step(model_config.rule);
-         if(m.CurrentDensity() == 0 || m.CurrentDensity() == 1)
-         {
-            break; // done. no need to keep evaluating.
-         }
-      }
-
-      if(m.GetStats().IsCorrect())
-      {
-         num_correct++;
+         break; // done. no need to keep evaluating.
       }
    }
 
-   return (double) num_correct / num_iterations;
-}
-
-void thread_main()
-{
-   double speed;
-   while((speed = next_speed()) <= max_speed)
-   {
-      double proportion_correct = evaluate_ca(model_config.num_iterations,
-                                              speed,
-                                              0.5);
-      record_result(speed, proportion_correct);
-   }
+   return m.GetStats().IsCorrect();
 }
 
 int main(int argc, char** argv)
 {
    int    opt_char;
-   int    sweep_density   = 0;
-   double density_step    = 0.01;
-   double initial_density = 0.0;
-   int    save_state      = 0;
 
    model_config.communication_range = 5;
    model_config.num_agents          = 100;
@@ -148,8 +92,7 @@ int main(int argc, char** argv)
       switch(opt_char)
       {
       case 'd':
-         initial_density = atof(optarg);
-         break;
+         break; // every speed is run at density 0.5
 
       case 'r':
          model_config.communication_range = atof(optarg);
@@ -215,22 +158,16 @@ int main(int argc, char** argv)
       }
    }
 
-   int max_threads = std::thread::hardware_concurrency();
-   std::vector<std::thread> threads;
-
-   for(int i = 0; i < max_threads; i++)
-   {
-      threads.push_back(std::thread(thread_main));
-   }
-
-   for(auto& thread : threads)
-   {
-      thread.join();
-   }
+   // a point for every whole speed up to max_speed
+   Sweep sweep((int)floor(max_speed) + 1, model_config.num_iterations);
+   std::vector<double> proportions = sweep.Proportion([](int speed, int replica)
+                                                      {
+                                                         return evaluate_ca(replica, speed, 0.5);
+                                                      });
 
    // print the results
-   for(auto result : results)
+   for(int speed = 0; speed < (int) proportions.size(); speed++)
    {
-      std::cout << result.first << " " << result.second << std::endl;
+      std::cout << speed << " " << proportions[speed] << std::endl;
    }
 }
@@ -188,4 +188,48 @@ TEST_F(AgentTest, zeroVelocityNoMovement)
    agent.Step();
    agent.Step();
    EXPECT_EQ(a.Position(), Point(0,0));
-}
\ No newline at end of file
+}
+
+TEST_F(AgentTest, setHeadingChangesDirection)
+{
+   agent.SetHeading(Heading(M_PI_2));
+   agent.Step();
+   EXPECT_TRUE(agent.Position().Within(0.0000001, Point(0,1))) << agent.Position();
+   agent.SetHeading(Heading(M_PI));
+   agent.Step();
+   EXPECT_TRUE(agent.Position().Within(0.0000001, Point(-1,1))) << agent.Position();
+}
+
+TEST_F(AgentTest, bounceReversesDirection)
+{
+   Agent a(Point(4.5,0), Heading(0), 1, 10, 16);
+   a.Step();
+   EXPECT_TRUE(a.Position().Within(0.0000001, Point(4.5, 0))) << a.Position();
+   a.Step();
+   EXPECT_TRUE(a.Position().Within(0.0000001, Point(3.5, 0))) << a.Position();
+   a.Step();
+   EXPECT_TRUE(a.Position().Within(0.0000001, Point(2.5, 0))) << a.Position();
+}
+
+TEST_F(AgentTest, copiesDrawAlike)
+{
+   Agent a(Point(0,0), Heading(0), 1, 10, 17);
+   a.SetMovementRule(std::make_shared<RandomWalk>());
+   a.Step();
+   Agent copy = a;
+   for(int i = 0; i < 10; i++)
+   {
+      a.Step();
+      copy.Step();
+      EXPECT_EQ(a.Position(), copy.Position());
+      EXPECT_EQ(a.GetHeading(), copy.GetHeading());
+   }
+
+   // a reseeded agent draws like a new one with that seed
+   Agent fresh(copy.Position(), copy.GetHeading(), 1, 10, 18);
+   fresh.SetMovementRule(std::make_shared<RandomWalk>());
+   copy.Reseed(18);
+   copy.Step();
+   fresh.Step();
+   EXPECT_EQ(fresh.GetHeading(), copy.GetHeading());
+}
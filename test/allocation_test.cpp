@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+
+#include "History.hpp"
+#include "Model.hpp"
+#include "Rule.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <vector>
+
+/**
+ * Test hook: the global operator new is replaced for the test binary
+ * so that allocations can be counted while a piece of code runs.
+ */
+namespace
+{
+   std::atomic<bool> counting(false);
+   std::atomic<long> allocations(0);
+
+   long count_allocations(std::function<void()> f)
+   {
+      allocations = 0;
+      counting = true;
+      f();
+      counting = false;
+      return allocations;
+   }
+}
+
+// Once GCC inlines these replacements it sees free() release memory
+// from operator new and warns, not knowing that our operator new got it
+// from malloc(). The pairing is consistent: the library's array and
+// nothrow forms forward to these three.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size)
+{
+   if(counting)
+   {
+      allocations++;
+   }
+   void* p = std::malloc(size == 0 ? 1 : size);
+   if(p == nullptr)
+   {
+      throw std::bad_alloc();
+   }
+   return p;
+}
+
+void operator delete(void* p) noexcept
+{
+   std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+   std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+/**
+ * Majority rule that only implements the vector-based Apply().
+ */
+class VectorMajorityRule : public Rule
+{
+   MajorityRule majority;
+public:
+   using Rule::Apply;
+   std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override
+      {
+         return majority.Apply(self, neighbors);
+      }
+};
+
+void expect_no_steady_state_allocations(const Rule& rule, bool fused = true)
+{
+   // a small, dense arena so the aggregate network fills in quickly
+   Model m(20, 30, 8.0, 1234, 0.5);
+   m.SetFusedStep(fused);
+   m.RecordNetworkDensityOnly();
+   m.SetNoise(0.05);
+   m.SetPDark(0.1);
+   m.SetPInteractive(0.2);
+   for(int i = 0; i < 500; i++)
+   {
+      m.Step(&rule);
+   }
+
+   m.ReserveSteps(100);
+   EXPECT_EQ(0, count_allocations([&]()
+                                  {
+                                     for(int i = 0; i < 100; i++)
+                                     {
+                                        m.Step(&rule);
+                                     }
+                                  }));
+}
+
+TEST(AllocationTest, hookCounts)
+{
+   EXPECT_GT(count_allocations([]() { std::vector<int> v(10); }), 0);
+}
+
+TEST(AllocationTest, countRuleStep)
+{
+   MajorityRule majority;
+   expect_no_steady_state_allocations(majority);
+}
+
+TEST(AllocationTest, vectorRuleStep)
+{
+   VectorMajorityRule majority;
+   expect_no_steady_state_allocations(majority);
+}
+
+TEST(AllocationTest, phaseSeparatedStep)
+{
+   MajorityRule majority;
+   VectorMajorityRule vector_majority;
+   expect_no_steady_state_allocations(majority, false);
+   expect_no_steady_state_allocations(vector_majority, false);
+}
+
+TEST(AllocationTest, convergenceOnlyNeedsNoReserve)
+{
+   MajorityRule majority;
+   Model m(20, 30, 8.0, 1234, 0.5);
+   m.RecordConvergenceOnly();
+   for(int i = 0; i < 500; i++)
+   {
+      m.Step(&majority);
+   }
+   EXPECT_EQ(0, count_allocations([&]()
+                                  {
+                                     for(int i = 0; i < 1000; i++)
+                                     {
+                                        m.Step(&majority);
+                                     }
+                                  }));
+   EXPECT_EQ(1501, m.GetStats().ElapsedTime());
+}
+
+TEST(AllocationTest, reservedHistoryAppends)
+{
+   History<double> history;
+   for(int i = 0; i < 100; i++)
+   {
+      history.Append(i);
+   }
+   history.Reserve(3 * History<double>::CHUNK);
+   EXPECT_EQ(0, count_allocations([&]()
+                                  {
+                                     for(size_t i = 0; i < 3 * History<double>::CHUNK; i++)
+                                     {
+                                        history.Append(i);
+                                     }
+                                  }));
+}
+
+TEST(AllocationTest, retainedSnapshotsAllocate)
+{
+   MajorityRule majority;
+   Model m(20, 30, 8.0, 1234, 0.5);
+   m.Step(&majority);
+   EXPECT_GT(count_allocations([&]() { m.Step(&majority); }), 0);
+}
+
+TEST(AllocationTest, resetReusesStorage)
+{
+   MajorityRule majority;
+   auto run = [&](Model& m)
+      {
+         m.ReserveSteps(100);
+         for(int i = 0; i < 100; i++)
+         {
+            m.Step(&majority);
+         }
+      };
+   std::vector<std::function<void(Model&)>> modes = {
+      [](Model& m) { m.RecordNetworkDensityOnly(); },
+      [](Model& m) { m.RecordConvergenceOnly(); }
+   };
+   for(const std::function<void(Model&)>& record : modes)
+   {
+      Model m(20, 30, 8.0, 1234, 0.5);
+      m.SetNoise(0.05);
+      record(m);
+      run(m);
+
+      // A reset model keeps its recording mode, so nothing it records
+      // holds on to a network. The first run from the new seed may
+      // still grow the buffers; repeating it allocates nothing.
+      EXPECT_EQ(0, count_allocations([&]() { m.Reset(4321, 0.4); }));
+      run(m);
+      EXPECT_EQ(0, count_allocations([&]() { m.Reset(4321, 0.4); run(m); }));
+      EXPECT_EQ(101, m.GetStats().ElapsedTime());
+   }
+}
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include "Checkpoint.hpp"
+#include "LCA.hpp"
+#include "Model.hpp"
+#include "Rule.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+/**
+ * Majority rule that turns agents in state 0, so the trajectory
+ * depends on the states.
+ */
+class TurnWhenZero : public Rule
+{
+   MajorityRule majority;
+public:
+   using Rule::Apply;
+   std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override
+      {
+         return std::make_pair(majority.Apply(self, neighbors).first, self == 0 ? 0.5 : 0.0);
+      }
+};
+
+/**
+ * Check that a model restored from a checkpoint taken after before
+ * steps continues exactly as the original does, and as a model that
+ * was never checkpointed does.
+ */
+template<typename M>
+void expect_resumes(std::function<void(M&)> setup, const Rule* rule, int before, int after)
+{
+   M original(50, 200, 5.0, 2468, 0.5);
+   M unsaved(50, 200, 5.0, 2468, 0.5);
+   setup(original);
+   setup(unsaved);
+   for(int i = 0; i < before; i++)
+   {
+      original.Step(rule);
+      unsaved.Step(rule);
+   }
+
+   std::stringstream saved;
+   original.Checkpoint(saved);
+   std::unique_ptr<ModelInterface> restored_model = RestoreModel(saved);
+   M* restored = dynamic_cast<M*>(restored_model.get());
+   ASSERT_NE(restored, nullptr);
+   ASSERT_EQ(restored->GetStats().GetDensityHistory(), original.GetStats().GetDensityHistory());
+
+   for(int i = 0; i < after; i++)
+   {
+      original.Step(rule);
+      restored->Step(rule);
+      unsaved.Step(rule);
+      ASSERT_EQ(original.GetStates(), restored->GetStates()) << "step " << i;
+      ASSERT_EQ(original.CurrentDensity(), restored->CurrentDensity());
+      ASSERT_EQ(unsaved.GetStates(), original.GetStates()) << "step " << i;
+   }
+   for(int a = 0; a < original.GetAgents().size(); a++)
+   {
+      EXPECT_EQ(unsaved.GetAgents()[a].Position(), original.GetAgents()[a].Position());
+      EXPECT_EQ(original.GetAgents()[a].Position(), restored->GetAgents()[a].Position());
+      EXPECT_EQ(original.GetAgents()[a].GetHeading(), restored->GetAgents()[a].GetHeading());
+      EXPECT_EQ(original.GetAgents()[a].IsDark(), restored->GetAgents()[a].IsDark());
+   }
+
+   const ModelStats& stats = original.GetStats();
+   const ModelStats& restored_stats = restored->GetStats();
+   EXPECT_EQ(stats.ElapsedTime(), restored_stats.ElapsedTime());
+   EXPECT_EQ(stats.GetDensityHistory(), restored_stats.GetDensityHistory());
+   EXPECT_EQ(stats.AggregateDensityHistory(), restored_stats.AggregateDensityHistory());
+   ASSERT_EQ(stats.GetNetwork().Size(), restored_stats.GetNetwork().Size());
+   for(int t = 0; t < stats.GetNetwork().Size(); t++)
+   {
+      EXPECT_TRUE(*stats.GetNetwork().GetSnapshot(t) == *restored_stats.GetNetwork().GetSnapshot(t));
+   }
+}
+
+TEST(CheckpointTest, resumesTimeStepped)
+{
+   TurnWhenZero turning;
+   std::function<void(Model&)> setup = [](Model& m)
+      {
+         m.SetMovementRule(std::make_shared<LevyWalk>(1.5, 50));
+         m.SetNoise(0.05);
+         m.SetPDark(0.1);
+         m.SetPInteractive(0.2);
+      };
+   expect_resumes(setup, &turning, 30, 40);
+
+   std::function<void(Model&)> phases = [&](Model& m)
+      {
+         setup(m);
+         m.SetFusedStep(false);
+         m.SetThreads(2);
+      };
+   expect_resumes(phases, &turning, 30, 40);
+}
+
+TEST(CheckpointTest, resumesSinglePrecision)
+{
+   MajorityRule majority;
+   std::function<void(BasicModel<float>&)> setup = [](BasicModel<float>& m)
+      {
+         m.SetMovementRule(std::make_shared<BasicCorrelatedRandomWalk<float>>(0.3));
+         m.SetNoise(-0.05);
+      };
+   expect_resumes(setup, &majority, 20, 30);
+}
+
+TEST(CheckpointTest, resumesEventDriven)
+{
+   MajorityRule majority;
+   std::function<void(Model&)> setup = [](Model& m)
+      {
+         m.SetMovementRule(std::make_shared<LevyWalk>(1.1, 100));
+         m.SetEventDriven(true);
+      };
+   expect_resumes(setup, &majority, 25, 50);
+}
+
+TEST(CheckpointTest, checkpointsDoNotChangeTheRun)
+{
+   MajorityRule majority;
+   for(int seed = 1; seed <= 3; seed++)
+   {
+      Model saved(35, 100, 5.0, seed, 0.5), unsaved(35, 100, 5.0, seed, 0.5);
+      for(Model* m : {&saved, &unsaved})
+      {
+         m->SetMovementRule(std::make_shared<LevyWalk>(1.1, 100));
+         m->SetEventDriven(true);
+      }
+      for(int i = 0; i < 300; i++)
+      {
+         if(i % 7 == 0)
+         {
+            std::stringstream out;
+            saved.Checkpoint(out);
+         }
+         saved.Step(&majority);
+         unsaved.Step(&majority);
+      }
+      EXPECT_EQ(unsaved.GetStates(), saved.GetStates()) << "seed " << seed;
+      for(int a = 0; a < 100; a++)
+      {
+         EXPECT_EQ(unsaved.GetAgents()[a].Position(), saved.GetAgents()[a].Position());
+      }
+   }
+}
+
+TEST(CheckpointTest, resumesConvergenceOnly)
+{
+   MajorityRule majority;
+   std::function<void(Model&)> setup = [](Model& m)
+      {
+         m.SetMovementRule(std::make_shared<RandomWalk>());
+         m.RecordConvergenceOnly();
+      };
+   expect_resumes(setup, &majority, 10, 10);
+}
+
+class Spin : public MovementRule
+{
+public:
+   Heading Turn(const Point&, const Heading& heading, std::mt19937_64&) override
+      {
+         return heading + Heading(0.1);
+      }
+
+   std::shared_ptr<MovementRule> Clone() const override
+      {
+         return std::make_shared<Spin>();
+      }
+};
+
+TEST(CheckpointTest, unknownMovementRule)
+{
+   Model m(50, 20, 5.0, 1, 0.5);
+   m.SetMovementRule(std::make_shared<Spin>());
+   std::stringstream saved;
+   EXPECT_THROW(m.Checkpoint(saved), std::logic_error);
+}
+
+TEST(CheckpointTest, badCheckpoint)
+{
+   std::stringstream garbage("not a checkpoint at all");
+   EXPECT_THROW(RestoreModel(garbage), checkpoint::Error);
+
+   Model m(50, 20, 5.0, 1, 0.5);
+   std::stringstream saved;
+   m.Checkpoint(saved);
+   std::string bytes = saved.str();
+   std::stringstream truncated(bytes.substr(0, bytes.size() - 10));
+   EXPECT_THROW(RestoreModel(truncated), checkpoint::Error);
+
+   std::string old_version = bytes;
+   uint32_t version = checkpoint::VERSION - 1;
+   old_version.replace(sizeof(uint32_t), sizeof(uint32_t), reinterpret_cast<const char*>(&version), sizeof(uint32_t));
+   std::stringstream old(old_version);
+   EXPECT_THROW(RestoreModel(old), checkpoint::Error);
+}
+
+TEST(CheckpointTest, lcaCheckpointsWhileRunning)
+{
+   std::shared_ptr<Rule> majority = std::make_shared<MajorityRule>();
+   Model m(50, 200, 5.0, 97531, 0.5);
+   m.SetMovementRule(std::make_shared<LevyWalk>(2.0, 50));
+   m.SetNoise(0.02);
+
+   std::string path = testing::TempDir() + "lca_checkpoint";
+   LCA original(m, majority, 60);
+   original.SetCheckpointing(path, 25);
+   original.Run();
+
+   // the last checkpoint was taken after 50 steps
+   std::ifstream in(path, std::ios::binary);
+   ASSERT_TRUE(in);
+   LCA resumed(in, majority);
+   EXPECT_EQ(resumed.GetStats().ElapsedTime(), 51);
+   resumed.Run();
+   EXPECT_EQ(resumed.GetStats().ElapsedTime(), 61);
+   EXPECT_EQ(resumed.GetStates(), original.GetStates());
+   EXPECT_EQ(resumed.GetStats().GetDensityHistory(), original.GetStats().GetDensityHistory());
+   std::remove(path.c_str());
+
+   EXPECT_THROW(original.SetCheckpointing(path, -1), std::invalid_argument);
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "CompiledRules.hpp"
+#include "TotalisticRule.hpp"
+
+#include <sstream>
+
+TEST(CompiledRulesTest, majorityIsCompiled)
+{
+   std::shared_ptr<Rule> rule = MakeCompiledRule("majority");
+   ASSERT_NE(nullptr, rule);
+   EXPECT_TRUE(rule->CountsSufficient());
+   EXPECT_EQ(1, rule->Apply(0, {1,1,0}).first);
+   EXPECT_EQ(0, rule->Apply(1, {0,0,1}).first); // tie flips
+}
+
+TEST(CompiledRulesTest, unknownRule)
+{
+   EXPECT_EQ(nullptr, MakeCompiledRule("no-such-rule"));
+   EXPECT_EQ(nullptr, MakeCompiledRuleFromSource("@ - [0.0,1.0] -> 1, 90\n"));
+}
+
+TEST(CompiledRulesTest, lookupBySource)
+{
+   for(const CompiledRule& compiled : CompiledRules())
+   {
+      EXPECT_NE(nullptr, MakeCompiledRuleFromSource(compiled.source)) << compiled.name;
+   }
+}
+
+TEST(CompiledRulesTest, matchesInterpreter)
+{
+   ASSERT_FALSE(CompiledRules().empty());
+   for(const CompiledRule& compiled : CompiledRules())
+   {
+      TotalisticRule interpreted;
+      std::istringstream stream(compiled.source);
+      stream >> interpreted;
+      std::shared_ptr<Rule> rule = compiled.make();
+
+      for(int total = 0; total <= 40; total++)
+      {
+         for(int ones = 0; ones <= total; ones++)
+         {
+            for(int self = 0; self <= 1; self++)
+            {
+               std::pair<int, double> expected = interpreted.Apply(self, ones, total);
+               std::pair<int, double> actual   = rule->Apply(self, ones, total);
+               EXPECT_EQ(expected.first, actual.first)
+                  << compiled.name << " self=" << self << " " << ones << "/" << total;
+               EXPECT_EQ(expected.second, actual.second)
+                  << compiled.name << " self=" << self << " " << ones << "/" << total;
+            }
+         }
+      }
+
+      // three-state neighborhoods
+      for(int self = 0; self <= 2; self++)
+      {
+         for(int c0 = 0; c0 <= 6; c0++)
+         {
+            for(int c1 = 0; c1 <= 6; c1++)
+            {
+               for(int c2 = 0; c2 <= 6; c2++)
+               {
+                  int counts[3] = {c0, c1, c2};
+                  EXPECT_EQ(interpreted.Apply(self, counts, 3), rule->Apply(self, counts, 3))
+                     << compiled.name << " self=" << self << " " << c0 << "," << c1 << "," << c2;
+               }
+            }
+         }
+      }
+   }
+}
+
+TEST(CompiledRulesTest, cyclic)
+{
+   std::shared_ptr<Rule> rule = MakeCompiledRule("cyclic");
+   ASSERT_NE(nullptr, rule);
+   EXPECT_TRUE(rule->HistogramSufficient());
+   EXPECT_EQ(1, rule->Apply(0, {1,1,0}).first);
+   EXPECT_EQ(0, rule->Apply(0, {1,2,2}).first);
+   EXPECT_EQ(0, rule->Apply(2, {0,0,1}).first);
+   EXPECT_EQ(1, rule->Apply(1, {0,0,1}).first);
+}
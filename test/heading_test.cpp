@@ -78,3 +78,38 @@ TEST(HeadingTest, basicTrig)
    EXPECT_GT(0.0000001, cos(Heading(M_PI_2).Radians()));
    EXPECT_EQ(1.0, sin(Heading(M_PI_2).Radians()));
 }
+
+#ifdef FIXED_POINT_HEADING
+const double TRIG_TOLERANCE = 2*M_PI / (1 << HEADING_TRIG_TABLE_BITS);
+#else
+const double TRIG_TOLERANCE = 1e-12;
+#endif
+
+TEST(HeadingTest, cosSinMatchRadians)
+{
+   for(double h = -7.0; h < 7.0; h += 0.01)
+   {
+      Heading heading(h);
+      EXPECT_NEAR(cos(h), heading.Cos(), TRIG_TOLERANCE) << heading;
+      EXPECT_NEAR(sin(h), heading.Sin(), TRIG_TOLERANCE) << heading;
+   }
+}
+
+TEST(HeadingTest, wrapAround)
+{
+   Heading h = Heading(3*M_PI_2) + Heading(M_PI);
+   EXPECT_NEAR(M_PI_2, h.Radians(), 1e-9);
+
+   h = Heading(M_PI_2) - Heading(M_PI);
+   EXPECT_NEAR(3*M_PI_2, h.Radians(), 1e-9);
+}
+
+TEST(HeadingTest, singlePrecisionNormalized)
+{
+   for(float h : {-1e-9f, -1e-7f, 0.0f, 1e-7f, (float)(2*M_PI), -(float)(2*M_PI)})
+   {
+      BasicHeading<float> heading(h);
+      EXPECT_GE(heading.Radians(), 0.0f) << h;
+      EXPECT_LT(heading.Radians(), (float)(2*M_PI)) << h;
+   }
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include "History.hpp"
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+TEST(HistoryTest, appendsAcrossChunks)
+{
+   History<int> history;
+   std::vector<int> expected;
+   EXPECT_TRUE(history.Empty());
+   for(int i = 0; i < 3 * (int) History<int>::CHUNK + 5; i++)
+   {
+      history.Append(i * i);
+      expected.push_back(i * i);
+      ASSERT_EQ(expected.size(), history.Size());
+      ASSERT_EQ(i * i, history.Back());
+   }
+   for(size_t i = 0; i < expected.size(); i++)
+   {
+      EXPECT_EQ(expected[i], history[i]);
+   }
+   EXPECT_EQ(expected, history.Vector());
+
+   history.Clear();
+   EXPECT_EQ(0, history.Size());
+   history.Append(7);
+   EXPECT_EQ(std::vector<int>{7}, history.Vector());
+}
+
+TEST(HistoryTest, copiesAppendSeparately)
+{
+   History<int> original;
+   for(int i = 0; i < (int) History<int>::CHUNK - 1; i++)
+   {
+      original.Append(i);
+   }
+   History<int> copy = original;
+
+   // both fill the tail they had in common and go on to new chunks
+   for(int i = 0; i < 10; i++)
+   {
+      original.Append(1000 + i);
+      copy.Append(2000 + i);
+   }
+   EXPECT_EQ(History<int>::CHUNK + 9, original.Size());
+   EXPECT_EQ(History<int>::CHUNK + 9, copy.Size());
+   for(size_t i = 0; i < History<int>::CHUNK - 1; i++)
+   {
+      ASSERT_EQ(original[i], copy[i]);
+   }
+   EXPECT_EQ(1009, original.Back());
+   EXPECT_EQ(2009, copy.Back());
+   EXPECT_EQ(1000, original[History<int>::CHUNK - 1]);
+   EXPECT_EQ(2000, copy[History<int>::CHUNK - 1]);
+}
+
+TEST(HistoryTest, copiesOnSeveralThreads)
+{
+   History<int> original;
+   for(int i = 0; i < 5 * (int) History<int>::CHUNK; i++)
+   {
+      original.Append(i);
+   }
+   std::vector<std::vector<int>> appended(4);
+   std::vector<std::thread> threads;
+   for(int t = 0; t < 4; t++)
+   {
+      threads.emplace_back([&, t]()
+                           {
+                              History<int> copy = original;
+                              for(int i = 0; i < 3 * (int) History<int>::CHUNK; i++)
+                              {
+                                 copy.Append(-t);
+                              }
+                              appended[t] = copy.Vector();
+                           });
+   }
+   for(std::thread& thread : threads)
+   {
+      thread.join();
+   }
+   for(int t = 0; t < 4; t++)
+   {
+      ASSERT_EQ(8 * History<int>::CHUNK, appended[t].size());
+      EXPECT_EQ(5 * (int) History<int>::CHUNK - 1, appended[t][5 * History<int>::CHUNK - 1]);
+      EXPECT_EQ(-t, appended[t].back());
+   }
+   EXPECT_EQ(5 * History<int>::CHUNK, original.Size());
+}
+
+TEST(HistoryTest, savesAsAVector)
+{
+   History<double> history;
+   std::vector<double> values;
+   for(int i = 0; i < (int) History<double>::CHUNK + 3; i++)
+   {
+      history.Append(0.5 * i);
+      values.push_back(0.5 * i);
+   }
+   std::stringstream saved;
+   history.Save(saved);
+
+   std::vector<double> read;
+   checkpoint::ReadVector(saved, read);
+   EXPECT_EQ(values, read);
+
+   saved.seekg(0);
+   History<double> restored;
+   restored.Append(99.0);
+   restored.Restore(saved);
+   EXPECT_EQ(values, restored.Vector());
+}
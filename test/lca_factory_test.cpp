@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include "LCAFactory.hpp"
+
+#include <algorithm>
+#include <getopt.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+   std::vector<AgentState> initial_states(LCAFactory& factory)
+   {
+      return factory.Create(0.5)->GetStates();
+   }
+}
+
+TEST(LCAFactoryTest, sameSeedsInEveryRun)
+{
+   LCAFactory first, second;
+   for(int i = 0; i < 5; i++)
+   {
+      EXPECT_EQ(initial_states(first), initial_states(second));
+   }
+}
+
+TEST(LCAFactoryTest, requestsGetDifferentSeeds)
+{
+   LCAFactory factory;
+   EXPECT_NE(initial_states(factory), initial_states(factory));
+}
+
+TEST(LCAFactoryTest, concurrentCreate)
+{
+   const int num_threads = 4, per_thread = 5;
+   LCAFactory sequential;
+   std::vector<std::vector<AgentState>> expected;
+   for(int i = 0; i < num_threads * per_thread; i++)
+   {
+      expected.push_back(initial_states(sequential));
+   }
+
+   // the same models, in whatever order the threads ask for them
+   LCAFactory concurrent;
+   std::mutex mutex;
+   std::vector<std::vector<AgentState>> created;
+   std::vector<std::thread> threads;
+   for(int t = 0; t < num_threads; t++)
+   {
+      threads.emplace_back([&]()
+                           {
+                              for(int i = 0; i < per_thread; i++)
+                              {
+                                 std::vector<AgentState> states = initial_states(concurrent);
+                                 std::lock_guard<std::mutex> lock(mutex);
+                                 created.push_back(states);
+                              }
+                           });
+   }
+   for(std::thread& thread : threads)
+   {
+      thread.join();
+   }
+   std::sort(expected.begin(), expected.end());
+   std::sort(created.begin(), created.end());
+   EXPECT_EQ(expected, created);
+}
+
+TEST(LCAFactoryTest, recycledModelsRunAsNew)
+{
+   const char* args[] = {"test", "--seed", "11", "--levy", "1.5", "--pdark", "0.1"};
+   LCAFactory recycling, fresh;
+   optind = 0;
+   recycling.Init(7, const_cast<char**>(args));
+   optind = 0;
+   fresh.Init(7, const_cast<char**>(args));
+
+   std::vector<std::unique_ptr<LCA>> kept;
+   const ModelStats* previous = nullptr;
+   for(int i = 0; i < 4; i++)
+   {
+      // the recycling factory's LCA is destroyed each time
+      std::unique_ptr<LCA> lca = recycling.Create(0.4);
+      if(previous != nullptr)
+      {
+         EXPECT_EQ(previous, &lca->GetStats()) << "model not recycled";
+      }
+      previous = &lca->GetStats();
+      kept.push_back(fresh.Create(0.4));
+      lca->Run(30);
+      kept.back()->Run(30);
+      EXPECT_EQ(kept.back()->GetStates(), lca->GetStates());
+      EXPECT_EQ(kept.back()->GetStats().GetDensityHistory(), lca->GetStats().GetDensityHistory());
+   }
+}
+
+TEST(LCAFactoryTest, recycledModelsOfAGoneFactoryAreFreed)
+{
+   // a recycled model keeps its observers until it is reset
+   std::weak_ptr<Observer> observer;
+   {
+      LCAFactory gone;
+      std::unique_ptr<LCA> lca = gone.Create(0.4);
+      std::shared_ptr<Observer> degrees = std::make_shared<DegreeStats>();
+      lca->AddObserver(degrees);
+      observer = degrees;
+   }
+   EXPECT_FALSE(observer.expired()) << "model not recycled";
+
+   LCAFactory other;
+   other.Create(0.4);
+   EXPECT_TRUE(observer.expired());
+}
@@ -120,3 +120,85 @@ TEST_F(ModelStatsTest, medianAggregateDegreeNoEdges)
 {
    EXPECT_EQ(0.0, empty.MedianAggregateDegree());
 }
+
+TEST_F(ModelStatsTest, binaryStateHistories)
+{
+   EXPECT_EQ(2, stats.NumStates());
+   std::vector<double> zeros = stats.GetDensityHistory(0);
+   ASSERT_EQ(3, zeros.size());
+   EXPECT_DOUBLE_EQ(0.9, zeros[0]);
+   EXPECT_DOUBLE_EQ(0.7, zeros[2]);
+   EXPECT_EQ(stats.GetDensityHistory(), stats.GetDensityHistory(1));
+   EXPECT_EQ(std::vector<double>(3, 0.0), stats.GetDensityHistory(2));
+}
+
+TEST_F(ModelStatsTest, thirdStateAppears)
+{
+   stats.PushState({0.5, 0.25, 0.0, 0.25}, t0);
+   EXPECT_EQ(4, stats.NumStates());
+   EXPECT_EQ((std::vector<double>{0.9, 0.8, 0.7, 0.5}), stats.GetDensityHistory(0));
+   EXPECT_EQ((std::vector<double>{0.1, 0.2, 0.3, 0.25}), stats.GetDensityHistory(1));
+   EXPECT_EQ((std::vector<double>{0.0, 0.0, 0.0, 0.25}), stats.GetDensityHistory(3));
+
+   stats.PushState(1.0, t0);
+   EXPECT_EQ(0.0, stats.GetDensityHistory(3).back());
+   EXPECT_EQ(5, stats.GetDensityHistory(2).size());
+}
+
+TEST_F(ModelStatsTest, convergenceOnly)
+{
+   ModelStats convergence(10);
+   convergence.ConvergenceOnly();
+   EXPECT_FALSE(convergence.IsCorrect());
+   for(double density : {0.23, 0.0, 1.0, 0.0})
+   {
+      convergence.PushState(density, t0);
+      stats_synchronized.PushState(density, t0);
+      EXPECT_EQ(stats_synchronized.IsCorrect(), convergence.IsCorrect());
+      EXPECT_EQ(stats_synchronized.IsSynchronized(), convergence.IsSynchronized());
+   }
+   EXPECT_TRUE(convergence.IsSynchronized());
+   EXPECT_TRUE(convergence.IsCorrect());
+   EXPECT_EQ(0.0, convergence.CurrentCADensity());
+   EXPECT_EQ(4, convergence.ElapsedTime());
+   EXPECT_EQ(0, convergence.GetDensityHistory().size());
+   EXPECT_EQ(0, convergence.AggregateDensityHistory().size());
+   EXPECT_EQ(0, convergence.GetNetwork().Size());
+
+   convergence.Clear();
+   EXPECT_EQ(0, convergence.ElapsedTime());
+   convergence.PushState(0.7, t0);
+   EXPECT_EQ(0.7, convergence.CurrentCADensity());
+   EXPECT_EQ(0, convergence.GetDensityHistory().size());
+}
+
+TEST_F(ModelStatsTest, copiesRecordTheirOwnSteps)
+{
+   // long enough that the copies share full chunks
+   ModelStats original(10);
+   std::vector<double> history;
+   for(size_t t = 0; t < History<double>::CHUNK + 10; t++)
+   {
+      history.push_back(0.01 * (t % 100));
+      original.PushState(history.back(), t % 2 == 0 ? t0 : t1);
+   }
+   ModelStats copy = original;
+   EXPECT_EQ(history, copy.GetDensityHistory());
+   EXPECT_EQ(original.AggregateDensityHistory(), copy.AggregateDensityHistory());
+
+   copy.PushState(0.3, t2);
+   original.PushState(0.4, t0);
+   std::vector<double> copied = history;
+   copied.push_back(0.3);
+   history.push_back(0.4);
+   EXPECT_EQ(history, original.GetDensityHistory());
+   EXPECT_EQ(copied, copy.GetDensityHistory());
+   EXPECT_EQ(history.size(), original.GetNetwork().Size());
+   EXPECT_EQ(t0, original.GetNetwork().GetSnapshot(history.size() - 1));
+   EXPECT_EQ(t2, copy.GetNetwork().GetSnapshot(history.size() - 1));
+
+   // the copy's aggregate has t2's edges and the original's doesn't
+   EXPECT_EQ(original.AggregateDensityHistory()[history.size() - 2],
+             original.AggregateDensityHistory().back());
+   EXPECT_LT(original.AggregateDensityHistory().back(), copy.AggregateDensityHistory().back());
+}
@@ -1,7 +1,15 @@
 #include <gmock/gmock.h>
 
+#include "LCA.hpp"
 #include "Model.hpp"
 #include "Rule.hpp"
+#include "TotalisticRule.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <sstream>
 
 class ModelTest : public ::testing::Test
 {
@@ -113,6 +121,21 @@ TEST_F(ModelTest, majorityRuleUnderFullyConnectedGraph)
    EXPECT_EQ(1.0, m.CurrentDensity());
 }
 
+TEST_F(ModelTest, singlePrecisionInitialConditions)
+{
+   Model             d(100, 255, 5.0, 1234, 0.5);
+   BasicModel<float> f(100, 255, 5.0, 1234, 0.5);
+   EXPECT_EQ(d.GetStates(), f.GetStates());
+   EXPECT_EQ(*d.CurrentNetwork(), *f.CurrentNetwork());
+}
+
+TEST_F(ModelTest, singlePrecisionMajorityRule)
+{
+   BasicModel<float> m(10, 50, 20, 1234, 0.7);
+   m.Step(&majority_rule);
+   EXPECT_EQ(1.0, m.CurrentDensity());
+}
+
 TEST_F(ModelTest, alwaysOneRule)
 {
    Model m(10, 25, 1.0, 1234, 0.5);
@@ -195,3 +218,638 @@ TEST_F(ModelTest, agentSpeedHigh)
       }
    }
 }
+
+/**
+ * Majority rule that also turns agents in state 0.
+ */
+class TurningMajority : public Rule
+{
+   MajorityRule majority;
+public:
+   using Rule::Apply;
+   std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override
+      {
+         return std::make_pair(majority.Apply(self, neighbors).first, self == 0 ? 0.5 : 0.0);
+      }
+};
+
+/**
+ * Majority rule that only implements the vector-based Apply().
+ */
+class VectorMajority : public Rule
+{
+   MajorityRule majority;
+public:
+   using Rule::Apply;
+   std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override
+      {
+         return majority.Apply(self, neighbors);
+      }
+};
+
+TEST_F(ModelTest, countRuleMatchesVectorRule)
+{
+   VectorMajority vector_majority;
+   ASSERT_TRUE(majority_rule.CountsSufficient());
+   ASSERT_FALSE(vector_majority.CountsSufficient());
+   EXPECT_EQ(majority_rule.Apply(0, 2, 3), vector_majority.Apply(0, 2, 3));
+   EXPECT_EQ(majority_rule.Apply(1, 1, 3), vector_majority.Apply(1, 1, 3));
+
+   for(double noise : {0.0, 0.05, -0.05})
+   {
+      Model counts(50, 100, 5.0, 4321, 0.5);
+      Model vectors(50, 100, 5.0, 4321, 0.5);
+      counts.SetNoise(noise);
+      vectors.SetNoise(noise);
+      for(int i = 0; i < 50; i++)
+      {
+         counts.Step(&majority_rule);
+         vectors.Step(&vector_majority);
+         ASSERT_EQ(counts.GetStates(), vectors.GetStates()) << "noise " << noise << " step " << i;
+      }
+   }
+}
+
+/**
+ * Forwards the vector-based Apply() to another rule.
+ */
+class VectorOnly : public Rule
+{
+   const Rule& rule;
+public:
+   using Rule::Apply;
+   VectorOnly(const Rule& r) : rule(r) {}
+   std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override
+      {
+         return rule.Apply(self, neighbors);
+      }
+};
+
+TEST_F(ModelTest, histogramRuleMatchesVectorRule)
+{
+   TotalisticRule cyclic;
+   std::istringstream text("0 - 1:[0.4,1.0] -> 1, 0\n"
+                           "1 - 2:[0.4,1.0] -> 2, 0\n"
+                           "2 - 0:[0.4,1.0] -> 0, 0\n");
+   text >> cyclic;
+   VectorOnly vector_cyclic(cyclic);
+
+   std::mt19937 rng(99);
+   std::uniform_int_distribution<int> state(0, 2);
+   std::vector<int> initial(100);
+   for(int& s : initial) s = state(rng);
+
+   for(double noise : {0.0, 0.05, -0.05})
+   {
+      Model histogram(50, 100, 5.0, 4321, 0.5);
+      Model vectors(50, 100, 5.0, 4321, 0.5);
+      histogram.SetStates(initial);
+      vectors.SetStates(initial);
+      histogram.SetNoise(noise);
+      vectors.SetNoise(noise);
+      ASSERT_EQ(3, histogram.NumStates());
+      for(int i = 0; i < 50; i++)
+      {
+         histogram.Step(&cyclic);
+         vectors.Step(&vector_cyclic);
+         ASSERT_EQ(histogram.GetStates(), vectors.GetStates()) << "noise " << noise << " step " << i;
+      }
+   }
+}
+
+TEST_F(ModelTest, stateDensityHistory)
+{
+   Model m(50, 100, 5.0, 4321, 0.5);
+   std::vector<int> initial(100, 0);
+   std::fill(initial.begin(), initial.begin() + 20, 2);
+   std::fill(initial.begin() + 20, initial.begin() + 50, 1);
+   m.SetStates(initial);
+   EXPECT_DOUBLE_EQ(0.2, m.CurrentDensity(2));
+   EXPECT_DOUBLE_EQ(0.3, m.CurrentDensity());
+   EXPECT_DOUBLE_EQ(0.5, m.CurrentDensity(0));
+
+   Constant zero(0);
+   m.Step(&zero);
+   const ModelStats& stats = m.GetStats();
+   ASSERT_EQ(3, stats.NumStates());
+   for(int t = 0; t < 2; t++)
+   {
+      double sum = 0;
+      for(int s = 0; s < 3; s++)
+      {
+         EXPECT_EQ(2, stats.GetDensityHistory(s).size());
+         sum += stats.GetDensityHistory(s)[t];
+      }
+      EXPECT_DOUBLE_EQ(1.0, sum) << "t = " << t;
+   }
+   EXPECT_DOUBLE_EQ(0.2, stats.GetDensityHistory(2)[0]);
+   EXPECT_DOUBLE_EQ(0.0, stats.GetDensityHistory(2)[1]);
+   EXPECT_DOUBLE_EQ(1.0, stats.GetDensityHistory(0)[1]);
+
+   EXPECT_THROW(m.SetStates(std::vector<int>(100, MAX_STATES)), std::out_of_range);
+}
+
+/**
+ * Counts the neighbor states each agent observes without changing
+ * any state.
+ */
+class ObservationCounter : public Rule
+{
+public:
+   using Rule::Apply;
+   mutable long observed = 0;
+   mutable long ones     = 0;
+
+   std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override
+      {
+         return Apply(self, std::accumulate(neighbors.begin(), neighbors.end(), 0), neighbors.size());
+      }
+   std::pair<int, double> Apply(int self, int o, int total) const override
+      {
+         observed += total;
+         ones     += o;
+         return std::make_pair(self, 0.0);
+      }
+   bool CountsSufficient() const override { return true; }
+};
+
+TEST_F(ModelTest, noiseRate)
+{
+   auto run = [](double noise)
+      {
+         ObservationCounter counter;
+         Model m(50, 100, 10.0, 1234, 0.0);
+         m.SetNoise(noise);
+         for(int i = 0; i < 100; i++)
+         {
+            m.Step(&counter);
+         }
+         return counter;
+      };
+
+   ObservationCounter clean   = run(0.0);
+   ObservationCounter flipped = run(0.02);
+   ObservationCounter dropped = run(-0.02);
+   ASSERT_GT(clean.observed, 100000);
+   EXPECT_EQ(0, clean.ones);
+
+   EXPECT_EQ(clean.observed, flipped.observed);
+   EXPECT_NEAR(0.02, flipped.ones / (double)flipped.observed, 0.002);
+
+   EXPECT_EQ(0, dropped.ones);
+   EXPECT_NEAR(0.98, dropped.observed / (double)clean.observed, 0.002);
+}
+
+TEST_F(ModelTest, interactivityRates)
+{
+   Identity identity;
+   Model m(50, 1000, 5.0, 1234, 0.5);
+   m.SetPDark(0.1);
+   m.SetPInteractive(0.2);
+
+   // dark agents are never in a neighbor's count, and the dark
+   // fraction settles at p_dark / (p_dark + p_interactive)
+   double dark_fraction = 0;
+   int samples = 0;
+   for(int i = 0; i < 200; i++)
+   {
+      m.Step(&identity);
+      if(i >= 50)
+      {
+         const auto& agents = m.GetAgents();
+         dark_fraction += std::count_if(agents.begin(), agents.end(),
+                                        [](const Model::Agent& a) { return a.IsDark(); })
+            / (double)agents.size();
+         samples++;
+      }
+   }
+   EXPECT_NEAR(1.0/3.0, dark_fraction / samples, 0.01);
+
+   Model always(50, 100, 5.0, 1234, 0.5);
+   always.SetPDark(0.0);
+   for(int i = 0; i < 20; i++)
+   {
+      always.Step(&identity);
+   }
+   for(const auto& a : always.GetAgents())
+   {
+      ASSERT_TRUE(a.IsInteractive());
+   }
+}
+
+TEST_F(ModelTest, darkAgentsKeepState)
+{
+   Constant one(1);
+   Model m(50, 100, 5.0, 1234, 0.0);
+   m.SetPDark(0.5);
+   m.SetPInteractive(0.0);
+   int dark = 0;
+   for(const auto& a : m.GetAgents())
+   {
+      dark += a.IsDark();
+   }
+   ASSERT_GT(dark, 0);
+   m.Step(&one);
+   for(int a = 0; a < 100; a++)
+   {
+      EXPECT_EQ(m.GetAgents()[a].IsInteractive() ? 1 : 0, m.GetStates()[a]);
+   }
+}
+
+/**
+ * Build two identical models with setup() and check that the
+ * event-driven one follows the time-stepped one. (Copying a model
+ * would share the agents' movement rules between the two.)
+ */
+void expect_same_trajectory(std::function<Model()> setup, const Rule* rule, int steps)
+{
+   Model stepped      = setup();
+   Model event_driven = setup();
+   event_driven.SetEventDriven(true);
+
+   for(int i = 0; i < steps; i++)
+   {
+      stepped.Step(rule);
+      event_driven.Step(rule);
+      ASSERT_EQ(stepped.GetStates(), event_driven.GetStates()) << "step " << i;
+      ASSERT_TRUE(*stepped.GetStats().GetNetwork().GetSnapshot(i+1)
+                  == *event_driven.GetStats().GetNetwork().GetSnapshot(i+1)) << "step " << i;
+   }
+
+   auto& stepped_agents = stepped.GetAgents();
+   auto& event_agents   = event_driven.GetAgents();
+   for(int a = 0; a < stepped_agents.size(); a++)
+   {
+      EXPECT_TRUE(stepped_agents[a].Position().Within(1e-6, event_agents[a].Position()))
+         << stepped_agents[a].Position() << " != " << event_agents[a].Position();
+      EXPECT_EQ(stepped_agents[a].IsDark(), event_agents[a].IsDark());
+   }
+}
+
+TEST_F(ModelTest, eventDrivenLevyWalk)
+{
+   expect_same_trajectory([]() {
+                             Model m(50, 100, 5.0, 1234, 0.5);
+                             m.SetMovementRule(std::make_shared<LevyWalk>(1.5, 50));
+                             return m;
+                          }, &majority_rule, 500);
+}
+
+TEST_F(ModelTest, eventDrivenRandomWalk)
+{
+   expect_same_trajectory([]() {
+                             Model m(20, 50, 3.0, 4321, 0.5);
+                             m.SetMovementRule(std::make_shared<RandomWalk>());
+                             return m;
+                          }, &majority_rule, 200);
+}
+
+TEST_F(ModelTest, eventDrivenDarkAgents)
+{
+   expect_same_trajectory([]() {
+                             Model m(50, 100, 5.0, 99, 0.5);
+                             m.SetMovementRule(std::make_shared<LevyWalk>(1.2, 100));
+                             m.SetPDark(0.05);
+                             m.SetPInteractive(0.1);
+                             return m;
+                          }, &majority_rule, 500);
+}
+
+TEST_F(ModelTest, eventDrivenRuleTurns)
+{
+   TurningMajority turning;
+   expect_same_trajectory([]() {
+                             Model m(50, 100, 5.0, 7, 0.5);
+                             m.SetMovementRule(std::make_shared<LevyWalk>(2.0, 50));
+                             return m;
+                          }, &turning, 300);
+}
+
+TEST_F(ModelTest, eventDrivenFastAgents)
+{
+   expect_same_trajectory([]() {
+                             Model m(20, 50, 3.0, 11, 0.5, 35.0);
+                             m.SetMovementRule(std::make_shared<LevyWalk>(1.5, 20));
+                             return m;
+                          }, &majority_rule, 200);
+}
+
+TEST_F(ModelTest, threadsMatchSerial)
+{
+   TurningMajority turning;
+   VectorMajority vector_majority;
+   std::vector<const Rule*> rules = {&majority_rule, &vector_majority, &turning};
+   for(const Rule* rule : rules)
+   {
+      for(double noise : {0.0, 0.05, -0.05})
+      {
+         Model serial(40, 200, 5.0, 2468, 0.5);
+         serial.SetMovementRule(std::make_shared<LevyWalk>(1.5, 50));
+         serial.SetNoise(noise);
+         serial.SetPDark(0.05);
+         serial.SetPInteractive(0.2);
+         std::unique_ptr<ModelInterface> copy = serial.Clone();
+         Model& threaded = dynamic_cast<Model&>(*copy);
+         threaded.SetMovementRule(std::make_shared<LevyWalk>(1.5, 50));
+         threaded.SetThreads(4);
+         ASSERT_EQ(4, threaded.NumThreads());
+
+         for(int i = 0; i < 50; i++)
+         {
+            serial.Step(rule);
+            threaded.Step(rule);
+            ASSERT_EQ(serial.GetStates(), threaded.GetStates()) << "noise " << noise << " step " << i;
+            ASSERT_TRUE(*serial.GetStats().GetNetwork().GetSnapshot(i+1)
+                        == *threaded.GetStats().GetNetwork().GetSnapshot(i+1)) << "step " << i;
+         }
+         for(int a = 0; a < serial.GetAgents().size(); a++)
+         {
+            EXPECT_EQ(serial.GetAgents()[a].Position(), threaded.GetAgents()[a].Position());
+         }
+      }
+   }
+}
+
+TEST_F(ModelTest, threadsPropagateErrors)
+{
+   Constant out_of_range(MAX_STATES);
+   Model m(50, 100, 5.0, 1, 0.5);
+   m.SetThreads(3);
+   EXPECT_THROW(m.Step(&out_of_range), std::out_of_range);
+}
+
+/**
+ * Check that the fused step follows the phase-separated one.
+ */
+template<typename M>
+void expect_fused_matches_phases(std::function<void(M&)> setup, const Rule* rule, int steps,
+                                 double arena_size, int num_agents, double range)
+{
+   M phases(arena_size, num_agents, range, 1357, 0.5);
+   M fused(arena_size, num_agents, range, 1357, 0.5);
+   phases.SetFusedStep(false);
+   setup(phases);
+   setup(fused);
+   for(int i = 0; i < steps; i++)
+   {
+      phases.Step(rule);
+      fused.Step(rule);
+      ASSERT_EQ(phases.GetStates(), fused.GetStates()) << "step " << i;
+      ASSERT_TRUE(*phases.GetStats().GetNetwork().GetSnapshot(i+1)
+                  == *fused.GetStats().GetNetwork().GetSnapshot(i+1)) << "step " << i;
+      ASSERT_EQ(phases.GetStats().GetDensityHistory(), fused.GetStats().GetDensityHistory());
+      ASSERT_EQ(phases.CurrentDensity(), fused.CurrentDensity());
+   }
+   for(int a = 0; a < num_agents; a++)
+   {
+      EXPECT_EQ(phases.GetAgents()[a].Position(), fused.GetAgents()[a].Position());
+   }
+}
+
+TEST_F(ModelTest, fusedStepMatchesPhases)
+{
+   TurningMajority turning;
+   VectorMajority vector_majority;
+   for(const Rule* rule : std::vector<const Rule*>{&majority_rule, &vector_majority, &turning})
+   {
+      for(int threads : {1, 3})
+      {
+         std::function<void(Model&)> setup = [&](Model& m)
+            {
+               m.SetMovementRule(std::make_shared<LevyWalk>(1.5, 50));
+               m.SetNoise(0.05);
+               m.SetPDark(0.05);
+               m.SetPInteractive(0.2);
+               m.SetThreads(threads);
+            };
+         expect_fused_matches_phases(setup, rule, 50, 50, 200, 5.0);
+      }
+   }
+
+   // one cell; cells capped by the number of agents
+   std::function<void(Model&)> none = [](Model&) {};
+   expect_fused_matches_phases(none, &majority_rule, 20, 10, 50, 8.0);
+   expect_fused_matches_phases(none, &majority_rule, 20, 100, 30, 0.5);
+
+   // crowded cells
+   std::function<void(Model&)> random_walk = [](Model& m)
+      {
+         m.SetMovementRule(std::make_shared<RandomWalk>());
+      };
+   expect_fused_matches_phases(random_walk, &majority_rule, 50, 20, 100, 2.5);
+
+   std::function<void(BasicModel<float>&)> single = [](BasicModel<float>& m)
+      {
+         m.SetNoise(-0.05);
+      };
+   expect_fused_matches_phases(single, &majority_rule, 50, 50, 200, 5.0);
+}
+
+TEST_F(ModelTest, fusedStepStateHistogram)
+{
+   TotalisticRule cyclic;
+   std::istringstream text("0 - 1:[0.4,1.0] -> 1, 0\n"
+                           "1 - 2:[0.4,1.0] -> 2, 0\n"
+                           "2 - 0:[0.4,1.0] -> 0, 0\n");
+   text >> cyclic;
+   std::function<void(Model&)> three_states = [](Model& m)
+      {
+         std::vector<int> initial(100);
+         for(int a = 0; a < initial.size(); a++) initial[a] = a % 3;
+         m.SetStates(initial);
+         m.SetNoise(0.05);
+      };
+   expect_fused_matches_phases(three_states, &cyclic, 50, 50, 100, 5.0);
+}
+
+TEST_F(ModelTest, forkFollowsItsStream)
+{
+   Model m(50, 200, 5.0, 8642, 0.5);
+   m.SetMovementRule(std::make_shared<LevyWalk>(1.5, 50));
+   m.SetNoise(0.05);
+   m.SetPDark(0.1);
+   m.SetPInteractive(0.2);
+   for(int i = 0; i < 20; i++)
+   {
+      m.Step(&majority_rule);
+   }
+   std::unique_ptr<ModelInterface> unforked = m.Clone();
+
+   std::unique_ptr<ModelInterface> first = m.Fork(7);
+   std::unique_ptr<ModelInterface> second = m.Fork(7);
+   std::unique_ptr<ModelInterface> other = m.Fork(8);
+   EXPECT_EQ(m.GetStats().GetDensityHistory(), first->GetStats().GetDensityHistory());
+   EXPECT_EQ(m.GetStates(), first->GetStates());
+   for(int i = 0; i < 30; i++)
+   {
+      first->Step(&majority_rule);
+      second->Step(&majority_rule);
+      other->Step(&majority_rule);
+      ASSERT_EQ(first->GetStates(), second->GetStates()) << "step " << i;
+   }
+   EXPECT_EQ(first->GetStats().GetDensityHistory(), second->GetStats().GetDensityHistory());
+   EXPECT_NE(first->GetStats().GetDensityHistory(), other->GetStats().GetDensityHistory());
+   EXPECT_EQ(51, first->GetStats().ElapsedTime());
+
+   // the parent is untouched by its branches
+   EXPECT_EQ(21, m.GetStats().GetDensityHistory().size());
+   for(int i = 0; i < 30; i++)
+   {
+      m.Step(&majority_rule);
+      unforked->Step(&majority_rule);
+   }
+   EXPECT_EQ(unforked->GetStates(), m.GetStates());
+   EXPECT_EQ(unforked->GetStats().GetDensityHistory(), m.GetStats().GetDensityHistory());
+}
+
+/**
+ * Keeps every agent's state and logs the number of ones each agent
+ * observed.
+ */
+class ObservationLog : public Rule
+{
+public:
+   using Rule::Apply;
+   mutable std::vector<int> ones;
+
+   std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override
+      {
+         return Apply(self, std::accumulate(neighbors.begin(), neighbors.end(), 0), neighbors.size());
+      }
+   std::pair<int, double> Apply(int self, int o, int) const override
+      {
+         ones.push_back(o);
+         return std::make_pair(self, 0.0);
+      }
+   bool CountsSufficient() const override { return true; }
+};
+
+TEST_F(ModelTest, forksDrawTheirOwnNoise)
+{
+   // Agents that stand still and keep their states see the same
+   // neighbors in every branch, so what they observe differs only by
+   // noise. The noise is rare enough that no agent sees two noisy
+   // observations in one step, so branches that kept the parent's
+   // next noisy observations would observe the same.
+   ObservationLog parent;
+   Model m(50, 200, 5.0, 2468, 0.5, 0.0);
+   m.SetNoise(0.005);
+   for(int i = 0; i < 5; i++)
+   {
+      m.Step(&parent);
+   }
+
+   auto observe = [&](uint64_t stream)
+      {
+         ObservationLog log;
+         m.Fork(stream)->Step(&log);
+         return log.ones;
+      };
+   std::vector<int> first = observe(1);
+   EXPECT_EQ(first, observe(1));
+   for(uint64_t stream = 2; stream < 6; stream++)
+   {
+      EXPECT_NE(first, observe(stream)) << "stream " << stream;
+   }
+}
+
+TEST_F(ModelTest, perturbMidRun)
+{
+   Model m(50, 100, 5.0, 97, 0.5);
+   m.Step(&majority_rule);
+   int a = std::find(m.GetStates().begin(), m.GetStates().end(), 0) - m.GetStates().begin();
+   double density = m.CurrentDensity();
+
+   m.SetState(a, 1);
+   EXPECT_EQ(1, m.GetStates()[a]);
+   EXPECT_DOUBLE_EQ(density + 0.01, m.CurrentDensity());
+   EXPECT_EQ(2, m.GetStats().ElapsedTime());
+   m.SetState(a, 4);
+   EXPECT_EQ(5, m.NumStates());
+   EXPECT_THROW(m.SetState(a, MAX_STATES), std::out_of_range);
+   EXPECT_THROW(m.SetState(100, 0), std::out_of_range);
+
+   m.SetAgentHeading(a, Heading(1.0));
+   EXPECT_EQ(Heading(1.0), m.GetAgents()[a].GetHeading());
+   EXPECT_THROW(m.SetAgentHeading(-1, Heading(0)), std::out_of_range);
+}
+
+TEST_F(ModelTest, resetMatchesFreshModel)
+{
+   auto configure = [](Model& m, bool event_driven)
+      {
+         m.SetMovementRule(std::make_shared<LevyWalk>(1.5, 50));
+         m.SetPDark(0.1);
+         m.SetPInteractive(0.2);
+         m.SetNoise(0.05);
+         m.SetEventDriven(event_driven);
+      };
+   for(bool event_driven : {false, true})
+   {
+      Model reused(50, 100, 5.0, 13, 0.3);
+      configure(reused, event_driven);
+      reused.RecordNetworkDensityOnly();
+      reused.AddObserver(std::make_shared<DegreeStats>());
+      for(int i = 0; i < 40; i++)
+      {
+         reused.Step(&majority_rule);
+      }
+      reused.Reset(2468, 0.6);
+
+      Model fresh(50, 100, 5.0, 2468, 0.6);
+      configure(fresh, event_driven);
+      fresh.RecordNetworkDensityOnly();
+      EXPECT_EQ(fresh.GetStates(), reused.GetStates());
+      EXPECT_EQ(1, reused.GetStats().ElapsedTime());
+      for(int i = 0; i < 40; i++)
+      {
+         fresh.Step(&majority_rule);
+         reused.Step(&majority_rule);
+         ASSERT_EQ(fresh.GetStates(), reused.GetStates()) << "step " << i;
+      }
+      EXPECT_EQ(fresh.GetStats().GetDensityHistory(), reused.GetStats().GetDensityHistory());
+      EXPECT_EQ(fresh.GetStats().AggregateDensityHistory(), reused.GetStats().AggregateDensityHistory());
+      // still recording densities only, which the fresh model only
+      // started after archiving its first network
+      EXPECT_EQ(0, reused.GetStats().GetNetwork().Size());
+      for(int a = 0; a < 100; a++)
+      {
+         EXPECT_EQ(fresh.GetAgents()[a].Position(), reused.GetAgents()[a].Position());
+         EXPECT_EQ(fresh.GetAgents()[a].IsDark(), reused.GetAgents()[a].IsDark());
+      }
+   }
+}
+
+TEST_F(ModelTest, perturbLcaBranch)
+{
+   std::shared_ptr<Rule> majority = std::make_shared<MajorityRule>();
+   Model m(50, 100, 5.0, 31, 0.4);
+   LCA lca(m, majority, 60);
+   lca.Run(20);
+   std::vector<AgentState> states = lca.GetStates();
+
+   std::unique_ptr<LCA> perturbed = lca.Fork(7);
+   std::unique_ptr<LCA> control = lca.Fork(7);
+   std::unique_ptr<LCA> same = lca.Fork(7);
+   ModelInterface& model = perturbed->GetModel();
+   for(int a = 0; a < 100; a++)
+   {
+      model.SetState(a, 1 - states[a]);
+   }
+   model.SetAgentHeading(0, 1.0);
+   model.SetNoise(0.1);
+   EXPECT_THROW(model.SetState(100, 0), std::out_of_range);
+   EXPECT_THROW(model.SetAgentHeading(-1, 0.0), std::out_of_range);
+   EXPECT_DOUBLE_EQ(1.0 - lca.CurrentDensity(), perturbed->CurrentDensity());
+   EXPECT_EQ(Heading(1.0), perturbed->GetAgents()[0].GetHeading());
+
+   // neither the parent nor the other branches see the perturbation
+   EXPECT_EQ(states, lca.GetStates());
+   EXPECT_EQ(states, control->GetStates());
+   perturbed->Run();
+   control->Run();
+   same->Run();
+   EXPECT_EQ(same->GetStates(), control->GetStates());
+   EXPECT_EQ(same->GetStats().GetDensityHistory(), control->GetStats().GetDensityHistory());
+   EXPECT_NE(perturbed->GetStats().GetDensityHistory(), control->GetStats().GetDensityHistory());
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <cmath>
 
 #include "Network.hpp"
@@ -83,11 +84,11 @@ TEST_F(NetworkTest, getNeighborsNonEmpty)
       {
          if(i != j)
          {
-            EXPECT_NE(neighbors.find(j), neighbors.end());
+            EXPECT_NE(std::find(neighbors.begin(), neighbors.end(), j), neighbors.end());
          }
          else
          {
-            EXPECT_EQ(neighbors.find(j), neighbors.end());
+            EXPECT_EQ(std::find(neighbors.begin(), neighbors.end(), j), neighbors.end());
          }
       }
    }
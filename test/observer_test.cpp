@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include "Model.hpp"
+#include "Observer.hpp"
+
+#include <stdexcept>
+
+TEST(ObserverTest, densityTrackerMatchesStats)
+{
+   MajorityRule majority;
+   Model m(50, 100, 5.0, 42, 0.5);
+   auto densities = std::make_shared<DensityTracker>();
+   m.AddObserver(densities);
+   for(int i = 0; i < 20; i++)
+   {
+      m.Step(&majority);
+   }
+   EXPECT_EQ(m.GetStats().GetDensityHistory(), densities->GetDensityHistory());
+}
+
+TEST(ObserverTest, aggregateWithoutStats)
+{
+   MajorityRule majority;
+   Model full(50, 100, 5.0, 42, 0.5);
+   Model observed(50, 100, 5.0, 42, 0.5);
+   observed.RecordConvergenceOnly();
+   auto aggregate = std::make_shared<AggregateNetwork>(100);
+   observed.AddObserver(aggregate);
+   for(int i = 0; i < 20; i++)
+   {
+      full.Step(&majority);
+      observed.Step(&majority);
+   }
+   EXPECT_EQ(full.GetStats().AggregateDensityHistory(), aggregate->DensityHistory());
+   EXPECT_TRUE(observed.GetStats().AggregateDensityHistory().empty());
+}
+
+TEST(ObserverTest, sampledSnapshots)
+{
+   MajorityRule majority;
+   Model m(50, 100, 5.0, 42, 0.5);
+   auto archive = std::make_shared<SnapshotArchive>();
+   m.AddObserver(archive, 5);
+   for(int i = 0; i < 22; i++)
+   {
+      m.Step(&majority);
+   }
+   // steps 0, 5, 10, 15 and 20
+   ASSERT_EQ(5, archive->GetNetwork().Size());
+   for(int i = 0; i < 5; i++)
+   {
+      EXPECT_TRUE(*archive->GetNetwork().GetSnapshot(i) == *m.GetStats().GetNetwork().GetSnapshot(5*i));
+   }
+}
+
+TEST(ObserverTest, degreeStats)
+{
+   auto path = std::make_shared<NetworkSnapshot>(4);
+   path->AddEdge(0, 1);
+   path->AddEdge(1, 2);
+   path->AddEdge(2, 3);
+   DegreeStats degrees;
+   degrees.Observe(0, {0.5, 0.5}, path);
+   EXPECT_EQ(1.5, degrees.Mean()[0]);
+   EXPECT_EQ(0.5, degrees.StdDev()[0]);
+   EXPECT_EQ(1.5, degrees.Median()[0]);
+}
+
+TEST(ObserverTest, componentStats)
+{
+   auto network = std::make_shared<NetworkSnapshot>(6);
+   network->AddEdge(0, 1);
+   network->AddEdge(2, 3);
+   network->AddEdge(3, 4);
+   ComponentStats components;
+   components.Observe(0, {1.0, 0.0}, network);
+   network->AddEdge(1, 4);
+   components.Observe(1, {1.0, 0.0}, network);
+   EXPECT_EQ(std::vector<int>({3, 2}), components.Count());
+   EXPECT_EQ(std::vector<int>({3, 5}), components.Largest());
+}
+
+TEST(ObserverTest, badInterval)
+{
+   Model m(50, 100, 5.0, 42, 0.5);
+   EXPECT_THROW(m.AddObserver(std::make_shared<DensityTracker>(), 0), std::invalid_argument);
+}
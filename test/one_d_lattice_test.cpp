@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include "OneDLattice.hpp"
+
+#include <sstream>
+#include <string>
+
+std::string to_string(const OneDLattice& lattice)
+{
+   std::ostringstream out;
+   out << lattice;
+   return out.str();
+}
+
+/**
+ * Step the states given as a string of 0s and 1s, looking up the
+ * neighbors of every cell directly.
+ */
+std::string reference_step(const std::string& cells, int radius, const Rule& rule)
+{
+   int n = cells.size();
+   std::string next(cells);
+   for(int i = 0; i < n; i++)
+   {
+      std::vector<bool> seen(n, false);
+      std::vector<int>  neighbors;
+      for(int j = i - radius; j <= i + radius; j++)
+      {
+         int k = ((j % n) + n) % n;
+         if(k != i && !seen[k])
+         {
+            seen[k] = true;
+            neighbors.push_back(cells[k] - '0');
+         }
+      }
+      next[i] = '0' + rule.Apply(cells[i] - '0', neighbors).first;
+   }
+   return next;
+}
+
+class OneDLatticeTest : public ::testing::TestWithParam<std::pair<int,int>>
+{
+public:
+   MajorityRule majority_rule;
+};
+
+TEST_P(OneDLatticeTest, matchesReference)
+{
+   int num_cells = GetParam().first;
+   int radius    = GetParam().second;
+   OneDLattice lattice(num_cells, radius);
+   lattice.Seed(1234);
+   for(double density : {0.3, 0.5, 0.7})
+   {
+      lattice.SetDensity(density);
+      for(int i = 0; i < 10; i++)
+      {
+         std::string expected = reference_step(to_string(lattice), radius, majority_rule);
+         lattice.Step(majority_rule);
+         ASSERT_EQ(expected, to_string(lattice)) << "step " << i;
+         lattice.Shuffle();
+      }
+   }
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, OneDLatticeTest,
+                        ::testing::Values(std::make_pair(10, 1),
+                                          std::make_pair(64, 3),
+                                          std::make_pair(149, 3),
+                                          std::make_pair(200, 17),
+                                          std::make_pair(20, 10),
+                                          std::make_pair(21, 10),
+                                          std::make_pair(21, 15)));
+
+TEST(OneDLatticeStateTest, shufflePreservesDensity)
+{
+   OneDLattice lattice(1000, 2);
+   lattice.Seed(42);
+   lattice.SetDensity(0.4);
+   double density = lattice.GetDensity();
+   std::string before = to_string(lattice);
+   lattice.Shuffle();
+   EXPECT_EQ(density, lattice.GetDensity());
+   EXPECT_NE(before, to_string(lattice));
+}
+
+TEST(OneDLatticeStateTest, stopsChangingAtFixedPoint)
+{
+   MajorityRule majority_rule;
+   OneDLattice lattice(100, 3);
+   lattice.SetDensity(1.0);
+   EXPECT_TRUE(lattice.IsChanging());
+   lattice.Step(majority_rule);
+   lattice.Step(majority_rule);
+   EXPECT_FALSE(lattice.IsChanging());
+   EXPECT_EQ(1.0, lattice.GetDensity());
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "PowerLawSampler.hpp"
+
+namespace
+{
+   /**
+    * The inverse transform LevyWalk used before the step length
+    * distribution was tabulated.
+    */
+   int reference_power_law(double mu, int max_step, std::mt19937_64& gen)
+   {
+      std::uniform_real_distribution<double> u(0.0,1.0);
+      double pmin = powf(1.0, -mu+1);
+      double pmax = powf((double)max_step, -mu+1);
+      double z    = powf((pmax - pmin)*u(gen) + pmin, 1.0/(-mu+1));
+      return floor(z);
+   }
+
+   /**
+    * Two-sample chi-squared statistic over bins pooled so that each has
+    * at least 10 observations in total. Returns the statistic and sets
+    * df to the degrees of freedom.
+    */
+   double two_sample_chi_squared(const std::vector<int>& a, const std::vector<int>& b, int& df)
+   {
+      double statistic = 0.0;
+      int bins = 0;
+      long pooled_a = 0;
+      long pooled_b = 0;
+      for(int i = 0; i < a.size(); i++)
+      {
+         pooled_a += a[i];
+         pooled_b += b[i];
+         if(pooled_a + pooled_b >= 10 || i == a.size() - 1)
+         {
+            if(pooled_a + pooled_b > 0)
+            {
+               statistic += (double)(pooled_a - pooled_b) * (pooled_a - pooled_b) / (pooled_a + pooled_b);
+               bins++;
+            }
+            pooled_a = 0;
+            pooled_b = 0;
+         }
+      }
+      df = bins - 1;
+      return statistic;
+   }
+}
+
+class PowerLawSamplerTest : public ::testing::TestWithParam<std::pair<double, int>> {};
+
+TEST_P(PowerLawSamplerTest, probabilitiesSumToOne)
+{
+   PowerLawSampler sampler(GetParam().first, GetParam().second);
+   double total = 0.0;
+   for(int k = 0; k <= sampler.MaxStep() + 1; k++)
+   {
+      total += sampler.Probability(k);
+   }
+   EXPECT_NEAR(1.0, total, 1e-9);
+}
+
+TEST_P(PowerLawSamplerTest, drawsInRange)
+{
+   PowerLawSampler sampler(GetParam().first, GetParam().second);
+   std::mt19937_64 gen(1234);
+   for(int i = 0; i < 100000; i++)
+   {
+      int k = sampler(gen);
+      ASSERT_GE(k, 1);
+      ASSERT_LE(k, GetParam().second);
+   }
+}
+
+TEST_P(PowerLawSamplerTest, matchesReferenceDistribution)
+{
+   const int draws = 1000000;
+   double mu = GetParam().first;
+   int max_step = GetParam().second;
+
+   PowerLawSampler sampler(mu, max_step);
+   std::mt19937_64 gen_table(1337);
+   std::mt19937_64 gen_reference(7331);
+
+   std::vector<int> table(max_step + 1);
+   std::vector<int> reference(max_step + 1);
+   for(int i = 0; i < draws; i++)
+   {
+      table[sampler(gen_table)]++;
+      reference[reference_power_law(mu, max_step, gen_reference)]++;
+   }
+
+   int df;
+   double statistic = two_sample_chi_squared(table, reference, df);
+   // well beyond the 0.999 quantile of chi-squared(df)
+   EXPECT_LT(statistic, df + 5*sqrt(2.0*df)) << "df = " << df;
+}
+
+INSTANTIATE_TEST_SUITE_P(LevyExponents, PowerLawSamplerTest,
+                         ::testing::Values(std::make_pair(1.5, 100),
+                                           std::make_pair(2.0, 100),
+                                           std::make_pair(2.5, 1000),
+                                           std::make_pair(3.0, 50),
+                                           std::make_pair(1.1, 5000)));
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include "ReplicaLattice.hpp"
+#include "Rule.hpp"
+
+/**
+ * Step a single replica with MajorityRule, looking up the neighbors
+ * of every cell directly.
+ */
+std::vector<int> reference_majority(const std::vector<int>& cells, int radius, const MajorityRule& rule)
+{
+   int n = cells.size();
+   std::vector<int> next(n);
+   for(int i = 0; i < n; i++)
+   {
+      std::vector<bool> seen(n, false);
+      std::vector<int>  neighbors;
+      for(int j = i - radius; j <= i + radius; j++)
+      {
+         int k = ((j % n) + n) % n;
+         if(k != i && !seen[k])
+         {
+            seen[k] = true;
+            neighbors.push_back(cells[k]);
+         }
+      }
+      next[i] = rule.Apply(cells[i], neighbors).first;
+   }
+   return next;
+}
+
+class ReplicaLatticeTest : public ::testing::TestWithParam<std::pair<int,int>> {};
+
+TEST_P(ReplicaLatticeTest, replicasMatchReference)
+{
+   int num_cells = GetParam().first;
+   int radius    = GetParam().second;
+   for(bool flip : {true, false})
+   {
+      MajorityRule rule(flip);
+      ReplicaLattice lattice(num_cells, radius, flip);
+      lattice.Seed(99);
+      lattice.SetDensity(0.5);
+      for(int step = 0; step < 5; step++)
+      {
+         std::vector<std::vector<int>> expected;
+         for(int j = 0; j < ReplicaLattice::WIDTH; j++)
+         {
+            std::vector<int> states = lattice.GetStates(j);
+            bool active = (lattice.ChangingMask() >> j) & 1;
+            expected.push_back(active ? reference_majority(states, radius, rule) : states);
+         }
+         lattice.Step();
+         for(int j = 0; j < ReplicaLattice::WIDTH; j++)
+         {
+            ASSERT_EQ(expected[j], lattice.GetStates(j)) << "replica " << j << " step " << step;
+         }
+         lattice.Shuffle();
+      }
+   }
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, ReplicaLatticeTest,
+                         ::testing::Values(std::make_pair(10, 1),
+                                           std::make_pair(65, 3),
+                                           std::make_pair(149, 7),
+                                           std::make_pair(20, 10),
+                                           std::make_pair(21, 10),
+                                           std::make_pair(22, 15)));
+
+TEST(ReplicaLatticeStateTest, settledReplicasStop)
+{
+   ReplicaLattice lattice(200, 5);
+   lattice.Seed(7);
+   lattice.SetDensity(0.2);
+   int steps = 0;
+   while(lattice.IsChanging() && steps < 5000)
+   {
+      lattice.Shuffle();
+      lattice.Step();
+      steps++;
+   }
+   EXPECT_FALSE(lattice.IsChanging());
+   for(double density : lattice.GetDensities())
+   {
+      EXPECT_EQ(0.0, density);
+   }
+}
+
+TEST(ReplicaLatticeStateTest, unusedReplicasNeverChange)
+{
+   ReplicaLattice lattice(101, 3);
+   lattice.Seed(11);
+   lattice.SetDensity(0.5, 36);
+   EXPECT_EQ(((uint64_t)1 << 36) - 1, lattice.ChangingMask());
+   for(int step = 0; step < 10; step++)
+   {
+      lattice.Shuffle();
+      lattice.Step();
+      EXPECT_EQ(0u, lattice.ChangingMask() & ~(((uint64_t)1 << 36) - 1));
+   }
+   for(int j = 36; j < ReplicaLattice::WIDTH; j++)
+   {
+      EXPECT_EQ(0.0, lattice.GetDensities()[j]);
+   }
+}
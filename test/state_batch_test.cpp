@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include "Model.hpp"
+#include "StateBatch.hpp"
+#include "Rule.hpp"
+
+#include <stdexcept>
+
+std::vector<int> batch_states(const StateBatch& batch, int j)
+{
+   std::vector<int> states(batch.NumAgents());
+   for(int a = 0; a < batch.NumAgents(); a++)
+   {
+      states[a] = batch.State(j, a);
+   }
+   return states;
+}
+
+TEST(StateBatchTest, initialDensities)
+{
+   std::mt19937_64 gen(1);
+   StateBatch batch(1000, {0.0, 0.25, 1.0}, gen);
+   EXPECT_EQ(0.0, batch.InitialDensity(0));
+   EXPECT_NEAR(0.25, batch.InitialDensity(1), 0.05);
+   EXPECT_EQ(1.0, batch.InitialDensity(2));
+   EXPECT_TRUE(batch.IsConverged(0));
+   EXPECT_EQ(0, batch.ConvergenceTime(0));
+   EXPECT_FALSE(batch.IsConverged(1));
+   EXPECT_FALSE(batch.AllConverged());
+}
+
+TEST(StateBatchTest, vectorsFollowIndependentModels)
+{
+   MajorityRule majority_rule;
+   std::vector<double> densities;
+   for(int j = 0; j < 70; j++)
+   {
+      densities.push_back(j / 70.0);
+   }
+
+   Model model(50, 100, 8.0, 2468, 0.5);
+   model.SetPDark(0.1);
+   std::mt19937_64 gen(1357);
+   StateBatch batch(100, densities, gen);
+
+   // models with the same seed follow the same trajectory
+   std::vector<std::unique_ptr<Model>> references;
+   for(int j = 0; j < batch.NumVectors(); j++)
+   {
+      references.push_back(std::make_unique<Model>(50, 100, 8.0, 2468, 0.5));
+      references.back()->SetPDark(0.1);
+      references.back()->SetStates(batch_states(batch, j));
+   }
+
+   for(int step = 0; step < 40 && !batch.AllConverged(); step++)
+   {
+      model.Step(&majority_rule, batch);
+      for(int j = 0; j < batch.NumVectors(); j++)
+      {
+         references[j]->Step(&majority_rule);
+         const std::vector<AgentState>& states = references[j]->GetStates();
+         ASSERT_EQ(std::vector<int>(states.begin(), states.end()), batch_states(batch, j))
+            << "vector " << j << " step " << step;
+         ASSERT_EQ(references[j]->CurrentDensity(), batch.Density(j));
+      }
+   }
+
+   for(int j = 0; j < batch.NumVectors(); j++)
+   {
+      if(batch.IsConverged(j))
+      {
+         EXPECT_EQ(references[j]->GetStats().IsCorrect(), batch.IsCorrect(j));
+      }
+   }
+}
+
+/**
+ * Majority rule that turns agents in state 0.
+ */
+class TurningRule : public Rule
+{
+public:
+   using Rule::Apply;
+   std::pair<int, double> Apply(int self, const std::vector<int>& neighbors) const override
+      {
+         return std::make_pair(self, self == 0 ? 0.5 : 0.0);
+      }
+};
+
+TEST(StateBatchTest, rejectsStateDependentTrajectories)
+{
+   MajorityRule majority_rule;
+   TurningRule  turning_rule;
+   std::mt19937_64 gen(1);
+
+   Model turning(10, 50, 20, 1234, 0.5);
+   StateBatch batch(50, {0.3, 0.6}, gen);
+   EXPECT_THROW(turning.Step(&turning_rule, batch), std::logic_error);
+
+   Model noisy(10, 50, 20, 1234, 0.5);
+   noisy.SetNoise(0.1);
+   EXPECT_THROW(noisy.Step(&majority_rule, batch), std::logic_error);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include "LCAFactory.hpp"
+#include "Sweep.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST(SweepTest, runsEveryTaskOnce)
+{
+   for(int num_threads : {1, 2, 3, 8})
+   {
+      Sweep sweep(7, 5, num_threads);
+      std::vector<int> runs(35, 0);
+      std::vector<int> sums = sweep.Run<int>([&](int point, int replica)
+                                             {
+                                                runs[point * 5 + replica]++;
+                                                return replica;
+                                             },
+                                             [](const int& a, const int& b) { return a + b; });
+      EXPECT_EQ(std::vector<int>(35, 1), runs) << num_threads << " threads";
+      EXPECT_EQ(std::vector<int>(7, 0 + 1 + 2 + 3 + 4), sums) << num_threads << " threads";
+   }
+}
+
+TEST(SweepTest, reducesInReplicaOrder)
+{
+   std::function<std::string(int, int)> name = [](int point, int replica)
+      {
+         return std::to_string(point) + ":" + std::to_string(replica) + " ";
+      };
+   std::function<std::string(const std::string&, const std::string&)> concatenate =
+      [](const std::string& a, const std::string& b) { return a + b; };
+
+   std::vector<std::string> expected = Sweep(3, 4, 1).Run(name, concatenate);
+   EXPECT_EQ("1:0 1:1 1:2 1:3 ", expected[1]);
+   EXPECT_EQ(expected, Sweep(3, 4, 4).Run(name, concatenate));
+}
+
+TEST(SweepTest, stealsFromSlowWorkers)
+{
+   // Worker 0 is dealt the even tasks and starts on task 6, the back
+   // of its queue, which blocks until every other task has finished.
+   // They can only finish if worker 1 steals 0, 2 and 4.
+   Sweep sweep(4, 2, 2);
+   std::mutex mutex;
+   std::condition_variable finished;
+   int num_finished = 0;
+   std::vector<double> proportions = sweep.Proportion([&](int point, int replica)
+                                                      {
+                                                         std::unique_lock<std::mutex> lock(mutex);
+                                                         if(point * 2 + replica == 6)
+                                                         {
+                                                            // the timeout only stops a broken scheduler hanging the test
+                                                            EXPECT_TRUE(finished.wait_for(lock, std::chrono::seconds(10),
+                                                                                          [&] { return num_finished == 7; }));
+                                                         }
+                                                         else if(++num_finished == 7)
+                                                         {
+                                                            finished.notify_all();
+                                                         }
+                                                         return replica == 0;
+                                                      });
+   EXPECT_EQ(std::vector<double>(4, 0.5), proportions);
+   EXPECT_GE(sweep.Steals(), 3);
+}
+
+TEST(SweepTest, propagatesErrors)
+{
+   Sweep sweep(10, 10, 4);
+   EXPECT_THROW(sweep.Proportion([](int point, int replica)
+                                 {
+                                    if(point == 5 && replica == 5) throw std::runtime_error("replica failed");
+                                    return true;
+                                 }),
+                std::runtime_error);
+   EXPECT_EQ(std::vector<double>(), Sweep(0, 10, 4).Proportion([](int, int) { return true; }));
+}
+
+TEST(SweepTest, factorySeedsByTask)
+{
+   LCAFactory factory;
+   std::function<double(int, int)> run = [&](int point, int replica)
+      {
+         std::unique_ptr<LCA> lca = factory.Create(0.2 * point, point * 4 + replica);
+         lca->Run(20);
+         return lca->CurrentDensity();
+      };
+   std::function<double(const double&, const double&)> sum = [](const double& a, const double& b) { return a + b; };
+
+   std::vector<double> sequential = Sweep(5, 4, 1).Run(run, sum);
+   EXPECT_EQ(sequential, Sweep(5, 4, 4).Run(run, sum));
+   EXPECT_EQ(sequential, Sweep(5, 4, 4).Run(run, sum));
+
+   // the same models as requests made in order
+   LCAFactory in_order;
+   EXPECT_EQ(in_order.Create(0.4)->GetStates(), factory.Create(0.4, 0)->GetStates());
+   EXPECT_EQ(in_order.Create(0.4)->GetStates(), factory.Create(0.4, 1)->GetStates());
+}
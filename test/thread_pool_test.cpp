@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "ThreadPool.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(ThreadPoolTest, coversRange)
+{
+   for(int num_threads : {1, 2, 3, 8})
+   {
+      ThreadPool pool(num_threads);
+      ASSERT_EQ(num_threads, pool.NumThreads());
+      for(int size : {0, 1, 5, 1000})
+      {
+         std::vector<int> visits(size, 0);
+         std::vector<int> workers(num_threads, 0);
+         pool.ParallelFor(size, [&](int begin, int end, int worker)
+                          {
+                             workers[worker]++;
+                             for(int i = begin; i < end; i++) visits[i]++;
+                          });
+         EXPECT_EQ(std::vector<int>(size, 1), visits) << num_threads << " threads";
+         EXPECT_EQ(std::vector<int>(num_threads, 1), workers) << num_threads << " threads";
+      }
+   }
+}
+
+TEST(ThreadPoolTest, sharesInOrder)
+{
+   ThreadPool pool(4);
+   std::vector<int> begins(4), ends(4);
+   pool.ParallelFor(10, [&](int begin, int end, int worker)
+                    {
+                       begins[worker] = begin;
+                       ends[worker]   = end;
+                    });
+   EXPECT_EQ(0, begins[0]);
+   EXPECT_EQ(10, ends[3]);
+   for(int w = 1; w < 4; w++)
+   {
+      EXPECT_EQ(ends[w-1], begins[w]);
+   }
+}
+
+TEST(ThreadPoolTest, barrier)
+{
+   ThreadPool pool(4);
+   std::vector<int> values(100, 0);
+   for(int phase = 1; phase <= 50; phase++)
+   {
+      // every phase reads what other workers wrote in the last one
+      std::atomic<int> wrong(0);
+      pool.ParallelFor(values.size(), [&](int begin, int end, int worker)
+                       {
+                          for(int i = begin; i < end; i++)
+                          {
+                             if(values[(i + 37) % values.size()] != phase - 1) wrong++;
+                          }
+                       });
+      pool.ParallelFor(values.size(), [&](int begin, int end, int worker)
+                       {
+                          for(int i = begin; i < end; i++) values[i] = phase;
+                       });
+      ASSERT_EQ(0, wrong.load()) << "phase " << phase;
+   }
+}
+
+TEST(ThreadPoolTest, rethrows)
+{
+   ThreadPool pool(3);
+   EXPECT_THROW(pool.ParallelFor(30, [](int begin, int end, int worker)
+                                 {
+                                    if(worker == 2) throw std::runtime_error("share failed");
+                                 }),
+                std::runtime_error);
+
+   // still usable
+   std::atomic<int> count(0);
+   pool.ParallelFor(30, [&](int begin, int end, int worker) { count += end - begin; });
+   EXPECT_EQ(30, count.load());
+}
@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+
+#include "TotalisticRule.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <thread>
+
+TotalisticRule parse_rule(const std::string& text, int max_degree = TotalisticRule::DEFAULT_MAX_DEGREE)
+{
+   TotalisticRule rule;
+   rule.Compile(max_degree);
+   std::istringstream stream(text);
+   stream >> rule;
+   return rule;
+}
+
+const std::string MAJORITY =
+   "1 + [0.0,0.5) -> 0, 0\n"
+   "0 + [0.0,0.5) -> 0, 0\n"
+   "0 + (0.5,1.0] -> 1, 0\n"
+   "1 + (0.5,1.0] -> 1, 0\n"
+   "1 + [0.5,0.5] -> 0, 0\n"
+   "0 + [0.5,0.5] -> 1, 0\n";
+
+TEST(TotalisticRuleTest, majority)
+{
+   TotalisticRule rule = parse_rule(MAJORITY);
+   EXPECT_EQ(1, rule.Apply(0, {1,1,0}).first);
+   EXPECT_EQ(0, rule.Apply(1, {0,0,1}).first); // tie flips
+   EXPECT_EQ(1, rule.Apply(0, {0,1,1}).first); // tie flips
+   EXPECT_EQ(0, rule.Apply(1, {0,0,0,0}).first);
+}
+
+TEST(TotalisticRuleTest, firstMatchWins)
+{
+   TotalisticRule rule = parse_rule("@ - [0.0,1.0] -> 1, 90\n"
+                                    "@ - [0.0,1.0] -> 0, 0\n");
+   std::pair<int, double> result = rule.Apply(0, {0,0,1});
+   EXPECT_EQ(1, result.first);
+   EXPECT_DOUBLE_EQ(M_PI/2, result.second);
+}
+
+TEST(TotalisticRuleTest, noMatchKeepsState)
+{
+   TotalisticRule rule = parse_rule("0 - [1.0,1.0] -> 1, 0\n");
+   EXPECT_EQ(std::make_pair(1, 0.0), rule.Apply(1, {1,1}));
+   EXPECT_EQ(std::make_pair(0, 0.0), rule.Apply(0, {0,1}));
+   EXPECT_EQ(std::make_pair(1, 0.0), rule.Apply(0, {1,1}));
+   // an empty neighborhood has no density
+   EXPECT_EQ(std::make_pair(0, 0.0), rule.Apply(0, {}));
+}
+
+TEST(TotalisticRuleTest, otherStatesAreInterpreted)
+{
+   TotalisticRule rule = parse_rule("@ - (0.0,1.0) -> @, 0\n"
+                                    "@ - [0.0,1.0] -> 1, 0\n");
+   EXPECT_EQ(2, rule.Apply(2, {0,1}).first);
+   EXPECT_EQ(1, rule.Apply(2, {1,1}).first);
+}
+
+TEST(TotalisticRuleTest, lazyRowsMatchCompiledRows)
+{
+   TotalisticRule lazy     = parse_rule(MAJORITY, 0);
+   TotalisticRule compiled = parse_rule(MAJORITY, 64);
+   for(int count = 0; count <= 64; count++)
+   {
+      for(int sum = 0; sum <= count; sum++)
+      {
+         for(int self = 0; self <= 1; self++)
+         {
+            EXPECT_EQ(compiled.Apply(self, sum, count), lazy.Apply(self, sum, count))
+               << self << " " << sum << "/" << count;
+         }
+      }
+   }
+}
+
+TEST(TotalisticRuleTest, copiesShareLazyRows)
+{
+   TotalisticRule rule = parse_rule(MAJORITY, 4);
+   TotalisticRule copy(rule);
+   std::vector<int> neighbors(100, 1);
+   EXPECT_EQ(1, rule.Apply(0, neighbors).first);
+   EXPECT_EQ(1, copy.Apply(0, neighbors).first);
+}
+
+TEST(TotalisticRuleTest, concurrentLazyRows)
+{
+   // rows past the published ones are only kept under the lock
+   std::vector<int> counts;
+   for(int count = 0; count <= 4200; count += 97)
+   {
+      counts.push_back(count);
+   }
+   TotalisticRule reference = parse_rule(MAJORITY, 0);
+   std::vector<std::pair<int, double>> expected;
+   for(int count : counts)
+   {
+      for(int self = 0; self <= 1; self++)
+      {
+         expected.push_back(reference.Apply(self, count / 2, count));
+      }
+   }
+
+   TotalisticRule lazy = parse_rule(MAJORITY, 0);
+   std::vector<int> wrong(4, 0);
+   std::vector<std::thread> threads;
+   for(int t = 0; t < 4; t++)
+   {
+      threads.emplace_back([&, t]()
+                           {
+                              for(int repeat = 0; repeat < 3; repeat++)
+                              {
+                                 for(int i = 0; i < counts.size(); i++)
+                                 {
+                                    int c = (i + t * 7) % counts.size();
+                                    for(int self = 0; self <= 1; self++)
+                                    {
+                                       if(lazy.Apply(self, counts[c] / 2, counts[c]) != expected[2*c + self]) wrong[t]++;
+                                    }
+                                 }
+                              }
+                           });
+   }
+   for(std::thread& thread : threads)
+   {
+      thread.join();
+   }
+   EXPECT_EQ(std::vector<int>(4, 0), wrong);
+}
+
+TEST(TotalisticRuleTest, indexMatchesLinearSearch)
+{
+   // Many overlapping transitions whose endpoints coincide, so ties
+   // between open and closed ends are exercised.
+   std::mt19937 rng(7);
+   std::uniform_int_distribution<int> state(-1, 3);
+   std::uniform_int_distribution<int> endpoint(0, 10);
+   std::bernoulli_distribution coin(0.5);
+   std::ostringstream text;
+   std::vector<Transition> transitions;
+   for(int i = 0; i < 60; i++)
+   {
+      int pre = state(rng);
+      int lo = endpoint(rng);
+      int hi = endpoint(rng);
+      std::ostringstream line;
+      line << (pre < 0 ? "@" : std::to_string(pre)) << " "
+           << (coin(rng) ? "+" : "-") << " "
+           << (coin(rng) ? "[" : "(") << std::min(lo, hi) / 10.0 << ","
+           << std::max(lo, hi) / 10.0 << (coin(rng) ? "]" : ")")
+           << " -> " << i % 4 << ", " << i;
+      std::string str = line.str();
+      transitions.push_back(parser::parse_transition(str));
+      text << line.str() << "\n";
+   }
+   TotalisticRule rule = parse_rule(text.str(), 8);
+
+   for(int count = 0; count <= 20; count++)
+   {
+      for(int sum = 0; sum <= count; sum++)
+      {
+         for(int self = 0; self <= 4; self++)
+         {
+            std::pair<int, double> expected(self, 0.0);
+            for(const Transition& t : transitions)
+            {
+               if(!t.any_state && t.pre_state != self) continue;
+               double density = t.include_self
+                  ? (double)(sum + self) / (count + 1)
+                  : (double)sum / count;
+               if(t.range.Contains(density))
+               {
+                  expected = std::make_pair(t.result_state, t.heading_change);
+                  break;
+               }
+            }
+            EXPECT_EQ(expected, rule.Apply(self, sum, count))
+               << self << " " << sum << "/" << count;
+         }
+      }
+   }
+}
+
+TEST(TotalisticRuleTest, stateFractions)
+{
+   TotalisticRule rule = parse_rule("0 - 2:[0.5,1.0] -> 2, 0\n"
+                                    "@ + 1:(0.5,1.0] -> 1, 0\n"
+                                    "@ - [1.5,2.0] -> 0, 0\n");
+   int counts[3] = {1, 1, 2};
+   EXPECT_EQ(2, rule.Apply(0, counts, 3).first);
+   EXPECT_EQ(2, rule.Apply(0, {0,1,2,2}).first);
+   // 1 of 4 neighbors is in state 2
+   EXPECT_EQ(0, rule.Apply(0, {0,0,1,2}).first);
+   // self counts toward the fraction in state 1
+   EXPECT_EQ(1, rule.Apply(1, {0,1,2}).first);
+   EXPECT_EQ(2, rule.Apply(2, {0,1,2}).first);
+   // mean state
+   EXPECT_EQ(0, rule.Apply(2, {2,2,2,1}).first);
+   // binary neighborhoods go through the table
+   int binary[3] = {1, 3, 0};
+   EXPECT_EQ(rule.Apply(0, 3, 4), rule.Apply(0, binary, 3));
+}
+
+TEST(TotalisticRuleTest, parseDensityState)
+{
+   std::string line = "@ + 3:[0.25,0.5) -> 1, 0";
+   Transition t = parser::parse_transition(line);
+   EXPECT_EQ(3, t.density_state);
+   EXPECT_TRUE(t.any_state);
+   EXPECT_TRUE(t.include_self);
+
+   line = "1 - [0.25,0.5) -> 1, 0";
+   EXPECT_EQ(-1, parser::parse_transition(line).density_state);
+
+   line = "1 - x:[0.25,0.5) -> 1, 0";
+   EXPECT_THROW(parser::parse_transition(line), parser::ParseException);
+}